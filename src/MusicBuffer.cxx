@@ -19,18 +19,84 @@
 
 #include "MusicBuffer.hxx"
 #include "MusicChunk.hxx"
+#include "pcm/AudioFormat.hxx"
+#include "util/Compiler.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+
+/**
+ * The longest period of audio which should go into one chunk; a
+ * chunk of #CHUNK_SIZE may still be longer.
+ */
+static constexpr std::chrono::milliseconds MAX_CHUNK_DURATION{50};
+
+/**
+ * Larger chunks are only used if the buffer holds at least this
+ * number of them.
+ */
+static constexpr size_t MIN_CHUNKS = 128;
 
 MusicBuffer::MusicBuffer(unsigned num_chunks)
-	:buffer(num_chunks) {
+	:small_chunks(num_chunks),
+	 medium_chunks(std::max(num_chunks * CHUNK_SIZE / MEDIUM_CHUNK_SIZE,
+				size_t(1))),
+	 large_chunks(std::max(num_chunks * CHUNK_SIZE / MAX_CHUNK_SIZE,
+			       size_t(1))),
+	 capacity(num_chunks * CHUNK_SIZE) {
+}
+
+size_t
+MusicBuffer::GetChunkSize(const AudioFormat af) const noexcept
+{
+	if (!af.IsDefined())
+		return CHUNK_SIZE;
+
+	const size_t max_size = std::min(af.TimeToSize(MAX_CHUNK_DURATION),
+					 capacity / MIN_CHUNKS);
+
+	if (max_size >= MAX_CHUNK_SIZE)
+		return MAX_CHUNK_SIZE;
+	else if (max_size >= MEDIUM_CHUNK_SIZE)
+		return MEDIUM_CHUNK_SIZE;
+	else
+		return CHUNK_SIZE;
 }
 
 MusicChunkPtr
-MusicBuffer::Allocate() noexcept
+MusicBuffer::Allocate(size_t chunk_size) noexcept
 {
-	const std::scoped_lock<Mutex> protect(mutex);
-	return {buffer.Allocate(), MusicChunkDeleter(*this)};
+	/* reserve the budget first; Return() may run concurrently,
+	   but it can only make room */
+	if (allocated.fetch_add(chunk_size, std::memory_order_relaxed) + chunk_size > capacity) {
+		allocated.fetch_sub(chunk_size, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	MusicChunk *chunk;
+	switch (chunk_size) {
+	case CHUNK_SIZE:
+		chunk = small_chunks.Allocate();
+		break;
+
+	case MEDIUM_CHUNK_SIZE:
+		chunk = medium_chunks.Allocate();
+		break;
+
+	case MAX_CHUNK_SIZE:
+		chunk = large_chunks.Allocate();
+		break;
+
+	default:
+		assert(false);
+		gcc_unreachable();
+	}
+
+	if (chunk == nullptr)
+		allocated.fetch_sub(chunk_size, std::memory_order_relaxed);
+
+	return {chunk, MusicChunkDeleter(*this)};
 }
 
 void
@@ -38,15 +104,31 @@ MusicBuffer::Return(MusicChunk *chunk) noexcept
 {
 	assert(chunk != nullptr);
 
-	/* these attributes need to be cleared before locking the
-	   mutex, because they might recursively call this method,
-	   causing a deadlock */
-	chunk->next.reset();
-	chunk->other.reset();
+	assert(!chunk->other || !chunk->other->other);
 
-	const std::scoped_lock<Mutex> protect(mutex);
+	const size_t chunk_size = sizeof(MusicChunk) + chunk->capacity;
 
-	assert(!chunk->other || !chunk->other->other);
+	switch (chunk_size) {
+	case CHUNK_SIZE:
+		small_chunks.Free(static_cast<SmallChunk *>(chunk));
+		break;
+
+	case MEDIUM_CHUNK_SIZE:
+		medium_chunks.Free(static_cast<MediumChunk *>(chunk));
+		break;
+
+	case MAX_CHUNK_SIZE:
+		large_chunks.Free(static_cast<LargeChunk *>(chunk));
+		break;
+
+	default:
+		assert(false);
+		gcc_unreachable();
+	}
 
-	buffer.Free(chunk);
+	/* only now that the slice is back in the free list, the
+	   budget may be reused by Allocate() */
+	[[maybe_unused]] const size_t old_allocated =
+		allocated.fetch_sub(chunk_size, std::memory_order_relaxed);
+	assert(old_allocated >= chunk_size);
 }
@@ -21,61 +21,106 @@
 #define MPD_MUSIC_BUFFER_HXX
 
 #include "MusicChunkPtr.hxx"
+#include "MusicChunk.hxx"
 #include "util/SliceBuffer.hxx"
-#include "thread/Mutex.hxx"
+
+#include <atomic>
+
+struct AudioFormat;
 
 /**
  * An allocator for #MusicChunk objects.
+ *
+ * Chunks come in three sizes (#CHUNK_SIZE, 4 * #CHUNK_SIZE and
+ * #MAX_CHUNK_SIZE), which share one memory budget.  Each size has
+ * its own #SliceBuffer large enough for the whole budget; only pages
+ * which are actually used get backed with physical memory.
+ *
+ * This class is lock-free.  Allocate() must be called by only one
+ * thread at a time (the decoder thread); Return() may be called from
+ * any thread.
  */
 class MusicBuffer {
-	/** a mutex which protects #buffer */
-	mutable Mutex mutex;
+	static constexpr size_t MEDIUM_CHUNK_SIZE = 4 * CHUNK_SIZE;
+
+	using SmallChunk = SizedMusicChunk<CHUNK_SIZE>;
+	using MediumChunk = SizedMusicChunk<MEDIUM_CHUNK_SIZE>;
+	using LargeChunk = SizedMusicChunk<MAX_CHUNK_SIZE>;
+
+	SliceBuffer<SmallChunk> small_chunks;
+	SliceBuffer<MediumChunk> medium_chunks;
+	SliceBuffer<LargeChunk> large_chunks;
+
+	/**
+	 * The memory budget in bytes.
+	 */
+	const size_t capacity;
 
-	SliceBuffer<MusicChunk> buffer;
+	/**
+	 * The total size of all allocated chunks in bytes.
+	 */
+	std::atomic_size_t allocated{0};
 
 public:
 	/**
 	 * Creates a new #MusicBuffer object.
 	 *
-	 * @param num_chunks the number of #MusicChunk reserved in
-	 * this buffer
+	 * @param num_chunks the size of this buffer in units of
+	 * #CHUNK_SIZE
 	 */
 	explicit MusicBuffer(unsigned num_chunks);
 
 #ifndef NDEBUG
 	/**
-	 * Check whether the buffer is empty.  This call is not
-	 * protected with the mutex, and may only be used while this
-	 * object is inaccessible to other threads.
+	 * Check whether the buffer is empty.  This may only be used
+	 * while this object is inaccessible to other threads.
 	 */
 	bool IsEmptyUnsafe() const {
-		return buffer.empty();
+		return allocated == 0;
 	}
 #endif
 
-	bool IsFull() const noexcept {
-		const std::scoped_lock<Mutex> protect(mutex);
-		return buffer.IsFull();
+	/**
+	 * Is there no room for another chunk of the given size?
+	 */
+	bool IsFull(size_t chunk_size=CHUNK_SIZE) const noexcept {
+		return allocated.load(std::memory_order_relaxed) + chunk_size > capacity;
 	}
 
 	/**
-	 * Returns the total number of reserved chunks in this buffer.  This
-	 * is the same value which was passed to the constructor
-	 * music_buffer_new().
+	 * Returns the number of chunks of the given size which fit
+	 * into this buffer.  For #CHUNK_SIZE, this is the same value
+	 * which was passed to the constructor.
 	 */
 	[[gnu::pure]]
-	unsigned GetSize() const noexcept {
-		return buffer.GetCapacity();
+	unsigned GetSize(size_t chunk_size=CHUNK_SIZE) const noexcept {
+		return capacity / chunk_size;
 	}
 
+	/**
+	 * Choose the chunk size for the given audio format: the
+	 * largest one which holds no more than 50 ms of audio, as
+	 * long as the buffer has room for at least 128 of them.
+	 * This keeps the time span of a chunk roughly constant,
+	 * instead of pushing thousands of chunks per second through
+	 * the #MusicPipe at high byte rates.
+	 *
+	 * @param af the audio format; if it is not defined,
+	 * #CHUNK_SIZE is returned
+	 */
+	[[gnu::pure]]
+	size_t GetChunkSize(AudioFormat af) const noexcept;
+
 	/**
 	 * Allocates a chunk from the buffer.  When it is not used anymore,
 	 * call Return().
 	 *
+	 * @param chunk_size the chunk size, obtained from
+	 * GetChunkSize()
 	 * @return an empty chunk or nullptr if there are no chunks
 	 * available
 	 */
-	MusicChunkPtr Allocate() noexcept;
+	MusicChunkPtr Allocate(size_t chunk_size=CHUNK_SIZE) noexcept;
 
 	/**
 	 * Returns a chunk to the buffer.  It can be reused by
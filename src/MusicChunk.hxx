@@ -29,12 +29,25 @@
 #include "pcm/AudioFormat.hxx"
 #endif
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 
+/**
+ * The size of the smallest #MusicChunk (including its header), which
+ * is used for "ordinary" PCM.
+ */
 static constexpr size_t CHUNK_SIZE = 4096;
 
+/**
+ * The size of the largest #MusicChunk.  Streams with a high byte rate
+ * (e.g. DSD512 or multi-channel DSD) use larger chunks, to keep the
+ * number of chunks per second (and the locking and wakeups that come
+ * with each one) low; see MusicBuffer::GetChunkSize().
+ */
+static constexpr size_t MAX_CHUNK_SIZE = 65536;
+
 struct AudioFormat;
 struct Tag;
 struct MusicChunk;
@@ -43,8 +56,13 @@ struct MusicChunk;
  * Meta information for #MusicChunk.
  */
 struct MusicChunkInfo {
-	/** the next chunk in a linked list */
-	MusicChunkPtr next;
+	/**
+	 * The next chunk in the #MusicPipe.  This does not own the
+	 * chunk; the #MusicPipe does.  It is written by the
+	 * MusicPipe::Push() caller and may be read concurrently by
+	 * other threads, see GetNext().
+	 */
+	std::atomic<MusicChunk *> next{nullptr};
 
 	/**
 	 * An optional chunk which should be mixed into this chunk.
@@ -100,6 +118,15 @@ struct MusicChunkInfo {
 		return length == 0 && tag == nullptr;
 	}
 
+	/**
+	 * Returns the next chunk in the #MusicPipe, or nullptr if
+	 * this is the tail.  The next chunk's contents are
+	 * guaranteed to be visible to the caller.
+	 */
+	MusicChunk *GetNext() const noexcept {
+		return next.load(std::memory_order_acquire);
+	}
+
 #ifndef NDEBUG
 	/**
 	 * Checks if the audio format if the chunk is equal to the
@@ -116,7 +143,13 @@ struct MusicChunkInfo {
  */
 struct MusicChunk : MusicChunkInfo {
 	/** the data (probably PCM) */
-	uint8_t data[CHUNK_SIZE - sizeof(MusicChunkInfo)];
+	uint8_t *const data;
+
+	/** the size of #data in bytes */
+	const uint16_t capacity;
+
+	MusicChunk(uint8_t *_data, size_t _capacity) noexcept
+		:data(_data), capacity(_capacity) {}
 
 	/**
 	 * Prepares appending to the music chunk.  Returns a buffer
@@ -145,6 +178,31 @@ struct MusicChunk : MusicChunkInfo {
 	bool Expand(AudioFormat af, size_t length) noexcept;
 };
 
-static_assert(sizeof(MusicChunk) == CHUNK_SIZE, "Wrong size");
+/**
+ * A #MusicChunk including its data buffer, #SIZE bytes in total.
+ * This is what #MusicBuffer allocates.
+ */
+template<size_t SIZE>
+struct SizedMusicChunk : MusicChunk {
+	uint8_t buffer[SIZE - sizeof(MusicChunk)];
+
+	SizedMusicChunk() noexcept
+		:MusicChunk(buffer, sizeof(buffer)) {}
+};
+
+/**
+ * @return the number of data bytes in a #MusicChunk of the given
+ * size (see MusicBuffer::GetChunkSize())
+ */
+constexpr size_t
+GetMusicChunkCapacity(size_t chunk_size) noexcept
+{
+	return chunk_size - sizeof(MusicChunk);
+}
+
+static_assert(sizeof(SizedMusicChunk<CHUNK_SIZE>) == CHUNK_SIZE, "Wrong size");
+static_assert(sizeof(SizedMusicChunk<MAX_CHUNK_SIZE>) == MAX_CHUNK_SIZE, "Wrong size");
+static_assert(GetMusicChunkCapacity(MAX_CHUNK_SIZE) <= UINT16_MAX,
+	      "MusicChunkInfo::length is too small");
 
 #endif
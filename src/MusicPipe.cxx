@@ -21,15 +21,14 @@
 #include "MusicChunk.hxx"
 
 #include <cassert>
+#include <thread>
 
 #ifndef NDEBUG
 
 bool
 MusicPipe::Contains(const MusicChunk *chunk) const noexcept
 {
-	const std::scoped_lock<Mutex> protect(mutex);
-
-	for (const MusicChunk *i = head.get(); i != nullptr; i = i->next.get())
+	for (const MusicChunk *i = Peek(); i != nullptr; i = i->GetNext())
 		if (i == chunk)
 			return true;
 
@@ -41,32 +40,38 @@ MusicPipe::Contains(const MusicChunk *chunk) const noexcept
 MusicChunkPtr
 MusicPipe::Shift() noexcept
 {
-	const std::scoped_lock<Mutex> protect(mutex);
-
-	auto chunk = std::move(head);
-	if (chunk != nullptr) {
-		assert(!chunk->IsEmpty());
-
-		head = std::move(chunk->next);
-		--size;
+	MusicChunk *chunk = head.load(std::memory_order_acquire);
+	if (chunk == nullptr)
+		return nullptr;
 
-		if (head == nullptr) {
-			assert(size == 0);
-			assert(tail_r == &chunk->next);
+	assert(!chunk->IsEmpty());
 
-			tail_r = &head;
-		} else {
-			assert(size > 0);
-			assert(tail_r != &chunk->next);
+	MusicChunk *next = chunk->GetNext();
+	if (next == nullptr) {
+		/* this looks like the tail; try to detach it */
+		MusicChunk *expected = chunk;
+		if (tail.compare_exchange_strong(expected, nullptr,
+						 std::memory_order_acq_rel)) {
+			/* the pipe is empty now; a Push() which came
+			   after that may have already installed a new
+			   head, which must not be overwritten */
+			expected = chunk;
+			head.compare_exchange_strong(expected, nullptr,
+						     std::memory_order_acq_rel);
+			size.fetch_sub(1, std::memory_order_relaxed);
+			return {chunk, deleter};
 		}
 
-#ifndef NDEBUG
-		if (size == 0)
-			audio_format.Clear();
-#endif
+		/* a Push() has already replaced the tail, but hasn't
+		   linked the new chunk yet; this is only a few
+		   instructions away */
+		while ((next = chunk->GetNext()) == nullptr)
+			std::this_thread::yield();
 	}
 
-	return chunk;
+	head.store(next, std::memory_order_release);
+	size.fetch_sub(1, std::memory_order_relaxed);
+	return {chunk, deleter};
 }
 
 void
@@ -81,20 +86,33 @@ MusicPipe::Push(MusicChunkPtr chunk) noexcept
 	assert(!chunk->IsEmpty());
 	assert(chunk->length == 0 || chunk->audio_format.IsValid());
 
-	const std::scoped_lock<Mutex> protect(mutex);
+	if (!have_deleter) {
+		deleter = chunk.get_deleter();
+		have_deleter = true;
+	}
+
+	MusicChunk *const c = chunk.release();
+	c->next.store(nullptr, std::memory_order_relaxed);
 
-	assert(size > 0 || !audio_format.IsDefined());
-	assert(!audio_format.IsDefined() ||
-	       chunk->CheckFormat(audio_format));
+	MusicChunk *const prev = tail.exchange(c, std::memory_order_acq_rel);
 
 #ifndef NDEBUG
-	if (!audio_format.IsDefined() && chunk->length > 0)
-		audio_format = chunk->audio_format;
+	if (prev == nullptr)
+		audio_format.Clear();
+
+	assert(!audio_format.IsDefined() || c->CheckFormat(audio_format));
+
+	if (!audio_format.IsDefined() && c->length > 0)
+		audio_format = c->audio_format;
 #endif
 
-	chunk->next.reset();
-	*tail_r = std::move(chunk);
-	tail_r = &(*tail_r)->next;
+	if (prev == nullptr)
+		head.store(c, std::memory_order_release);
+	else
+		prev->next.store(c, std::memory_order_release);
 
-	++size;
+	/* count the chunk only after it has been linked, so a
+	   consumer which sees a non-empty pipe can always shift a
+	   chunk */
+	size.fetch_add(1, std::memory_order_release);
 }
@@ -21,38 +21,73 @@
 #define MPD_PIPE_H
 
 #include "MusicChunkPtr.hxx"
-#include "thread/Mutex.hxx"
 
 #ifndef NDEBUG
 #include "pcm/AudioFormat.hxx"
 #endif
 
+#include <atomic>
+
 /**
  * A queue of #MusicChunk objects.  One party appends chunks at the
  * tail, and the other consumes them from the head.
+ *
+ * This class is lock-free: Push() may run concurrently with
+ * Shift(), and any number of threads may call Peek() and GetSize()
+ * and walk the chunks with MusicChunk::GetNext() at the same time.
+ * Push() must not be called concurrently with another Push(), and
+ * Shift() (or Clear()) not with another Shift().
  */
 class MusicPipe {
 	/** the first chunk */
-	MusicChunkPtr head;
+	std::atomic<MusicChunk *> head{nullptr};
 
-	/** a pointer to the tail of the chunk */
-	MusicChunkPtr *tail_r = &head;
+	/**
+	 * The last chunk.  This is nullptr if the pipe is empty;
+	 * Shift() sets it when it removes the last chunk.
+	 */
+	std::atomic<MusicChunk *> tail{nullptr};
 
-	/** the current number of chunks */
-	unsigned size = 0;
+	/**
+	 * The current number of chunks.  Push() increments it only
+	 * after the chunk has been linked, so it never exceeds the
+	 * number of reachable chunks; a Shift() racing with that
+	 * Push() may therefore make it negative for a moment.
+	 */
+	std::atomic_int size{0};
 
-	/** a mutex which protects #head and #tail_r */
-	mutable Mutex mutex;
+	/**
+	 * The deleter of the first chunk passed to Push(); all
+	 * chunks in one pipe come from the same #MusicBuffer.  It is
+	 * written only once, before that chunk gets published, so
+	 * Shift() can read it without synchronization.
+	 */
+	MusicChunkDeleter deleter;
+
+	/**
+	 * Has #deleter been initialized?  Only used by Push().
+	 */
+	bool have_deleter = false;
 
 #ifndef NDEBUG
+	/**
+	 * The audio format of the chunks pushed since the pipe was
+	 * empty.  Only used by Push() and CheckFormat(), i.e. by
+	 * the producer.
+	 */
 	AudioFormat audio_format = AudioFormat::Undefined();
 #endif
 
 public:
+	MusicPipe() = default;
+
 	~MusicPipe() noexcept {
 		Clear();
 	}
 
+	MusicPipe(const MusicPipe &) = delete;
+	MusicPipe &operator=(const MusicPipe &) = delete;
+
 #ifndef NDEBUG
 	/**
 	 * Checks if the audio format if the chunk is equal to the specified
@@ -60,7 +95,7 @@ public:
 	 */
 	[[gnu::pure]]
 	bool CheckFormat(AudioFormat other) const noexcept {
-		return !audio_format.IsDefined() ||
+		return IsEmpty() || !audio_format.IsDefined() ||
 			audio_format == other;
 	}
 
@@ -77,8 +112,7 @@ public:
 	 */
 	[[gnu::pure]]
 	const MusicChunk *Peek() const noexcept {
-		const std::scoped_lock<Mutex> protect(mutex);
-		return head.get();
+		return head.load(std::memory_order_acquire);
 	}
 
 	/**
@@ -97,12 +131,16 @@ public:
 	void Push(MusicChunkPtr chunk) noexcept;
 
 	/**
-	 * Returns the number of chunks currently in this pipe.
+	 * Returns the number of chunks currently in this pipe.  While
+	 * Push() runs in another thread, the chunk being pushed may
+	 * not be counted yet; but all counted chunks are visible, i.e.
+	 * if this returns a non-zero value to the consumer, Shift()
+	 * will not return nullptr.
 	 */
 	[[gnu::pure]]
 	unsigned GetSize() const noexcept {
-		const std::scoped_lock<Mutex> protect(mutex);
-		return size;
+		const int value = size.load(std::memory_order_acquire);
+		return value > 0 ? unsigned(value) : 0;
 	}
 
 	[[gnu::pure]]
@@ -83,6 +83,10 @@ enum class ConfigOption {
 
 	MIXRAMP_ANALYZER,
 
+	DSD_DECIMATION,
+
+	UPDATE_THREADS,
+
 	MAX
 };
 
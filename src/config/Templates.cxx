@@ -77,6 +77,8 @@ const ConfigTemplate config_param_templates[] = {
 	{ "despotify_password", false, true },
 	{ "despotify_high_bitrate", false, true },
 	{ "mixramp_analyzer" },
+	{ "dsd_decimation" },
+	{ "update_threads" },
 };
 
 static constexpr unsigned n_config_param_templates =
@@ -25,8 +25,73 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <utility>
 
+namespace {
+
+/**
+ * The attributes of a song which are compared by a sort, extracted
+ * once per song.
+ */
+struct SortKey {
+	/**
+	 * Unused if sorting by #SORT_TAG_LAST_MODIFIED.
+	 */
+	TagSortKey tag;
+
+	std::chrono::system_clock::time_point mtime;
+
+	/**
+	 * The position in the original (unsorted) order; used to
+	 * make the sort stable.
+	 */
+	unsigned position;
+
+	SortKey(TagType sort, const LightSong &song,
+		unsigned _position) noexcept
+		:mtime(song.mtime), position(_position) {
+		if (sort != TagType(SORT_TAG_LAST_MODIFIED))
+			tag = TagSortKey(sort, song.tag);
+	}
+};
+
+}
+
+struct DatabaseVisitorHelper::SortItem {
+	SortKey key;
+
+	DetachedSong song;
+
+	SortItem(TagType sort, const LightSong &_song,
+		 const SortKey &_key) noexcept
+		:key(_key), song(_song) {
+		/* let the key point into our own copy of the tag */
+		if (sort != TagType(SORT_TAG_LAST_MODIFIED))
+			key.tag = TagSortKey(sort, song.GetTag());
+	}
+};
+
+[[gnu::pure]]
+static bool
+Less(TagType sort, bool descending,
+     const SortKey &a, const SortKey &b) noexcept
+{
+	const auto &x = descending ? b : a, &y = descending ? a : b;
+
+	if (sort == TagType(SORT_TAG_LAST_MODIFIED)) {
+		if (x.mtime != y.mtime)
+			return x.mtime < y.mtime;
+	} else {
+		if (x.tag < y.tag)
+			return true;
+		if (y.tag < x.tag)
+			return false;
+	}
+
+	return a.position < b.position;
+}
+
 DatabaseVisitorHelper::DatabaseVisitorHelper(DatabaseSelection _selection,
 					     VisitSong &visit_song) noexcept
 	:selection(std::move(_selection))
@@ -38,12 +103,13 @@ DatabaseVisitorHelper::DatabaseVisitorHelper(DatabaseSelection _selection,
 	if (selection.sort != TAG_NUM_OF_ITEM_TYPES) {
 		/* the client has asked us to sort the result; this is
 		   pretty expensive, because instead of streaming the
-		   result to the client, we need to copy it all into
-		   this std::vector, and then sort it */
+		   result to the client, we need to copy it all (or
+		   everything up to the end of the "window") into this
+		   std::vector, and then sort it */
 
 		original_visit_song = std::move(visit_song);
 		visit_song = [this](const auto &song){
-			songs.emplace_back(song);
+			AddSorted(song);
 		};
 	} else if (selection.window != RangeArg::All()) {
 		original_visit_song = std::move(visit_song);
@@ -56,6 +122,38 @@ DatabaseVisitorHelper::DatabaseVisitorHelper(DatabaseSelection _selection,
 
 DatabaseVisitorHelper::~DatabaseVisitorHelper() noexcept = default;
 
+void
+DatabaseVisitorHelper::AddSorted(const LightSong &song)
+{
+	const auto sort = selection.sort;
+	const auto descending = selection.descending;
+	const auto less = [sort, descending](const SortItem &a,
+					     const SortItem &b){
+		return Less(sort, descending, a.key, b.key);
+	};
+
+	const SortKey key(sort, song, counter++);
+
+	if (selection.window.IsOpenEnded()) {
+		songs.emplace_back(sort, song, key);
+		return;
+	}
+
+	/* with a "window", only the songs before its end are needed;
+	   keep them in a heap with the last one on top, and don't
+	   bother copying songs which would be discarded anyway */
+
+	if (songs.size() < selection.window.end) {
+		songs.emplace_back(sort, song, key);
+		std::push_heap(songs.begin(), songs.end(), less);
+	} else if (!songs.empty() &&
+		   Less(sort, descending, key, songs.front().key)) {
+		std::pop_heap(songs.begin(), songs.end(), less);
+		songs.back() = SortItem(sort, song, key);
+		std::push_heap(songs.begin(), songs.end(), less);
+	}
+}
+
 void
 DatabaseVisitorHelper::Commit()
 {
@@ -68,35 +166,24 @@ DatabaseVisitorHelper::Commit()
 	/* sort the song collection */
 	const auto sort = selection.sort;
 	const auto descending = selection.descending;
+	const auto less = [sort, descending](const SortItem &a,
+					     const SortItem &b){
+		return Less(sort, descending, a.key, b.key);
+	};
 
-	if (sort == TagType(SORT_TAG_LAST_MODIFIED))
-		std::stable_sort(songs.begin(), songs.end(),
-				 [descending](const DetachedSong &a, const DetachedSong &b){
-					 return descending
-						 ? a.GetLastModified() > b.GetLastModified()
-						 : a.GetLastModified() < b.GetLastModified();
-				 });
+	if (selection.window.IsOpenEnded())
+		/* the position makes all keys different, so this is
+		   as good as std::stable_sort() */
+		std::sort(songs.begin(), songs.end(), less);
 	else
-		std::stable_sort(songs.begin(), songs.end(),
-				 [sort, descending](const DetachedSong &a,
-						    const DetachedSong &b){
-					 return CompareTags(sort, descending,
-							    a.GetTag(),
-							    b.GetTag());
-				 });
+		std::sort_heap(songs.begin(), songs.end(), less);
 
 	/* apply the "window" */
-	if (selection.window.end < songs.size())
-		songs.erase(std::next(songs.begin(), selection.window.end),
-			    songs.end());
-
 	if (selection.window.start >= songs.size())
 		return;
 
-	songs.erase(songs.begin(),
-		    std::next(songs.begin(), selection.window.start));
-
 	/* now pass all songs to the original visitor callback */
-	for (const auto &song : songs)
-		original_visit_song((LightSong)song);
+	for (auto i = std::next(songs.begin(), selection.window.start);
+	     i != songs.end(); ++i)
+		original_visit_song((LightSong)i->song);
 }
@@ -25,8 +25,6 @@
 
 #include <vector>
 
-class DetachedSong;
-
 /**
  * This class helps implementing Database::Visit() by emulating
  * #DatabaseSelection features that the #Database implementation
@@ -39,17 +37,20 @@ class DetachedSong;
 class DatabaseVisitorHelper {
 	const DatabaseSelection selection;
 
+	struct SortItem;
+
 	/**
 	 * If the plugin can't sort, then this container will collect
-	 * all songs, sort them and report them to the visitor in
-	 * Commit().
+	 * the songs, sort them and report them to the visitor in
+	 * Commit().  With a "window", it is a heap which keeps only
+	 * the first songs up to its end.
 	 */
-	std::vector<DetachedSong> songs;
+	std::vector<SortItem> songs;
 
 	VisitSong original_visit_song;
 
 	/**
-	 * Used to emulate the "window".
+	 * Used to emulate the "window", and to make the sort stable.
 	 */
 	unsigned counter = 0;
 
@@ -65,6 +66,9 @@ public:
 	~DatabaseVisitorHelper() noexcept;
 
 	void Commit();
+
+private:
+	void AddSorted(const LightSong &song);
 };
 
 #endif
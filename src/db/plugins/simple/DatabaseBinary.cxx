@@ -0,0 +1,602 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "DatabaseBinary.hxx"
+#include "Directory.hxx"
+#include "Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "io/BufferedOutputStream.hxx"
+#include "tag/ParseName.hxx"
+#include "tag/Pool.hxx"
+#include "tag/Settings.hxx"
+#include "tag/Tag.hxx"
+#include "pcm/SampleFormat.hxx"
+#include "fs/Charset.hxx"
+#include "time/ChronoUtil.hxx"
+#include "util/RuntimeError.hxx"
+#include "util/StringView.hxx"
+#include "Version.h"
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <string.h>
+
+static constexpr char DB_BINARY_MAGIC[8] = {'M', 'P', 'D', 'D', 'B', 'B', 'I', 'N'};
+
+static constexpr uint32_t DB_BINARY_FORMAT = 1;
+
+/**
+ * Written in host byte order; a file written by a host with a
+ * different byte order is discarded (and rebuilt by the next
+ * update).
+ */
+static constexpr uint32_t DB_BINARY_BYTE_ORDER = 0x01020304;
+
+/**
+ * A record array in the file.  Offsets are relative to the start of
+ * the file; the "strings" section counts bytes.
+ */
+struct BinarySection {
+	uint64_t offset, count;
+};
+
+struct BinaryHeader {
+	char magic[sizeof(DB_BINARY_MAGIC)];
+	uint32_t format;
+	uint32_t byte_order;
+
+	/* string offsets */
+	uint32_t mpd_version;
+	uint32_t fs_charset;
+
+	/** NUL-terminated strings; offset 0 is the empty string */
+	BinarySection strings;
+
+	/** string offsets of the tag names used by #BinaryTagItem */
+	BinarySection tag_types;
+
+	/** #BinaryDirectory in pre-order, starting with the root */
+	BinarySection directories;
+
+	BinarySection songs;
+
+	/** #BinaryTagItem, each (type, value) pair only once */
+	BinarySection tag_items;
+
+	/** indices into "tag_items", referred to by #BinarySong */
+	BinarySection song_items;
+
+	BinarySection playlists;
+};
+
+/**
+ * Time stamps are in seconds since the epoch; a negative value means
+ * "unknown".
+ */
+struct BinaryDirectory {
+	int64_t mtime;
+	uint32_t name;
+
+	/** DEVICE_INARCHIVE, DEVICE_CONTAINER, DEVICE_PLAYLIST or 0 */
+	uint32_t device;
+
+	/** the number of direct children, which follow this record */
+	uint32_t n_children;
+
+	uint32_t first_song, n_songs;
+	uint32_t first_playlist, n_playlists;
+	uint32_t reserved;
+};
+
+struct BinarySong {
+	int64_t mtime;
+	uint32_t filename;
+	uint32_t target;
+	uint32_t start_ms, end_ms;
+	int32_t duration_ms;
+	uint32_t sample_rate;
+	uint32_t first_item;
+	uint16_t n_items;
+	uint8_t format, channels;
+	uint8_t has_playlist;
+	uint8_t reserved[7];
+};
+
+struct BinaryTagItem {
+	uint32_t value;
+
+	/** index into "tag_types" */
+	uint32_t type;
+};
+
+struct BinaryPlaylist {
+	int64_t mtime;
+	uint32_t name;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(BinaryHeader) == 136, "Unexpected size");
+static_assert(sizeof(BinaryDirectory) == 40, "Unexpected size");
+static_assert(sizeof(BinarySong) == 48, "Unexpected size");
+static_assert(sizeof(BinaryTagItem) == 8, "Unexpected size");
+static_assert(sizeof(BinaryPlaylist) == 16, "Unexpected size");
+
+/**
+ * All sections start at a multiple of this, which satisfies the
+ * alignment of all record types.
+ */
+static constexpr std::size_t SECTION_ALIGNMENT = 8;
+
+static int64_t
+ExportTime(std::chrono::system_clock::time_point t) noexcept
+{
+	return IsNegative(t)
+		? -1
+		: int64_t(std::chrono::system_clock::to_time_t(t));
+}
+
+[[gnu::const]]
+static bool
+IsVirtualDevice(uint64_t device) noexcept
+{
+	return device == DEVICE_INARCHIVE || device == DEVICE_CONTAINER ||
+		device == DEVICE_PLAYLIST;
+}
+
+bool
+db_is_binary(ConstBuffer<void> data) noexcept
+{
+	return data.size >= sizeof(DB_BINARY_MAGIC) &&
+		memcmp(data.data, DB_BINARY_MAGIC, sizeof(DB_BINARY_MAGIC)) == 0;
+}
+
+namespace {
+
+class BinaryDatabaseWriter {
+	std::vector<char> strings;
+
+	/**
+	 * Offsets of the strings added so far.  The keys point into
+	 * the #Directory tree and the tag pool, which remain
+	 * unmodified while the database is being saved.
+	 */
+	std::unordered_map<std::string_view, uint32_t> string_offsets;
+
+	std::vector<uint32_t> tag_types;
+	uint32_t tag_type_indices[TAG_NUM_OF_ITEM_TYPES];
+
+	std::vector<BinaryDirectory> directories;
+	std::vector<BinarySong> songs;
+	std::vector<BinaryTagItem> tag_items;
+
+	/** the pool shares one #TagItem per (type, value) pair */
+	std::unordered_map<const TagItem *, uint32_t> tag_item_indices;
+
+	std::vector<uint32_t> song_items;
+	std::vector<BinaryPlaylist> playlists;
+
+	BinaryHeader header{};
+
+public:
+	BinaryDatabaseWriter() noexcept {
+		memcpy(header.magic, DB_BINARY_MAGIC, sizeof(header.magic));
+		header.format = DB_BINARY_FORMAT;
+		header.byte_order = DB_BINARY_BYTE_ORDER;
+
+		AddString({});
+		header.mpd_version = AddString(VERSION);
+		header.fs_charset = AddString(GetFSCharset());
+
+		std::fill_n(tag_type_indices, TAG_NUM_OF_ITEM_TYPES,
+			    UINT32_MAX);
+		for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+			if (IsTagEnabled(i))
+				AddTagType(TagType(i));
+	}
+
+	void AddDirectory(const Directory &directory) noexcept;
+
+	void Write(BufferedOutputStream &os);
+
+private:
+	uint32_t AddString(std::string_view s) noexcept {
+		auto [i, inserted] = string_offsets.emplace(s, strings.size());
+		if (inserted) {
+			strings.insert(strings.end(), s.begin(), s.end());
+			strings.push_back(0);
+		}
+
+		return i->second;
+	}
+
+	uint32_t AddTagType(TagType type) noexcept {
+		uint32_t &index = tag_type_indices[type];
+		if (index == UINT32_MAX) {
+			index = tag_types.size();
+			tag_types.push_back(AddString(tag_item_names[type]));
+		}
+
+		return index;
+	}
+
+	uint32_t AddTagItem(const TagItem &item) noexcept {
+		auto [i, inserted] = tag_item_indices.emplace(&item,
+							      tag_items.size());
+		if (inserted)
+			tag_items.push_back({AddString(item.value),
+					     AddTagType(item.type)});
+
+		return i->second;
+	}
+
+	void AddSong(const Song &song) noexcept;
+
+	template<typename T>
+	void SetSection(BinarySection &section, const std::vector<T> &v,
+			uint64_t &position) noexcept {
+		position = (position + SECTION_ALIGNMENT - 1) & ~uint64_t(SECTION_ALIGNMENT - 1);
+		section.offset = position;
+		section.count = v.size();
+		position += v.size() * sizeof(T);
+	}
+
+	template<typename T>
+	static void WriteSection(BufferedOutputStream &os,
+				 const BinarySection &section,
+				 const std::vector<T> &v,
+				 uint64_t &position) {
+		static constexpr char padding[SECTION_ALIGNMENT]{};
+		os.Write(padding, section.offset - position);
+		os.Write(v.data(), v.size() * sizeof(T));
+		position = section.offset + v.size() * sizeof(T);
+	}
+};
+
+void
+BinaryDatabaseWriter::AddSong(const Song &song) noexcept
+{
+	BinarySong s{};
+	s.mtime = ExportTime(song.mtime);
+	s.filename = AddString(song.filename);
+	s.target = AddString(song.target);
+	s.start_ms = song.start_time.ToMS();
+	s.end_ms = song.end_time.ToMS();
+	s.duration_ms = song.tag.duration.count();
+	s.sample_rate = song.audio_format.sample_rate;
+	s.format = uint8_t(song.audio_format.format);
+	s.channels = song.audio_format.channels;
+	s.has_playlist = song.tag.has_playlist;
+
+	s.first_item = song_items.size();
+	s.n_items = song.tag.num_items;
+	for (const auto &item : song.tag)
+		song_items.push_back(AddTagItem(item));
+
+	songs.push_back(s);
+}
+
+void
+BinaryDatabaseWriter::AddDirectory(const Directory &directory) noexcept
+{
+	BinaryDirectory d{};
+	d.mtime = ExportTime(directory.mtime);
+	d.name = directory.IsRoot() ? 0 : AddString(directory.GetName());
+	d.device = IsVirtualDevice(directory.device)
+		? uint32_t(directory.device) : 0;
+
+	d.first_song = songs.size();
+	for (const auto &song : directory.songs)
+		AddSong(song);
+	d.n_songs = songs.size() - d.first_song;
+
+	d.first_playlist = playlists.size();
+	for (const auto &playlist : directory.playlists)
+		playlists.push_back({ExportTime(playlist.mtime),
+				     AddString(playlist.name), 0});
+	d.n_playlists = playlists.size() - d.first_playlist;
+
+	for (const auto &child : directory.children)
+		if (!child.IsMount())
+			++d.n_children;
+
+	directories.push_back(d);
+
+	for (const auto &child : directory.children)
+		if (!child.IsMount())
+			AddDirectory(child);
+}
+
+void
+BinaryDatabaseWriter::Write(BufferedOutputStream &os)
+{
+	uint64_t position = sizeof(header);
+	SetSection(header.strings, strings, position);
+	SetSection(header.tag_types, tag_types, position);
+	SetSection(header.directories, directories, position);
+	SetSection(header.songs, songs, position);
+	SetSection(header.tag_items, tag_items, position);
+	SetSection(header.song_items, song_items, position);
+	SetSection(header.playlists, playlists, position);
+
+	os.WriteT(header);
+
+	position = sizeof(header);
+	WriteSection(os, header.strings, strings, position);
+	WriteSection(os, header.tag_types, tag_types, position);
+	WriteSection(os, header.directories, directories, position);
+	WriteSection(os, header.songs, songs, position);
+	WriteSection(os, header.tag_items, tag_items, position);
+	WriteSection(os, header.song_items, song_items, position);
+	WriteSection(os, header.playlists, playlists, position);
+}
+
+template<typename T>
+struct BinaryArray {
+	const T *data = nullptr;
+	std::size_t size = 0;
+
+	const T &operator[](std::size_t i) const {
+		if (i >= size)
+			throw std::runtime_error("Database corrupted");
+		return data[i];
+	}
+
+	/**
+	 * Check that [first, first+n) is a valid range.
+	 */
+	void CheckRange(uint64_t first, uint64_t n) const {
+		if (first > size || n > size - first)
+			throw std::runtime_error("Database corrupted");
+	}
+};
+
+class BinaryDatabaseReader {
+	ConstBuffer<uint8_t> data;
+	BinaryHeader header;
+
+	BinaryArray<char> strings;
+	BinaryArray<uint32_t> tag_types;
+	BinaryArray<BinaryDirectory> directories;
+	BinaryArray<BinarySong> songs;
+	BinaryArray<BinaryTagItem> tag_items;
+	BinaryArray<uint32_t> song_items;
+	BinaryArray<BinaryPlaylist> playlists;
+
+	/**
+	 * The #TagType of each entry of "tag_types";
+	 * #TAG_NUM_OF_ITEM_TYPES if items of this type are not loaded.
+	 */
+	std::vector<TagType> tag_type_map;
+
+	/**
+	 * The pool item of each "tag_items" entry, obtained when it
+	 * is first needed; further references to it only increment
+	 * its reference counter.
+	 */
+	std::vector<TagItem *> pool_items;
+
+	std::size_t next_directory = 1;
+
+public:
+	explicit BinaryDatabaseReader(ConstBuffer<void> _data);
+
+	void Load(Directory &root) {
+		LoadDirectory(root, directories[0]);
+	}
+
+private:
+	template<typename T>
+	BinaryArray<T> GetSection(const BinarySection &section) const {
+		static_assert(alignof(T) <= SECTION_ALIGNMENT);
+
+		if (section.offset % SECTION_ALIGNMENT != 0 ||
+		    section.offset > data.size ||
+		    section.count > (data.size - section.offset) / sizeof(T))
+			throw std::runtime_error("Database corrupted");
+
+		return {(const T *)(data.data + section.offset),
+			std::size_t(section.count)};
+	}
+
+	const char *GetString(uint32_t offset) const {
+		/* the last byte of the table is a null terminator,
+		   see constructor */
+		return &strings[offset];
+	}
+
+	TagItem *GetTagItem(uint32_t i);
+
+	void LoadTag(Tag &tag, const BinarySong &s);
+	void LoadSong(Directory &directory, const BinarySong &s);
+	void LoadDirectory(Directory &directory, const BinaryDirectory &d);
+};
+
+BinaryDatabaseReader::BinaryDatabaseReader(ConstBuffer<void> _data)
+	:data(ConstBuffer<uint8_t>::FromVoid(_data))
+{
+	if (data.size < sizeof(header))
+		throw std::runtime_error("Database corrupted");
+
+	memcpy(&header, data.data, sizeof(header));
+	if (header.format != DB_BINARY_FORMAT ||
+	    header.byte_order != DB_BINARY_BYTE_ORDER)
+		throw std::runtime_error("Database format mismatch, "
+					 "discarding database file");
+
+	strings = GetSection<char>(header.strings);
+	if (strings.size == 0 || strings.data[strings.size - 1] != 0)
+		throw std::runtime_error("Database corrupted");
+
+	tag_types = GetSection<uint32_t>(header.tag_types);
+	directories = GetSection<BinaryDirectory>(header.directories);
+	songs = GetSection<BinarySong>(header.songs);
+	tag_items = GetSection<BinaryTagItem>(header.tag_items);
+	song_items = GetSection<uint32_t>(header.song_items);
+	playlists = GetSection<BinaryPlaylist>(header.playlists);
+
+	const char *new_charset = GetString(header.fs_charset);
+	const char *const old_charset = GetFSCharset();
+	if (*old_charset != 0 && strcmp(new_charset, old_charset) != 0)
+		throw FormatRuntimeError("Existing database has charset "
+					 "\"%s\" instead of \"%s\"; "
+					 "discarding database file",
+					 new_charset, old_charset);
+
+	bool tags[TAG_NUM_OF_ITEM_TYPES]{};
+	tag_type_map.reserve(tag_types.size);
+	for (std::size_t i = 0; i < tag_types.size; ++i) {
+		const char *name = GetString(tag_types.data[i]);
+		TagType tag = tag_name_parse(name);
+		if (tag == TAG_NUM_OF_ITEM_TYPES)
+			throw FormatRuntimeError("Unrecognized tag '%s', "
+						 "discarding database file",
+						 name);
+
+		tags[tag] = true;
+		tag_type_map.push_back(IsTagEnabled(tag)
+				       ? tag : TAG_NUM_OF_ITEM_TYPES);
+	}
+
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+		if (IsTagEnabled(i) && !tags[i])
+			throw std::runtime_error("Tag list mismatch, "
+						 "discarding database file");
+
+	pool_items.resize(tag_items.size);
+}
+
+TagItem *
+BinaryDatabaseReader::GetTagItem(uint32_t i)
+{
+	const auto &t = tag_items[i];
+	TagItem *&item = pool_items[i];
+	if (item != nullptr)
+		return tag_pool_dup_item(item);
+
+	if (t.type >= tag_type_map.size())
+		throw std::runtime_error("Database corrupted");
+
+	const TagType type = tag_type_map[t.type];
+	if (type == TAG_NUM_OF_ITEM_TYPES)
+		return nullptr;
+
+	const char *value = GetString(t.value);
+	if (*value == 0)
+		return nullptr;
+
+	return item = tag_pool_get_item(type, value);
+}
+
+void
+BinaryDatabaseReader::LoadTag(Tag &tag, const BinarySong &s)
+{
+	tag.duration = SignedSongTime::FromMS(s.duration_ms);
+	tag.has_playlist = s.has_playlist;
+
+	if (s.n_items == 0)
+		return;
+
+	song_items.CheckRange(s.first_item, s.n_items);
+	const uint32_t *indices = song_items.data + s.first_item;
+
+	tag.items = new TagItem *[s.n_items];
+
+	for (unsigned i = 0; i < s.n_items; ++i) {
+		TagItem *item = GetTagItem(indices[i]);
+		if (item != nullptr)
+			tag.items[tag.num_items++] = item;
+	}
+}
+
+void
+BinaryDatabaseReader::LoadSong(Directory &directory, const BinarySong &s)
+{
+	auto song = std::make_unique<Song>(GetString(s.filename), directory);
+	song->target = GetString(s.target);
+
+	if (s.mtime >= 0)
+		song->mtime = std::chrono::system_clock::from_time_t(s.mtime);
+
+	song->start_time = SongTime::FromMS(s.start_ms);
+	song->end_time = SongTime::FromMS(s.end_ms);
+
+	song->audio_format.sample_rate = s.sample_rate;
+	/* the byte comes from the file; don't let a corrupt value
+	   into the enum */
+	const auto format = SampleFormat(s.format);
+	song->audio_format.format = audio_valid_sample_format(format)
+		? format
+		: SampleFormat::UNDEFINED;
+	song->audio_format.channels = s.channels;
+
+	LoadTag(song->tag, s);
+
+	directory.AddSong(std::move(song));
+}
+
+void
+BinaryDatabaseReader::LoadDirectory(Directory &directory,
+				    const BinaryDirectory &d)
+{
+	songs.CheckRange(d.first_song, d.n_songs);
+	for (uint32_t i = 0; i < d.n_songs; ++i)
+		LoadSong(directory, songs.data[d.first_song + i]);
+
+	playlists.CheckRange(d.first_playlist, d.n_playlists);
+	for (uint32_t i = 0; i < d.n_playlists; ++i) {
+		const auto &p = playlists.data[d.first_playlist + i];
+		PlaylistInfo pi(GetString(p.name));
+		if (p.mtime >= 0)
+			pi.mtime = std::chrono::system_clock::from_time_t(p.mtime);
+		directory.playlists.push_back(std::move(pi));
+	}
+
+	for (uint32_t i = 0; i < d.n_children; ++i) {
+		const auto &c = directories[next_directory++];
+
+		Directory *child = directory.CreateChild(GetString(c.name));
+		child->device = c.device;
+		if (c.mtime > 0)
+			child->mtime = std::chrono::system_clock::from_time_t(c.mtime);
+
+		LoadDirectory(*child, c);
+	}
+}
+
+} // anonymous namespace
+
+void
+db_save_binary(BufferedOutputStream &os, const Directory &root)
+{
+	BinaryDatabaseWriter writer;
+	writer.AddDirectory(root);
+	writer.Write(os);
+}
+
+void
+db_load_binary(ConstBuffer<void> data, Directory &root)
+{
+	BinaryDatabaseReader reader(data);
+
+	const ScopeDatabaseLock protect;
+	reader.Load(root);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DATABASE_BINARY_HXX
+#define MPD_DATABASE_BINARY_HXX
+
+#include "util/ConstBuffer.hxx"
+
+struct Directory;
+class BufferedOutputStream;
+
+/**
+ * Does the given file contents start like a binary database file
+ * written by db_save_binary()?
+ */
+[[gnu::pure]]
+bool
+db_is_binary(ConstBuffer<void> data) noexcept;
+
+/**
+ * Write the database in the binary format: a string table, fixed
+ * size directory, song and tag item records referring to it by
+ * offset, all in host byte order and suitably aligned, so that the
+ * file can be used in place after mapping it into memory.  Unlike
+ * the text format, it is never compressed.
+ */
+void
+db_save_binary(BufferedOutputStream &os, const Directory &root);
+
+/**
+ * Load a database written by db_save_binary() from the (mapped) file
+ * contents.  Strings and tag items are taken from the mapping as the
+ * records refer to them, without any parsing.
+ *
+ * Throws #std::runtime_error on error.
+ */
+void
+db_load_binary(ConstBuffer<void> data, Directory &root);
+
+#endif
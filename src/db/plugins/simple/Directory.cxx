@@ -22,6 +22,7 @@
 #include "SongSort.hxx"
 #include "Song.hxx"
 #include "Mount.hxx"
+#include "TagIndex.hxx"
 #include "db/LightDirectory.hxx"
 #include "db/Uri.hxx"
 #include "db/DatabaseLock.hxx"
@@ -52,7 +53,13 @@ Directory::~Directory() noexcept
 		mounted_database.reset();
 	}
 
-	songs.clear_and_dispose(DeleteDisposer());
+	TagIndex *const index = GetTagIndex();
+	songs.clear_and_dispose([index](Song *song){
+		if (index != nullptr)
+			index->Remove(*song);
+		delete song;
+	});
+
 	children.clear_and_dispose(DeleteDisposer());
 }
 
@@ -179,7 +186,13 @@ Directory::AddSong(SongPtr song) noexcept
 	assert(song != nullptr);
 	assert(&song->parent == this);
 
-	songs.push_back(*song.release());
+	auto &s = *song.release();
+	songs.push_back(s);
+
+	/* after adding it to the list, so the index can find it as
+	   the target of other songs */
+	if (auto *index = GetTagIndex())
+		index->Add(s);
 }
 
 SongPtr
@@ -189,10 +202,37 @@ Directory::RemoveSong(Song *song) noexcept
 	assert(song != nullptr);
 	assert(&song->parent == this);
 
+	if (auto *index = GetTagIndex())
+		index->Remove(*song);
+
 	songs.erase(songs.iterator_to(*song));
 	return SongPtr(song);
 }
 
+void
+Directory::ReindexSong(Song &song) noexcept
+{
+	assert(holding_db_lock());
+	assert(&song.parent == this);
+
+	if (auto *index = GetTagIndex()) {
+		/* the song gets a new id; its old one is stale in
+		   all posting lists */
+		index->Remove(song);
+		index->Add(song);
+	}
+}
+
+TagIndex *
+Directory::GetTagIndex() const noexcept
+{
+	const Directory *directory = this;
+	while (directory->parent != nullptr)
+		directory = directory->parent;
+
+	return directory->tag_index;
+}
+
 const Song *
 Directory::FindSong(std::string_view name_utf8) const noexcept
 {
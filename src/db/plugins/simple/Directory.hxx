@@ -51,6 +51,7 @@ static constexpr unsigned DEVICE_CONTAINER = -2;
 static constexpr unsigned DEVICE_PLAYLIST = -3;
 
 class SongFilter;
+class TagIndex;
 
 struct Directory {
 	static constexpr auto link_mode = boost::intrusive::normal_link;
@@ -105,6 +106,13 @@ struct Directory {
 	 */
 	DatabasePtr mounted_database;
 
+	/**
+	 * The index of all songs in this tree, kept up to date by
+	 * AddSong() and RemoveSong().  Only used in the root
+	 * directory; may be nullptr.
+	 */
+	TagIndex *tag_index = nullptr;
+
 public:
 	Directory(std::string &&_path_utf8, Directory *_parent) noexcept;
 	~Directory() noexcept;
@@ -287,6 +295,14 @@ public:
 	 */
 	SongPtr RemoveSong(Song *song) noexcept;
 
+	/**
+	 * Update the #TagIndex after the tag of a song in this
+	 * directory has been modified.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void ReindexSong(Song &song) noexcept;
+
 	/**
 	 * Caller must lock the #db_mutex.
 	 */
@@ -299,6 +315,13 @@ public:
 	 */
 	void Sort() noexcept;
 
+	/**
+	 * Returns the #TagIndex of the tree this directory belongs to
+	 * (or nullptr if there is none).
+	 */
+	[[gnu::pure]]
+	TagIndex *GetTagIndex() const noexcept;
+
 	/**
 	 * Caller must lock #db_mutex.
 	 */
@@ -23,6 +23,7 @@
 #include "Mount.hxx"
 #include "db/DatabasePlugin.hxx"
 #include "db/Selection.hxx"
+#include "song/Filter.hxx"
 #include "db/Helpers.hxx"
 #include "db/Stats.hxx"
 #include "db/UniqueTags.hxx"
@@ -31,9 +32,11 @@
 #include "Directory.hxx"
 #include "Song.hxx"
 #include "DatabaseSave.hxx"
+#include "DatabaseBinary.hxx"
 #include "db/DatabaseLock.hxx"
 #include "db/DatabaseError.hxx"
 #include "fs/io/TextFile.hxx"
+#include "fs/io/MappedFile.hxx"
 #include "io/BufferedOutputStream.hxx"
 #include "io/FileOutputStream.hxx"
 #include "fs/FileInfo.hxx"
@@ -43,6 +46,8 @@
 #include "util/Domain.hxx"
 #include "util/ConstBuffer.hxx"
 #include "util/RecursiveMap.hxx"
+#include "util/RuntimeError.hxx"
+#include "util/StringAPI.hxx"
 #include "Log.hxx"
 
 #ifdef ENABLE_ZLIB
@@ -51,15 +56,30 @@
 
 #include <cerrno>
 #include <memory>
+#include <unordered_set>
+#include <vector>
 
 static constexpr Domain simple_db_domain("simple_db");
 
+static bool
+ParseFormat(const char *format)
+{
+	if (StringIsEqual(format, "binary"))
+		return true;
+	else if (StringIsEqual(format, "text"))
+		return false;
+	else
+		throw FormatRuntimeError("Unknown database format: %s",
+					 format);
+}
+
 inline SimpleDatabase::SimpleDatabase(const ConfigBlock &block)
 	:Database(simple_db_plugin),
 	 path(block.GetPath("path")),
 #ifdef ENABLE_ZLIB
 	 compress(block.GetBlockValue("compress", true)),
 #endif
+	 binary(ParseFormat(block.GetBlockValue("format", "binary"))),
 	 hide_playlist_targets(block.GetBlockValue("hide_playlist_targets", true)),
 	 cache_path(block.GetPath("cache_directory"))
 {
@@ -73,13 +93,14 @@ inline SimpleDatabase::SimpleDatabase(AllocatedPath &&_path,
 #ifndef ENABLE_ZLIB
 				      [[maybe_unused]]
 #endif
-				      bool _compress) noexcept
+				      bool _compress, bool _binary) noexcept
 	:Database(simple_db_plugin),
 	 path(std::move(_path)),
 	 path_utf8(path.ToUTF8()),
 #ifdef ENABLE_ZLIB
 	 compress(_compress),
 #endif
+	 binary(_binary),
 	 cache_path(nullptr)
 {
 }
@@ -151,17 +172,29 @@ SimpleDatabase::Load()
 	assert(!path.IsNull());
 	assert(root != nullptr);
 
-	TextFile file(path);
-
 	LogDebug(simple_db_domain, "reading DB");
 
-	db_load_internal(file, *root);
+	if (!LoadBinary()) {
+		TextFile file(path);
+		db_load_internal(file, *root);
+	}
 
 	FileInfo fi;
 	if (GetFileInfo(path, fi))
 		mtime = fi.GetModificationTime();
 }
 
+bool
+SimpleDatabase::LoadBinary()
+{
+	const MappedFile file(path);
+	if (!db_is_binary(file.GetData()))
+		return false;
+
+	db_load_binary(file.GetData(), *root);
+	return true;
+}
+
 void
 SimpleDatabase::Open()
 {
@@ -185,6 +218,9 @@ SimpleDatabase::Open()
 
 		root = Directory::NewRoot();
 	}
+
+	const ScopeDatabaseLock protect;
+	tag_index.Build(*root);
 }
 
 void
@@ -194,6 +230,11 @@ SimpleDatabase::Close() noexcept
 	assert(prefixed_light_song == nullptr);
 	assert(borrowed_song_count == 0);
 
+	/* the songs don't need to be removed from the index one by
+	   one */
+	root->tag_index = nullptr;
+	tag_index.Clear();
+
 	delete root;
 }
 
@@ -306,10 +347,13 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 		if (selection.recursive && visit_directory)
 			visit_directory(r.directory->Export());
 
-		r.directory->Walk(selection.recursive, selection.filter,
-				  hide_playlist_targets,
-				  visit_directory, visit_song,
-				  visit_playlist);
+		if (!selection.recursive || selection.filter == nullptr ||
+		    visit_directory || !visit_song || visit_playlist ||
+		    !VisitIndexed(*r.directory, *selection.filter, visit_song))
+			r.directory->Walk(selection.recursive, selection.filter,
+					  hide_playlist_targets,
+					  visit_directory, visit_song,
+					  visit_playlist);
 		helper.Commit();
 		return;
 	}
@@ -332,6 +376,74 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 			    "No such directory");
 }
 
+/**
+ * Walk the marked directories and visit the candidate songs in them,
+ * see SimpleDatabase::VisitIndexed().
+ */
+static void
+WalkCandidates(const Directory &directory,
+	       const std::unordered_set<const Directory *> &directories,
+	       const std::unordered_set<const Song *> &songs,
+	       const SongFilter &filter, bool hide_playlist_targets,
+	       const VisitSong &visit_song)
+{
+	for (const auto &song : directory.songs) {
+		if (songs.find(&song) == songs.end() ||
+		    (hide_playlist_targets && song.in_playlist))
+			continue;
+
+		const auto song2 = song.Export();
+		if (filter.Match(song2))
+			visit_song(song2);
+	}
+
+	for (const auto &child : directory.children)
+		if (directories.find(&child) != directories.end())
+			WalkCandidates(child, directories, songs,
+				       filter, hide_playlist_targets,
+				       visit_song);
+}
+
+bool
+SimpleDatabase::VisitIndexed(const Directory &directory,
+			     const SongFilter &filter,
+			     const VisitSong &visit_song) const
+{
+	if (mount_count > 0)
+		return false;
+
+	const auto candidates = tag_index.Lookup(filter);
+	if (!candidates ||
+	    /* with this many candidates, a plain walk is cheaper */
+	    candidates->size() * 4 > tag_index.GetSongCount())
+		return false;
+
+	/* mark the directories between the given one and the
+	   candidates, skipping candidates outside of it */
+	std::unordered_set<const Directory *> directories;
+	std::unordered_set<const Song *> songs;
+	std::vector<const Directory *> chain;
+	for (const Song *song : *candidates) {
+		const Directory *d = &song->parent;
+		chain.clear();
+		while (d != nullptr && d != &directory &&
+		       directories.find(d) == directories.end()) {
+			chain.push_back(d);
+			d = d->parent;
+		}
+
+		if (d == nullptr)
+			continue;
+
+		directories.insert(chain.begin(), chain.end());
+		songs.insert(song);
+	}
+
+	WalkCandidates(directory, directories, songs,
+		       filter, hide_playlist_targets, visit_song);
+	return true;
+}
+
 RecursiveMap<std::string>
 SimpleDatabase::CollectUniqueTags(const DatabaseSelection &selection,
 				  ConstBuffer<TagType> tag_types) const
@@ -366,7 +478,9 @@ SimpleDatabase::Save()
 
 #ifdef ENABLE_ZLIB
 	std::unique_ptr<GzipOutputStream> gzip;
-	if (compress) {
+	if (compress && !binary) {
+		/* the binary format is meant to be mapped, not
+		   decompressed */
 		gzip = std::make_unique<GzipOutputStream>(*os);
 		os = gzip.get();
 	}
@@ -374,7 +488,10 @@ SimpleDatabase::Save()
 
 	BufferedOutputStream bos(*os);
 
-	db_save_internal(bos, *root);
+	if (binary)
+		db_save_binary(bos, *root);
+	else
+		db_save_internal(bos, *root);
 
 	bos.Flush();
 
@@ -415,6 +532,7 @@ SimpleDatabase::Mount(const char *uri, DatabasePtr db)
 
 	Directory *mnt = r.directory->CreateChild(r.rest);
 	mnt->mounted_database = std::move(db);
+	++mount_count;
 }
 
 static constexpr bool
@@ -445,7 +563,7 @@ SimpleDatabase::Mount(const char *local_uri, const char *storage_uri)
 	constexpr bool compress = false;
 #endif
 	auto db = std::make_unique<SimpleDatabase>(cache_path / name_fs,
-						   compress);
+						   compress, binary);
 	db->Open();
 
 	bool exists = db->FileExists();
@@ -467,6 +585,9 @@ SimpleDatabase::LockUmountSteal(const char *uri) noexcept
 	auto db = std::move(r.directory->mounted_database);
 	r.directory->Delete();
 
+	assert(mount_count > 0);
+	--mount_count;
+
 	return db;
 }
 
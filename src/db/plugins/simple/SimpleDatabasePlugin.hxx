@@ -21,6 +21,7 @@
 #define MPD_SIMPLE_DATABASE_PLUGIN_HXX
 
 #include "ExportedSong.hxx"
+#include "TagIndex.hxx"
 #include "db/Interface.hxx"
 #include "db/Ptr.hxx"
 #include "fs/AllocatedPath.hxx"
@@ -35,6 +36,7 @@ struct DatabasePlugin;
 class EventLoop;
 class DatabaseListener;
 class PrefixedLightSong;
+class SongFilter;
 
 class SimpleDatabase : public Database {
 	AllocatedPath path;
@@ -44,6 +46,13 @@ class SimpleDatabase : public Database {
 	bool compress;
 #endif
 
+	/**
+	 * Save the database in the binary format (see
+	 * db_save_binary())?  If false, the text format is used.
+	 * Loading accepts both.
+	 */
+	bool binary;
+
 	bool hide_playlist_targets;
 
 	/**
@@ -53,6 +62,19 @@ class SimpleDatabase : public Database {
 
 	Directory *root;
 
+	/**
+	 * Speeds up filtered Visit() calls; see
+	 * VisitIndexed().
+	 */
+	TagIndex tag_index;
+
+	/**
+	 * The number of databases mounted with Mount().  The
+	 * #tag_index does not cover them, so it is not used while
+	 * this is non-zero.
+	 */
+	unsigned mount_count = 0;
+
 	std::chrono::system_clock::time_point mtime;
 
 	/**
@@ -72,7 +94,8 @@ class SimpleDatabase : public Database {
 
 public:
 	SimpleDatabase(const ConfigBlock &block);
-	SimpleDatabase(AllocatedPath &&_path, bool _compress) noexcept;
+	SimpleDatabase(AllocatedPath &&_path, bool _compress,
+		       bool _binary) noexcept;
 
 	static DatabasePtr Create(EventLoop &main_event_loop,
 				  EventLoop &io_event_loop,
@@ -144,7 +167,30 @@ private:
 	 */
 	void Load();
 
+	/**
+	 * Load the database file if it is in the binary format.
+	 *
+	 * Throws #std::runtime_error on error.
+	 *
+	 * @return false if the file is not in the binary format
+	 */
+	bool LoadBinary();
+
 	DatabasePtr LockUmountSteal(const char *uri) noexcept;
+
+	/**
+	 * Visit the songs below the given directory which match the
+	 * filter, looking up the candidates in the #tag_index
+	 * instead of checking every song.  The songs are visited in
+	 * the same order as Directory::Walk() would.
+	 *
+	 * Caller must lock the #db_mutex.
+	 *
+	 * @return false if the index cannot be used for this filter
+	 */
+	bool VisitIndexed(const Directory &directory,
+			  const SongFilter &filter,
+			  const VisitSong &visit_song) const;
 };
 
 extern const DatabasePlugin simple_db_plugin;
@@ -103,12 +103,18 @@ FindTargetSong(const Directory &_directory, StringView target) noexcept
 	return directory->FindSong(last);
 }
 
-ExportedSong
-Song::Export() const noexcept
+const Song *
+Song::LookupTarget() const noexcept
 {
-	const auto *target_song = !target.empty()
+	return !target.empty()
 		? FindTargetSong(parent, (std::string_view)target)
 		: nullptr;
+}
+
+ExportedSong
+Song::Export() const noexcept
+{
+	const auto *target_song = LookupTarget();
 
 	Tag merged_tag;
 	if (target_song != nullptr) {
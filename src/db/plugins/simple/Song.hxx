@@ -28,6 +28,7 @@
 
 #include <boost/intrusive/list.hpp>
 
+#include <cstdint>
 #include <string>
 
 struct StringView;
@@ -107,6 +108,14 @@ struct Song {
 	 */
 	bool in_playlist = false;
 
+	/**
+	 * The id of this song in the #TagIndex, or TagIndex::NO_ID
+	 * if it is not indexed.
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	uint32_t index_id = ~uint32_t{};
+
 	template<typename F>
 	Song(F &&_filename, Directory &_parent) noexcept
 		:parent(_parent), filename(std::forward<F>(_filename)) {}
@@ -157,6 +166,17 @@ struct Song {
 	[[gnu::pure]]
 	std::string GetURI() const noexcept;
 
+	/**
+	 * Look up the song this one points to with its #target.
+	 *
+	 * Caller must lock the #db_mutex.
+	 *
+	 * @return the song or nullptr if there is no #target or if it
+	 * is not in the database
+	 */
+	[[gnu::pure]]
+	const Song *LookupTarget() const noexcept;
+
 	[[gnu::pure]]
 	ExportedSong Export() const noexcept;
 };
@@ -0,0 +1,421 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "TagIndex.hxx"
+#include "Directory.hxx"
+#include "Song.hxx"
+#include "song/Filter.hxx"
+#include "song/AndSongFilter.hxx"
+#include "song/TagSongFilter.hxx"
+#include "tag/Fallback.hxx"
+#include "lib/icu/CaseFold.hxx"
+#include "util/CharUtil.hxx"
+#include "util/StringCompare.hxx"
+#include "util/UTF8.hxx"
+
+#ifdef HAVE_ICU_CASE_FOLD
+#include "util/AllocatedString.hxx"
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+/**
+ * Can case-insensitive filters be looked up in the index?  This
+ * requires that equal strings (as compared by #IcuCompare) fold to
+ * the same key, which is not the case with the Windows API.
+ */
+#if defined(HAVE_ICU_CASE_FOLD) || !defined(_WIN32)
+static constexpr bool index_fold_case = true;
+#else
+static constexpr bool index_fold_case = false;
+#endif
+
+/**
+ * Convert a tag value to its key in the index.  This is the same
+ * folding #IcuCompare applies, so a case-insensitive match of two
+ * strings implies equal keys.
+ */
+static std::string
+Fold(std::string_view src) noexcept
+{
+#ifdef HAVE_ICU_CASE_FOLD
+	return IcuCaseFold(src).c_str();
+#else
+	std::string result(src);
+	std::transform(result.begin(), result.end(), result.begin(),
+		       [](char ch){ return ToLowerASCII(ch); });
+	return result;
+#endif
+}
+
+/**
+ * The last path component of a Song::target, i.e. the name of the
+ * target song in its directory.
+ */
+[[gnu::pure]]
+static std::string_view
+GetTargetName(std::string_view target) noexcept
+{
+	const auto slash = target.rfind('/');
+	return slash == target.npos
+		? target
+		: target.substr(slash + 1);
+}
+
+void
+TagIndex::Build(Directory &root) noexcept
+{
+	assert(root.IsRoot());
+
+	Clear();
+
+	FoldCache cache;
+	BuildDirectory(root, cache);
+
+	root.tag_index = this;
+}
+
+void
+TagIndex::BuildDirectory(Directory &directory, FoldCache &cache) noexcept
+{
+	for (auto &song : directory.songs)
+		Add(song, &cache);
+
+	for (auto &child : directory.children)
+		BuildDirectory(child, cache);
+}
+
+void
+TagIndex::Clear() noexcept
+{
+	for (auto &i : tags)
+		i.clear();
+
+	for (Song *song : songs)
+		if (song != nullptr)
+			song->index_id = NO_ID;
+
+	songs.clear();
+	linked.clear();
+	targets.clear();
+	unresolved.clear();
+	n_removed = 0;
+}
+
+void
+TagIndex::Add(Song &song, FoldCache *cache) noexcept
+{
+	assert(song.index_id == NO_ID);
+
+	const uint32_t id = songs.size();
+	songs.push_back(&song);
+	song.index_id = id;
+
+	if (!song.target.empty())
+		Link(id, song);
+
+	LinkUnresolved(id, song);
+
+	for (const auto &item : song.tag) {
+		PostingList *list;
+		if (cache != nullptr) {
+			auto &cached = (*cache)[&item];
+			if (cached == nullptr)
+				cached = &tags[item.type][Fold(item.value)];
+			list = cached;
+		} else
+			list = &tags[item.type][Fold(item.value)];
+
+		/* a song may have the same value more than once */
+		if (list->empty() || list->back() != id)
+			list->push_back(id);
+	}
+}
+
+void
+TagIndex::Remove(Song &song) noexcept
+{
+	if (song.index_id == NO_ID)
+		return;
+
+	assert(song.index_id < songs.size());
+	assert(songs[song.index_id] == &song);
+
+	const uint32_t id = song.index_id;
+
+	if (!song.target.empty())
+		Unlink(id, song);
+
+	/* the songs linked to this one need to wait for a new target
+	   song */
+	if (auto i = linked.find(id); i != linked.end()) {
+		for (uint32_t l : i->second) {
+			targets.erase(l);
+			unresolved.emplace(GetTargetName(songs[l]->target), l);
+		}
+
+		linked.erase(i);
+	}
+
+	songs[id] = nullptr;
+	song.index_id = NO_ID;
+	++n_removed;
+
+	if (n_removed >= 1024 && n_removed * 2 >= songs.size())
+		Compact();
+}
+
+void
+TagIndex::Link(uint32_t id, const Song &song) noexcept
+{
+	const Song *target = song.LookupTarget();
+	if (target != nullptr && target->index_id != NO_ID &&
+	    target->index_id != id) {
+		linked[target->index_id].push_back(id);
+		targets.emplace(id, target->index_id);
+	} else
+		unresolved.emplace(GetTargetName(song.target), id);
+}
+
+void
+TagIndex::Unlink(uint32_t id, const Song &song) noexcept
+{
+	if (auto t = targets.find(id); t != targets.end()) {
+		auto l = linked.find(t->second);
+		assert(l != linked.end());
+
+		auto &list = l->second;
+		list.erase(std::find(list.begin(), list.end(), id));
+		if (list.empty())
+			linked.erase(l);
+
+		targets.erase(t);
+		return;
+	}
+
+	auto [begin, end] = unresolved.equal_range(std::string(GetTargetName(song.target)));
+	for (auto i = begin; i != end; ++i) {
+		if (i->second == id) {
+			unresolved.erase(i);
+			break;
+		}
+	}
+}
+
+void
+TagIndex::LinkUnresolved(uint32_t id, const Song &song) noexcept
+{
+	auto [begin, end] = unresolved.equal_range(song.filename);
+	for (auto i = begin; i != end;) {
+		const uint32_t l = i->second;
+		if (songs[l]->LookupTarget() == &song) {
+			linked[id].push_back(l);
+			targets.emplace(l, id);
+			i = unresolved.erase(i);
+		} else
+			++i;
+	}
+}
+
+void
+TagIndex::Compact() noexcept
+{
+	/* renumber the remaining songs; the new ids are in the same
+	   order as the old ones, so the posting lists stay sorted */
+	std::vector<uint32_t> new_ids(songs.size(), NO_ID);
+	uint32_t n = 0;
+	for (std::size_t i = 0; i < songs.size(); ++i) {
+		Song *song = songs[i];
+		if (song == nullptr)
+			continue;
+
+		new_ids[i] = n;
+		song->index_id = n;
+		songs[n++] = song;
+	}
+
+	songs.resize(n);
+	n_removed = 0;
+
+	const auto Renumber = [&new_ids](PostingList &list){
+		auto dest = list.begin();
+		for (uint32_t id : list)
+			if (new_ids[id] != NO_ID)
+				*dest++ = new_ids[id];
+		list.erase(dest, list.end());
+	};
+
+	decltype(linked) new_linked;
+	for (auto &[target, list] : linked) {
+		Renumber(list);
+		new_linked.emplace(new_ids[target], std::move(list));
+	}
+
+	linked = std::move(new_linked);
+
+	targets.clear();
+	for (const auto &[target, list] : linked)
+		for (uint32_t l : list)
+			targets.emplace(l, target);
+
+	for (auto &i : unresolved)
+		i.second = new_ids[i.second];
+
+	for (auto &map : tags) {
+		for (auto i = map.begin(); i != map.end();) {
+			auto &list = i->second;
+			Renumber(list);
+
+			if (list.empty())
+				i = map.erase(i);
+			else
+				++i;
+		}
+	}
+}
+
+void
+TagIndex::Collect(TagType type, const std::string &key, bool prefix,
+		  PostingList &dest) const
+{
+	const auto &map = tags[type];
+
+	if (!prefix) {
+		auto i = map.find(key);
+		if (i != map.end())
+			dest.insert(dest.end(),
+				    i->second.begin(), i->second.end());
+		return;
+	}
+
+	for (auto i = map.lower_bound(key);
+	     i != map.end() && StringStartsWith(i->first.c_str(), key.c_str());
+	     ++i)
+		dest.insert(dest.end(), i->second.begin(), i->second.end());
+}
+
+std::optional<TagIndex::PostingList>
+TagIndex::Lookup(const TagSongFilter &filter) const
+{
+	/* negated filters and empty values match songs which do not
+	   have the tag at all, and the index only knows which songs
+	   do */
+	if (filter.IsNegated() || filter.IsRegex() ||
+	    filter.GetValue().empty() ||
+	    filter.GetPosition() == StringFilter::Position::ANYWHERE ||
+	    (filter.GetFoldCase() && !index_fold_case) ||
+	    /* a prefix which ends in the middle of a multi-byte
+	       sequence would not be a prefix after folding */
+	    !ValidateUTF8(filter.GetValue().c_str()))
+		return std::nullopt;
+
+	const bool prefix =
+		filter.GetPosition() == StringFilter::Position::PREFIX;
+	const std::string key = Fold(filter.GetValue());
+
+	PostingList result;
+
+	const TagType type = filter.GetTagType();
+	if (type == TAG_NUM_OF_ITEM_TYPES) {
+		for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+			Collect(TagType(i), key, prefix, result);
+	} else
+		/* a song may match through a fallback tag (only if it
+		   lacks the specified one, but that will be checked
+		   by the filter later) */
+		ApplyTagWithFallback(type, [&](TagType t){
+			Collect(t, key, prefix, result);
+			return false;
+		});
+
+	/* songs which match with the tags of their target */
+	if (!linked.empty()) {
+		const auto n = result.size();
+		for (std::size_t i = 0; i < n; ++i) {
+			auto l = linked.find(result[i]);
+			if (l != linked.end())
+				result.insert(result.end(),
+					      l->second.begin(),
+					      l->second.end());
+		}
+	}
+
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+std::optional<TagIndex::PostingList>
+TagIndex::Lookup(const ISongFilter &filter) const
+{
+	if (const auto *t = dynamic_cast<const TagSongFilter *>(&filter))
+		return Lookup(*t);
+
+	if (const auto *a = dynamic_cast<const AndSongFilter *>(&filter))
+		return LookupAnd(a->GetItems());
+
+	return std::nullopt;
+}
+
+std::optional<TagIndex::PostingList>
+TagIndex::LookupAnd(const std::list<ISongFilterPtr> &items) const
+{
+	std::optional<PostingList> result;
+
+	for (const auto &i : items) {
+		auto ids = Lookup(*i);
+		if (!ids)
+			/* not indexable; it will be applied to the
+			   candidates */
+			continue;
+
+		if (!result) {
+			result = std::move(ids);
+		} else {
+			PostingList both;
+			std::set_intersection(result->begin(), result->end(),
+					      ids->begin(), ids->end(),
+					      std::back_inserter(both));
+			result = std::move(both);
+		}
+
+		if (result->empty())
+			break;
+	}
+
+	return result;
+}
+
+std::optional<std::vector<const Song *>>
+TagIndex::Lookup(const SongFilter &filter) const
+{
+	const auto ids = LookupAnd(filter.GetItems());
+	if (!ids)
+		return std::nullopt;
+
+	std::vector<const Song *> result;
+	result.reserve(ids->size());
+	for (uint32_t id : *ids)
+		if (songs[id] != nullptr)
+			result.push_back(songs[id]);
+
+	return result;
+}
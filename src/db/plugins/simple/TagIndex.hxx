@@ -0,0 +1,173 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_TAG_INDEX_HXX
+#define MPD_TAG_INDEX_HXX
+
+#include "song/ISongFilter.hxx"
+#include "tag/Type.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TagItem;
+struct Song;
+struct Directory;
+class SongFilter;
+class TagSongFilter;
+
+/**
+ * An inverted index of the tag values of all songs in a #Directory
+ * tree: for each tag type and case-folded value, the ids of the songs
+ * having it.  It is used to find the candidates for a #SongFilter
+ * without visiting every song.
+ *
+ * Songs get ascending ids as they are added, so the posting lists are
+ * kept sorted by just appending.  Removing a song only clears its
+ * slot; the stale ids are purged from the posting lists once they
+ * make up half of the index.
+ *
+ * Songs with a Song::target are linked to their target song when
+ * they (or the target) are added, so lookups don't need to resolve
+ * targets.
+ *
+ * All methods require the #db_mutex to be locked.
+ */
+class TagIndex {
+public:
+	static constexpr uint32_t NO_ID = ~uint32_t{};
+
+private:
+	/** song ids in ascending order */
+	using PostingList = std::vector<uint32_t>;
+
+	using PostingMap = std::map<std::string, PostingList, std::less<>>;
+
+	PostingMap tags[TAG_NUM_OF_ITEM_TYPES];
+
+	/**
+	 * Maps the (pooled) #TagItem instances to their posting
+	 * lists while building the index, to avoid folding each
+	 * distinct value more than once.
+	 */
+	using FoldCache = std::unordered_map<const TagItem *, PostingList *>;
+
+	/**
+	 * The songs by id; removed songs leave a nullptr.
+	 */
+	std::vector<Song *> songs;
+
+	/**
+	 * The ids of the songs with a Song::target by the id of
+	 * their target song.  Their tags get complemented with the
+	 * tags of the target song when they are exported, so they
+	 * are candidates wherever their target is.
+	 */
+	std::unordered_map<uint32_t, PostingList> linked;
+
+	/**
+	 * The id of the target song of each song in #linked.
+	 */
+	std::unordered_map<uint32_t, uint32_t> targets;
+
+	/**
+	 * Songs whose Song::target is not in the index, by the last
+	 * path component of the target.  They are resolved when a
+	 * song with that name is added.
+	 */
+	std::unordered_multimap<std::string, uint32_t> unresolved;
+
+	std::size_t n_removed = 0;
+
+public:
+	/**
+	 * Index all songs in the given tree and attach the index to
+	 * its root, so that Directory::AddSong() and
+	 * Directory::RemoveSong() keep it up to date.
+	 */
+	void Build(Directory &root) noexcept;
+
+	void Clear() noexcept;
+
+	/**
+	 * Returns the number of songs in the index.
+	 */
+	std::size_t GetSongCount() const noexcept {
+		return songs.size() - n_removed;
+	}
+
+	void Add(Song &song) noexcept {
+		Add(song, nullptr);
+	}
+
+	/**
+	 * Remove the song from the index.  It is a no-op if the song
+	 * is not in the index.
+	 */
+	void Remove(Song &song) noexcept;
+
+	/**
+	 * Find all songs which may match the given filter, in the
+	 * order they were added.  This is a superset of the matching
+	 * songs; the caller still needs to apply the filter.
+	 *
+	 * @return the candidate songs or std::nullopt if the index
+	 * cannot narrow down this filter (and all songs need to be
+	 * checked)
+	 */
+	std::optional<std::vector<const Song *>> Lookup(const SongFilter &filter) const;
+
+private:
+	void Add(Song &song, FoldCache *cache) noexcept;
+
+	void BuildDirectory(Directory &directory, FoldCache &cache) noexcept;
+
+	/**
+	 * Link a new song with a Song::target to its target song, or
+	 * remember it in #unresolved.
+	 */
+	void Link(uint32_t id, const Song &song) noexcept;
+
+	/**
+	 * Undo Link().
+	 */
+	void Unlink(uint32_t id, const Song &song) noexcept;
+
+	/**
+	 * Link the #unresolved songs whose target is the given new
+	 * song.
+	 */
+	void LinkUnresolved(uint32_t id, const Song &song) noexcept;
+
+	void Compact() noexcept;
+
+	std::optional<PostingList> LookupAnd(const std::list<ISongFilterPtr> &items) const;
+	std::optional<PostingList> Lookup(const ISongFilter &filter) const;
+	std::optional<PostingList> Lookup(const TagSongFilter &filter) const;
+
+	void Collect(TagType type, const std::string &key, bool prefix,
+		     PostingList &dest) const;
+};
+
+#endif
@@ -91,6 +91,9 @@ UpdateWalk::UpdateArchiveTree(ArchiveFile &archive, Directory &directory,
 					 "deleting unrecognized file {}/{}",
 					 directory.GetPath(), name);
 				editor.LockDeleteSong(directory, song);
+			} else {
+				const ScopeDatabaseLock protect;
+				directory.ReindexSong(*song);
 			}
 		}
 	}
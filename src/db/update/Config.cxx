@@ -22,6 +22,8 @@
 #include "config/Option.hxx"
 
 UpdateConfig::UpdateConfig(const ConfigData &config)
+	:threads(config.GetPositive(ConfigOption::UPDATE_THREADS,
+				    DEFAULT_THREADS))
 {
 #ifndef _WIN32
 	follow_inside_symlinks =
@@ -31,6 +31,18 @@ struct UpdateConfig {
 	bool follow_outside_symlinks = DEFAULT_FOLLOW_OUTSIDE_SYMLINKS;
 #endif
 
+	/**
+	 * Scanning in parallel is opt-in, because it calls decoder
+	 * plugins from several threads at once.
+	 */
+	static constexpr unsigned DEFAULT_THREADS = 1;
+
+	/**
+	 * The number of threads scanning song files; with 1, all
+	 * files are scanned by the update thread itself.
+	 */
+	unsigned threads;
+
 	explicit UpdateConfig(const ConfigData &config);
 };
 
@@ -17,7 +17,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
-#include "Walk.hxx"
+#include "SongJob.hxx"
 #include "UpdateDomain.hxx"
 #include "song/DetachedSong.hxx"
 #include "db/DatabaseLock.hxx"
@@ -43,9 +43,9 @@ SupportsContainerSuffix(const DecoderPlugin &plugin,
 }
 
 bool
-UpdateWalk::UpdateContainerFile(Directory &directory,
-				std::string_view name, std::string_view suffix,
-				const StorageFileInfo &info) noexcept
+UpdateWalk::PrepareContainerFile(SongJob &job, Directory &directory,
+				 std::string_view name, std::string_view suffix,
+				 const StorageFileInfo &info) noexcept
 {
 	std::list<const DecoderPlugin *> plugins;
 	for (unsigned i = 0; decoder_plugins[i] != nullptr; ++i)
@@ -66,7 +66,7 @@ UpdateWalk::UpdateContainerFile(Directory &directory,
 			return true;
 	}
 
-	const auto pathname = storage.MapFS(contdir->GetPath());
+	auto pathname = storage.MapFS(contdir->GetPath());
 	if (pathname.IsNull()) {
 		/* not a local file: skip, because the container API
 			 supports only local files */
@@ -74,42 +74,53 @@ UpdateWalk::UpdateContainerFile(Directory &directory,
 		return false;
 	}
 
-	unsigned int track_count = 0;
-	for (auto plugin : plugins) {
+	job.contdir = contdir;
+	job.container_path = std::move(pathname);
+	job.container_plugins = std::move(plugins);
+	return false;
+}
+
+bool
+UpdateWalk::SongJob::RunContainer() noexcept
+{
+	for (auto plugin : container_plugins) {
 		try {
-			auto v = plugin->container_scan(pathname);
-			if (v.empty()) {
-				continue;
-			}
-
-			for (auto &vtrack : v) {
-				auto song = std::make_unique<Song>(std::move(vtrack),
-				*contdir);
-
-				// shouldn't be necessary but it's there..
-				song->mtime = info.mtime;
-
-				FmtNotice(update_domain, "added {}/{}",
-						contdir->GetPath(),
-						song->filename);
-
-				{
-					const ScopeDatabaseLock protect;
-					contdir->AddSong(std::move(song));
-					track_count++;
-				}
-
-				modified = true;
-			}
+			for (auto &vtrack : plugin->container_scan(container_path))
+				tracks.emplace_back(std::move(vtrack));
 		}	catch (...) {
 			LogError(std::current_exception());
 		}
 	}
 
-	if (track_count == 0) {
-		editor.LockDeleteDirectory(contdir);
+	return !tracks.empty();
+}
+
+bool
+UpdateWalk::SongJob::CommitContainer() noexcept
+{
+	if (tracks.empty()) {
+		walk.editor.DeleteDirectory(contdir);
 		return false;
 	}
 
+	for (auto &vtrack : tracks) {
+		auto new_track = std::make_unique<Song>(std::move(vtrack),
+							*contdir);
+
+		// shouldn't be necessary but it's there..
+		new_track->mtime = mtime;
+
+		FmtNotice(update_domain, "added {}/{}",
+			  contdir->GetPath(),
+			  new_track->filename);
+
+		contdir->AddSong(std::move(new_track));
+	}
+
+	walk.modified = true;
+
+	if (song != nullptr)
+		walk.editor.DeleteSong(directory, song);
+
 	return true;
 }
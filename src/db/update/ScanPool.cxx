@@ -0,0 +1,165 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ScanPool.hxx"
+#include "db/DatabaseLock.hxx"
+#include "thread/Name.hxx"
+#include "thread/Util.hxx"
+
+#include <vector>
+
+void
+UpdateScanPool::Start(unsigned n_threads)
+{
+	assert(threads.empty());
+
+	if (n_threads < 2)
+		return;
+
+	/* enough work to keep all threads busy while the walker
+	   waits for a slow one */
+	max_pending = n_threads * 16;
+
+	try {
+		while (threads.size() < n_threads) {
+			auto &thread = threads.emplace_back(BIND_THIS_METHOD(RunThread));
+			thread.Start();
+		}
+	} catch (...) {
+		/* the last Thread object was not started */
+		threads.pop_back();
+		Stop();
+		throw;
+	}
+}
+
+void
+UpdateScanPool::Stop() noexcept
+{
+	Flush();
+
+	{
+		const std::scoped_lock<Mutex> lock(mutex);
+		quit = true;
+		work_cond.notify_all();
+	}
+
+	for (auto &thread : threads)
+		thread.Join();
+
+	threads.clear();
+	quit = false;
+}
+
+void
+UpdateScanPool::Cancel() noexcept
+{
+	const std::scoped_lock<Mutex> lock(mutex);
+	cancel = true;
+	work_cond.notify_all();
+	done_cond.notify_all();
+}
+
+void
+UpdateScanPool::Submit(std::unique_ptr<UpdateScanJob> job) noexcept
+{
+	if (threads.empty()) {
+		job->Run();
+
+		const ScopeDatabaseLock protect;
+		job->Commit();
+		return;
+	}
+
+	while (pending.size() >= max_pending)
+		CommitFront(true);
+
+	const std::scoped_lock<Mutex> lock(mutex);
+	pending.emplace_back(std::move(job));
+	work_cond.notify_one();
+}
+
+void
+UpdateScanPool::CommitFront(bool wait) noexcept
+{
+	std::vector<std::unique_ptr<UpdateScanJob>> batch;
+
+	{
+		std::unique_lock<Mutex> lock(mutex);
+
+		const auto IsFinished = [this](const UpdateScanJob &job){
+			return job.state == UpdateScanJob::State::DONE ||
+				(cancel && job.state == UpdateScanJob::State::QUEUED);
+		};
+
+		if (wait && !pending.empty())
+			done_cond.wait(lock, [&]{
+				return IsFinished(*pending.front());
+			});
+
+		while (!pending.empty() && IsFinished(*pending.front())) {
+			batch.emplace_back(std::move(pending.front()));
+			pending.pop_front();
+
+			if (next > 0)
+				--next;
+		}
+	}
+
+	if (batch.empty())
+		return;
+
+	/* the state of the jobs in the batch is not modified by the
+	   pool threads anymore */
+	const ScopeDatabaseLock protect;
+	for (auto &job : batch) {
+		if (job->state == UpdateScanJob::State::DONE)
+			job->Commit();
+		else
+			job->Discard();
+	}
+}
+
+void
+UpdateScanPool::RunThread() noexcept
+{
+	SetThreadName("update");
+	SetThreadIdlePriority();
+
+	std::unique_lock<Mutex> lock(mutex);
+
+	while (true) {
+		work_cond.wait(lock, [this]{
+			return quit || (!cancel && next < pending.size());
+		});
+
+		if (quit)
+			break;
+
+		auto &job = *pending[next++];
+		job.state = UpdateScanJob::State::RUNNING;
+
+		lock.unlock();
+		job.Run();
+		lock.lock();
+
+		job.state = UpdateScanJob::State::DONE;
+		done_cond.notify_all();
+	}
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_UPDATE_SCAN_POOL_HXX
+#define MPD_UPDATE_SCAN_POOL_HXX
+
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Thread.hxx"
+
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+
+/**
+ * A unit of work submitted to the #UpdateScanPool: an expensive part
+ * (e.g. scanning the tags of a file) which may run in any thread, and
+ * a cheap part which applies the result to the database.
+ */
+class UpdateScanJob {
+	friend class UpdateScanPool;
+
+	enum class State : uint_least8_t {
+		QUEUED,
+		RUNNING,
+		DONE,
+	};
+
+	/**
+	 * Protected by UpdateScanPool::mutex.
+	 */
+	State state = State::QUEUED;
+
+public:
+	virtual ~UpdateScanJob() noexcept = default;
+
+	/**
+	 * Do the expensive part.  This is called in one of the pool
+	 * threads and must not touch the database.
+	 */
+	virtual void Run() noexcept = 0;
+
+	/**
+	 * Apply the result of Run() to the database.  This is called
+	 * in the thread which submitted the job.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	virtual void Commit() noexcept = 0;
+
+	/**
+	 * The job has been cancelled before Run() was called; undo
+	 * whatever was prepared for it.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	virtual void Discard() noexcept {}
+};
+
+/**
+ * A pool of threads which run #UpdateScanJob instances for the
+ * #UpdateWalk.  The results are committed in the order the jobs were
+ * submitted, in batches, so the resulting database does not depend
+ * on the number of threads or on their timing.
+ *
+ * Without threads (see Start()), each job runs and is committed
+ * right away inside Submit().
+ */
+class UpdateScanPool final {
+	Mutex mutex;
+
+	/**
+	 * Signalled when a job is submitted or when the pool is
+	 * cancelled or stopped.
+	 */
+	Cond work_cond;
+
+	/**
+	 * Signalled when a job is done or when the pool is
+	 * cancelled.
+	 */
+	Cond done_cond;
+
+	std::list<Thread> threads;
+
+	/**
+	 * All jobs which have not been committed yet, in submission
+	 * order.  Protected by #mutex, but only the submitting thread
+	 * adds or removes items.
+	 */
+	std::deque<std::unique_ptr<UpdateScanJob>> pending;
+
+	/**
+	 * The index of the next job in #pending a pool thread shall
+	 * run.
+	 */
+	std::size_t next = 0;
+
+	/**
+	 * The maximum size of #pending.  Submit() blocks while it is
+	 * full, which limits the memory occupied by results waiting
+	 * for a job which takes a long time.
+	 */
+	std::size_t max_pending = 0;
+
+	/**
+	 * Don't run any more jobs.  Once set, this is never reset.
+	 */
+	bool cancel = false;
+
+	bool quit = false;
+
+public:
+	UpdateScanPool() noexcept = default;
+
+#ifndef NDEBUG
+	~UpdateScanPool() noexcept {
+		assert(threads.empty());
+		assert(pending.empty());
+	}
+#endif
+
+	UpdateScanPool(const UpdateScanPool &) = delete;
+	UpdateScanPool &operator=(const UpdateScanPool &) = delete;
+
+	/**
+	 * Launch the given number of threads.  With less than two,
+	 * no thread is launched, because the submitting thread would
+	 * be idle anyway.
+	 *
+	 * Throws on error.
+	 */
+	void Start(unsigned n_threads);
+
+	/**
+	 * Commit all pending jobs (see Flush()) and stop the threads.
+	 */
+	void Stop() noexcept;
+
+	/**
+	 * Stop running jobs as soon as possible.  Jobs which have not
+	 * been started yet will be discarded.  This method is
+	 * thread-safe.
+	 */
+	void Cancel() noexcept;
+
+	/**
+	 * Caller must NOT lock the #db_mutex.
+	 */
+	void Submit(std::unique_ptr<UpdateScanJob> job) noexcept;
+
+	/**
+	 * Commit all jobs at the front of the queue which are done,
+	 * without waiting for the others.
+	 *
+	 * Caller must NOT lock the #db_mutex.
+	 */
+	void CommitFinished() noexcept {
+		CommitFront(false);
+	}
+
+	/**
+	 * Wait for all submitted jobs and commit them.
+	 *
+	 * Caller must NOT lock the #db_mutex.
+	 */
+	void Flush() noexcept {
+		while (!pending.empty())
+			CommitFront(true);
+	}
+
+private:
+	/**
+	 * Commit (or discard) the jobs at the front of #pending which
+	 * are done, all under one database lock.
+	 *
+	 * @param wait wait until at least the first job is done
+	 */
+	void CommitFront(bool wait) noexcept;
+
+	void RunThread() noexcept;
+};
+
+#endif
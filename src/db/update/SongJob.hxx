@@ -0,0 +1,109 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_UPDATE_SONG_JOB_HXX
+#define MPD_UPDATE_SONG_JOB_HXX
+
+#include "Walk.hxx"
+#include "db/plugins/simple/Ptr.hxx"
+#include "song/DetachedSong.hxx"
+#include "fs/AllocatedPath.hxx"
+
+#include <chrono>
+#include <exception>
+#include <list>
+#include <string>
+#include <vector>
+
+struct DecoderPlugin;
+
+/**
+ * Scan a new or modified song file (or container) in a pool thread
+ * and add or update the #Song in the database afterwards.
+ */
+struct UpdateWalk::SongJob final : UpdateScanJob {
+	UpdateWalk &walk;
+
+	Directory &directory;
+
+	const std::string name;
+
+	/**
+	 * The existing #Song object or nullptr if the file is new.
+	 * Only the update thread modifies the database, and it does
+	 * not delete this song while the job is pending.
+	 */
+	Song *const song;
+
+	const std::chrono::system_clock::time_point mtime;
+
+	/**
+	 * The virtual directory which receives the tracks of a
+	 * container file (see PrepareContainerFile()) or nullptr.
+	 */
+	Directory *contdir = nullptr;
+
+	AllocatedPath container_path = nullptr;
+
+	std::list<const DecoderPlugin *> container_plugins;
+
+	std::vector<DetachedSong> tracks;
+
+	/**
+	 * The result of Song::LoadFile(); nullptr if the file was
+	 * not recognized.
+	 */
+	SongPtr new_song;
+
+	/**
+	 * Song::LoadFile() has thrown this.
+	 */
+	std::exception_ptr error;
+
+	SongJob(UpdateWalk &_walk, Directory &_directory,
+		std::string_view _name, Song *_song,
+		std::chrono::system_clock::time_point _mtime) noexcept
+		:walk(_walk), directory(_directory),
+		 name(_name), song(_song), mtime(_mtime) {}
+
+	/* virtual methods from class UpdateScanJob */
+	void Run() noexcept override;
+	void Commit() noexcept override;
+	void Discard() noexcept override;
+
+private:
+	/**
+	 * Scan the container.
+	 *
+	 * @return true if it contains tracks
+	 */
+	bool RunContainer() noexcept;
+
+	/**
+	 * Add the tracks of the container to #contdir, or delete it
+	 * if there are none.
+	 *
+	 * Caller must lock the #db_mutex.
+	 *
+	 * @return true if the tracks were added
+	 */
+	bool CommitContainer() noexcept;
+};
+
+#endif
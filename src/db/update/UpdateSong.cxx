@@ -17,7 +17,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
-#include "Walk.hxx"
+#include "SongJob.hxx"
 #include "UpdateIO.hxx"
 #include "UpdateDomain.hxx"
 #include "lib/fmt/ExceptionFormatter.hxx"
@@ -51,19 +51,59 @@ try {
 		return;
 	}
 
-	if (!(song != nullptr && info.mtime == song->mtime && !walk_discard) &&
-	    UpdateContainerFile(directory, name, suffix, info)) {
+	if (song != nullptr && info.mtime == song->mtime && !walk_discard)
+		/* not modified */
+		return;
+
+	auto job = std::make_unique<SongJob>(*this, directory, name, song,
+					     info.mtime);
+
+	if (PrepareContainerFile(*job, directory, name, suffix, info)) {
 		if (song != nullptr)
 			editor.LockDeleteSong(directory, song);
 
 		return;
 	}
 
-	if (song == nullptr) {
+	if (song == nullptr)
 		FmtDebug(update_domain, "reading {}/{}",
 			 directory.GetPath(), name);
+	else
+		FmtNotice(update_domain, "updating {}/{}",
+			  directory.GetPath(), name);
+
+	scan_pool.Submit(std::move(job));
+} catch (...) {
+	FmtError(update_domain,
+		 "error reading file {}/{}: {}",
+		 directory.GetPath(), name, std::current_exception());
+}
+
+void
+UpdateWalk::SongJob::Run() noexcept
+try {
+	if (contdir != nullptr && RunContainer())
+		return;
+
+	new_song = Song::LoadFile(walk.storage, name.c_str(), directory);
+} catch (...) {
+	error = std::current_exception();
+}
+
+void
+UpdateWalk::SongJob::Commit() noexcept
+{
+	if (contdir != nullptr && CommitContainer())
+		return;
+
+	if (error) {
+		FmtError(update_domain,
+			 "error reading file {}/{}: {}",
+			 directory.GetPath(), name, error);
+		return;
+	}
 
-		auto new_song = Song::LoadFile(storage, name, directory);
+	if (song == nullptr) {
 		if (!new_song) {
 			FmtDebug(update_domain,
 				 "ignoring unrecognized file {}/{}",
@@ -71,30 +111,35 @@ try {
 			return;
 		}
 
-		{
-			const ScopeDatabaseLock protect;
-			directory.AddSong(std::move(new_song));
-		}
+		directory.AddSong(std::move(new_song));
 
-		modified = true;
+		walk.modified = true;
 		FmtNotice(update_domain, "added {}/{}",
 			  directory.GetPath(), name);
-	} else if (info.mtime != song->mtime || walk_discard) {
-		FmtNotice(update_domain, "updating {}/{}",
-			  directory.GetPath(), name);
-		if (!song->UpdateFile(storage)) {
+	} else {
+		if (!new_song) {
 			FmtDebug(update_domain,
 				 "deleting unrecognized file {}/{}",
 				 directory.GetPath(), name);
-			editor.LockDeleteSong(directory, song);
+			walk.editor.DeleteSong(directory, song);
+		} else {
+			/* the attributes set by Song::UpdateFile() */
+			song->mtime = new_song->mtime;
+			song->audio_format = new_song->audio_format;
+			song->tag = std::move(new_song->tag);
+			directory.ReindexSong(*song);
 		}
 
-		modified = true;
+		walk.modified = true;
 	}
-} catch (...) {
-	FmtError(update_domain,
-		 "error reading file {}/{}: {}",
-		 directory.GetPath(), name, std::current_exception());
+}
+
+void
+UpdateWalk::SongJob::Discard() noexcept
+{
+	/* make sure the next update scans the container again */
+	if (contdir != nullptr)
+		walk.editor.DeleteDirectory(contdir);
 }
 
 bool
@@ -383,6 +383,8 @@ UpdateWalk::UpdateDirectory(Directory &directory,
 		}
 
 		UpdateDirectoryChild(directory, child_exclude_list, name_utf8, info2);
+
+		scan_pool.CommitFinished();
 	}
 
 	directory.mtime = info.mtime;
@@ -511,16 +513,27 @@ UpdateWalk::Walk(Directory &root, const char *path, bool discard) noexcept
 	walk_discard = discard;
 	modified = false;
 
+	try {
+		scan_pool.Start(config.threads);
+	} catch (...) {
+		/* scan in this thread */
+		LogError(std::current_exception(),
+			 "Failed to start update threads");
+	}
+
 	if (path != nullptr && !isRootDirectory(path)) {
 		UpdateUri(root, path);
 	} else {
 		StorageFileInfo info;
-		if (!GetInfo(storage, "", info))
+		if (!GetInfo(storage, "", info)) {
+			scan_pool.Stop();
 			return false;
+		}
 
 		if (!info.IsDirectory()) {
 			FmtError(update_domain, "Not a directory: {}",
 				 storage.MapUTF8(""));
+			scan_pool.Stop();
 			return false;
 		}
 
@@ -529,6 +542,9 @@ UpdateWalk::Walk(Directory &root, const char *path, bool discard) noexcept
 		UpdateDirectory(root, exclude_list, info);
 	}
 
+	/* commit the songs which are still being scanned */
+	scan_pool.Stop();
+
 	{
 		const ScopeDatabaseLock protect;
 		PurgeDanglingFromPlaylists(root);
@@ -22,6 +22,7 @@
 
 #include "Config.hxx"
 #include "Editor.hxx"
+#include "ScanPool.hxx"
 #include "config.h"
 
 #include <atomic>
@@ -57,6 +58,13 @@ class UpdateWalk final {
 
 	DatabaseEditor editor;
 
+	/**
+	 * Scans song files in the background; see #SongJob.
+	 */
+	UpdateScanPool scan_pool;
+
+	struct SongJob;
+
 public:
 	UpdateWalk(const UpdateConfig &_config,
 		   EventLoop &_loop, DatabaseListener &_listener,
@@ -68,6 +76,7 @@ public:
 	 */
 	void Cancel() noexcept {
 		cancel = true;
+		scan_pool.Cancel();
 	}
 
 	/**
@@ -102,9 +111,16 @@ private:
 			    const char *name, std::string_view suffix,
 			    const StorageFileInfo &info) noexcept;
 
-	bool UpdateContainerFile(Directory &directory,
-				 std::string_view name, std::string_view suffix,
-				 const StorageFileInfo &info) noexcept;
+	/**
+	 * If the file is a container, prepare the #SongJob for
+	 * scanning its tracks.
+	 *
+	 * @return true if the file is a container which has not been
+	 * modified (and there is nothing to do)
+	 */
+	bool PrepareContainerFile(SongJob &job, Directory &directory,
+				  std::string_view name, std::string_view suffix,
+				  const StorageFileInfo &info) noexcept;
 
 
 #ifdef ENABLE_ARCHIVE
@@ -125,7 +125,7 @@ DecoderBridge::GetChunk() noexcept
 		return current_chunk.get();
 
 	do {
-		current_chunk = dc.buffer->Allocate();
+		current_chunk = dc.buffer->Allocate(dc.buffer->GetChunkSize(dc.out_audio_format));
 		if (current_chunk != nullptr) {
 			current_chunk->replay_gain_serial = replay_gain_serial;
 			if (replay_gain_serial != 0)
@@ -570,6 +570,89 @@ DecoderBridge::SubmitData(InputStream *is,
 	return cmd;
 }
 
+void *
+DecoderBridge::GetDataBuffer(size_t length) noexcept
+{
+	assert(dc.state == DecoderState::DECODE);
+	assert(dc.pipe != nullptr);
+	assert(length % dc.in_audio_format.GetFrameSize() == 0);
+
+	/* conversions and the initial song tag are only done by
+	   SubmitData() */
+	if (convert != nullptr || song_tag != nullptr || length == 0 ||
+	    LockGetVirtualCommand() != DecoderCommand::NONE)
+		return nullptr;
+
+	assert(!initial_seek_pending);
+	assert(!initial_seek_running);
+
+	auto *chunk = GetChunk();
+	if (chunk == nullptr)
+		return nullptr;
+
+	const auto dest =
+		chunk->Write(dc.out_audio_format,
+			     SongTime::Cast(timestamp) -
+			     dc.song->GetStartTime(),
+			     0);
+	if (dest.size < length)
+		/* not enough room left in this chunk; instead of
+		   flushing it early (which would leave it partly
+		   empty and shrink the buffered time), let
+		   SubmitData() split the data over two chunks */
+		return nullptr;
+
+	return dest.data;
+}
+
+DecoderCommand
+DecoderBridge::CommitData(size_t length, uint16_t kbit_rate) noexcept
+{
+	assert(dc.state == DecoderState::DECODE);
+	assert(length % dc.in_audio_format.GetFrameSize() == 0);
+
+	if (length == 0)
+		return LockGetVirtualCommand();
+
+	assert(current_chunk != nullptr);
+
+	DecoderCommand cmd = DecoderCommand::NONE;
+
+	const size_t frame_size = dc.in_audio_format.GetFrameSize();
+	size_t data_frames = length / frame_size;
+
+	if (dc.end_time.IsPositive()) {
+		/* enforce the given end time */
+
+		const auto end_frame =
+			dc.end_time.ToScale<uint64_t>(dc.in_audio_format.sample_rate);
+		if (absolute_frame >= end_frame)
+			return DecoderCommand::STOP;
+
+		const uint64_t remaining_frames = end_frame - absolute_frame;
+		if (data_frames >= remaining_frames) {
+			data_frames = remaining_frames;
+			length = data_frames * frame_size;
+			cmd = DecoderCommand::STOP;
+		}
+	}
+
+	auto *chunk = current_chunk.get();
+	if (chunk->IsEmpty())
+		chunk->bit_rate = kbit_rate;
+
+	if (length > 0 && chunk->Expand(dc.out_audio_format, length))
+		/* the chunk is full, flush it */
+		FlushChunk();
+
+	timestamp += dc.out_audio_format.SizeToTime<FloatDuration>(length);
+	absolute_frame += data_frames;
+
+	return cmd != DecoderCommand::NONE
+		? cmd
+		: LockGetVirtualCommand();
+}
+
 DecoderCommand
 DecoderBridge::SubmitTag(InputStream *is, Tag &&tag) noexcept
 {
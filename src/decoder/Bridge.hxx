@@ -180,6 +180,9 @@ public:
 	DecoderCommand SubmitData(InputStream *is,
 				  const void *data, size_t length,
 				  uint16_t kbit_rate) noexcept override;
+	void *GetDataBuffer(size_t length) noexcept override;
+	DecoderCommand CommitData(size_t length,
+				  uint16_t kbit_rate) noexcept override;
 	DecoderCommand SubmitTag(InputStream *is, Tag &&tag) noexcept override;
 	void SubmitReplayGain(const ReplayGainInfo *replay_gain_info) noexcept override;
 	void SubmitMixRamp(MixRampInfo &&mix_ramp) noexcept override;
@@ -138,6 +138,39 @@ public:
 		return SubmitData(&is, data, length, kbit_rate);
 	}
 
+	/**
+	 * Obtain room in the current #MusicChunk for @a length bytes
+	 * of data in the format passed to Ready(), so the plugin can
+	 * decode straight into the pipe instead of passing its own
+	 * buffer to SubmitData().  The data is published by
+	 * CommitData(), which must be called before any other method.
+	 *
+	 * @return the writable buffer or nullptr if the data has to
+	 * go through SubmitData() (e.g. because it needs to be
+	 * converted, a command is pending or it doesn't fit into the
+	 * rest of the current chunk)
+	 */
+	virtual void *GetDataBuffer(size_t length) noexcept {
+		(void)length;
+		return nullptr;
+	}
+
+	/**
+	 * Publish data written to the buffer obtained from
+	 * GetDataBuffer().
+	 *
+	 * @param length the number of bytes written; 0 releases the
+	 * buffer unused
+	 * @return the current command, or DecoderCommand::NONE if there is no
+	 * command pending
+	 */
+	virtual DecoderCommand CommitData(size_t length,
+					  uint16_t kbit_rate) noexcept {
+		(void)length;
+		(void)kbit_rate;
+		return GetCommand();
+	}
+
 	/**
 	 * This function is called by the decoder plugin when it has
 	 * successfully decoded a tag.
@@ -60,82 +60,75 @@ bool      param_lsbitfirst;
 area_id_e param_playable_area;
 bool      param_use_stdio;
 
-AllocatedPath                  dsdiff_path{ nullptr };
-std::unique_ptr<sacd_media_t>  sacd_media;
-std::unique_ptr<sacd_reader_t> sacd_reader;
+/**
+ * An opened DSDIFF file.  Each caller opens its own, because the
+ * decoder and the (possibly multi-threaded) database update may read
+ * the same file at the same time.
+ */
+struct dsdiff_file_t {
+	std::unique_ptr<sacd_media_t>  media;
+
+	/* declared after (and thus destroyed before) the media it reads */
+	std::unique_ptr<sacd_reader_t> reader;
+};
 
 static unsigned
-get_subsong(Path path_fs) {
+get_subsong(sacd_reader_t& sacd_reader, Path path_fs) {
 	auto ptr = path_fs.GetBase().c_str();
 	char area = '\0';
 	unsigned index = 0;
 	char suffix[4];
 	auto params = sscanf(ptr, DSDIFF_TRACKXXX_FMT, &area, &index, suffix);
 	if (area == 'M') {
-		index += sacd_reader->get_tracks(AREA_TWOCH);
+		index += sacd_reader.get_tracks(AREA_TWOCH);
 	}
 	index--;
 	return (params == 3) ? index : 0;
 }
 
-static bool
-container_update(Path path_fs) {
+/**
+ * Open the DSDIFF file at the given path or, if that is a virtual
+ * track, at its parent.
+ */
+static std::unique_ptr<dsdiff_file_t>
+open_file(Path path_fs) {
 	auto curr_path = AllocatedPath(path_fs);
 	if (!FileExists(curr_path)) {
 		curr_path = path_fs.GetDirectoryName();
+		if (!FileExists(curr_path)) {
+			return nullptr;
+		}
 	}
-	if (dsdiff_path == curr_path) {
-		return true;
+	auto file = std::make_unique<dsdiff_file_t>();
+	if (param_use_stdio) {
+		file->media = std::make_unique<sacd_media_file_t>();
 	}
-	if (sacd_reader) {
-		sacd_reader->close();
-		sacd_reader.reset();
+	else {
+		file->media = std::make_unique<sacd_media_stream_t>();
 	}
-	if (sacd_media) {
-		sacd_media->close();
-		sacd_media.reset();
+	if (!file->media->open(curr_path.c_str())) {
+		std::string err;
+		err  = "sacd_media->open('";
+		err += curr_path.c_str();
+		err += "') failed";
+		LogWarning(dsdiff_domain, err.c_str());
+		return nullptr;
 	}
-	dsdiff_path.SetNull();
-	if (FileExists(curr_path)) {
-		if (param_use_stdio) {
-			sacd_media = std::make_unique<sacd_media_file_t>();
-		}
-		else {
-			sacd_media = std::make_unique<sacd_media_stream_t>();
-		}
-		if (!sacd_media) {
-			LogError(dsdiff_domain, "new sacd_media_t() failed");
-			return false;
-		}
-		sacd_reader = std::make_unique<sacd_dsdiff_t>();
-		if (!sacd_reader) {
-			LogError(dsdiff_domain, "new sacd_dsdiff_t() failed");
-			return false;
-		}
-		if (!sacd_media->open(curr_path.c_str())) {
-			std::string err;
-			err  = "sacd_media->open('";
-			err += curr_path.c_str();
-			err += "') failed";
-			LogWarning(dsdiff_domain, err.c_str());
-			return false;
-		}
-		if (!sacd_reader->open(sacd_media.get(), param_single_track ? MODE_SINGLE_TRACK : MODE_MULTI_TRACK)) {
-			//LogWarning(dsdiff_domain, "sacd_reader->open(...) failed");
-			return false;
-		}
-		dsdiff_path = curr_path;
+	file->reader = std::make_unique<sacd_dsdiff_t>();
+	if (!file->reader->open(file->media.get(), param_single_track ? MODE_SINGLE_TRACK : MODE_MULTI_TRACK)) {
+		//LogWarning(dsdiff_domain, "sacd_reader->open(...) failed");
+		return nullptr;
 	}
-	return static_cast<bool>(sacd_reader);
+	return file;
 }
 
 static void
-scan_info(unsigned track, TagHandler& handler) {
+scan_info(sacd_reader_t& sacd_reader, unsigned track, TagHandler& handler) {
 	std::string tag_value = std::to_string(track + 1);
 	handler.OnTag(TAG_TRACK, tag_value.c_str());
-	handler.OnDuration(SongTime::FromS(sacd_reader->get_duration(track)));
-	sacd_reader->get_info(track, handler);
-	auto track_format = sacd_reader->is_dst() ? "DST" : "DSD";
+	handler.OnDuration(SongTime::FromS(sacd_reader.get_duration(track)));
+	sacd_reader.get_info(track, handler);
+	auto track_format = sacd_reader.is_dst() ? "DST" : "DSD";
 	handler.OnPair("codec", track_format);
 }
 
@@ -159,11 +152,6 @@ init(const ConfigBlock& block) {
 	return true;
 }
 
-static void
-finish() noexcept {
-	container_update(nullptr);
-}
-
 static std::forward_list<DetachedSong>
 container_scan(Path path_fs) {
 	std::forward_list<DetachedSong> list;
@@ -173,9 +161,11 @@ container_scan(Path path_fs) {
 		}
 		return list;
 	}
-	if (!container_update(path_fs)) {
+	auto file = open_file(path_fs);
+	if (!file) {
 		return list;
 	}
+	auto sacd_reader = file->reader.get();
 	TagBuilder tag_builder;
 	auto tail = list.before_begin();
 	auto suffix = path_fs.GetSuffix();
@@ -188,7 +178,7 @@ container_scan(Path path_fs) {
 		sacd_reader->select_area(AREA_TWOCH);
 		for (auto track = 0u; track < twoch_count; track++) {
 			AddTagHandler handler(tag_builder);
-			scan_info(track, handler);
+			scan_info(*sacd_reader, track, handler);
 			tail = list.emplace_after(
 				tail,
 				StringFormat<64>(DSDIFF_TRACKXXX_FMT, '2', track + 1, suffix),
@@ -200,7 +190,7 @@ container_scan(Path path_fs) {
 		sacd_reader->select_area(AREA_MULCH);
 		for (auto track = 0u; track < mulch_count; track++) {
 			AddTagHandler h(tag_builder);
-			scan_info(track, h);
+			scan_info(*sacd_reader, track, h);
 			tail = list.emplace_after(
 				tail,
 				StringFormat<64>(DSDIFF_TRACKXXX_FMT, 'M', track + twoch_count + 1, suffix),
@@ -211,21 +201,16 @@ container_scan(Path path_fs) {
 	return list;
 }
 
-static void
-bit_reverse_buffer(uint8_t* p, uint8_t* end) {
-	for (; p < end; ++p) {
-		*p = bit_reverse(*p);
-	}
-}
-
 static void
 file_decode(DecoderClient &client, Path path_fs) {
-	if (!container_update(FileExists(path_fs) ? AllocatedPath(path_fs) : path_fs.GetDirectoryName())) {
+	auto file = open_file(path_fs);
+	if (!file) {
 		return;
 	}
+	auto sacd_reader = file->reader.get();
 	auto twoch_count = sacd_reader->get_tracks(AREA_TWOCH);
 	auto mulch_count = sacd_reader->get_tracks(AREA_MULCH);
-	auto track = (twoch_count + mulch_count > 1) ? get_subsong(path_fs) : 0;
+	auto track = (twoch_count + mulch_count > 1) ? get_subsong(*sacd_reader, path_fs) : 0;
 
 	// initialize reader
 	sacd_reader->set_emaster(param_edited_master);
@@ -298,7 +283,7 @@ file_decode(DecoderClient &client, Path path_fs) {
 				}
 				if (dsd_size > 0) {
 					if (param_lsbitfirst) {
-						bit_reverse_buffer(dsd_data, dsd_data + dsd_size);
+						BitReverse(dsd_data, dsd_size);
 					}
 					cmd = client.SubmitData(nullptr, dsd_data, dsd_size, 8 * dst_size / 1000);
 				}
@@ -315,7 +300,7 @@ file_decode(DecoderClient &client, Path path_fs) {
 				}
 				if (dsd_size > 0) {
 					if (param_lsbitfirst) {
-						bit_reverse_buffer(dsd_data, dsd_data + dsd_size);
+						BitReverse(dsd_data, dsd_size);
 					}
 					cmd = client.SubmitData(nullptr, dsd_data, dsd_size, 0);
 					if (cmd == DecoderCommand::STOP || cmd == DecoderCommand::SEEK) {
@@ -334,6 +319,9 @@ file_decode(DecoderClient &client, Path path_fs) {
 		if (cmd == DecoderCommand::SEEK) {
 			auto seconds = client.GetSeekTime().ToDoubleS();
 			if (sacd_reader->seek(seconds)) {
+				if (dst_decoder) {
+					dst_decoder->flush();
+				}
 				client.CommandFinished();
 			}
 			else {
@@ -343,6 +331,12 @@ file_decode(DecoderClient &client, Path path_fs) {
 		}
 	}
 	if (dst_decoder) {
+		const auto& stats = dst_decoder->get_stats();
+		if (stats.frames > 0) {
+			FmtDebug(dsdiff_domain, "DST: {} frames, {} us/frame average, {} us/frame max, queue depth {} max",
+				 stats.frames, stats.decode_ns_total / stats.frames / 1000,
+				 stats.decode_ns_max / 1000, stats.queue_depth_max);
+		}
 		delete dst_decoder;
 		dst_decoder = nullptr;
 	}
@@ -350,12 +344,14 @@ file_decode(DecoderClient &client, Path path_fs) {
 
 static bool
 scan_file(Path path_fs, TagHandler& handler) noexcept {
-	if (!container_update(FileExists(path_fs) ? AllocatedPath(path_fs) : path_fs.GetDirectoryName())) {
+	auto file = open_file(path_fs);
+	if (!file) {
 		return false;
 	}
+	auto sacd_reader = file->reader.get();
 	auto twoch_count = sacd_reader->get_tracks(AREA_TWOCH);
 	auto mulch_count = sacd_reader->get_tracks(AREA_MULCH);
-	auto track = (twoch_count + mulch_count > 1) ? get_subsong(path_fs) : 0;
+	auto track = (twoch_count + mulch_count > 1) ? get_subsong(*sacd_reader, path_fs) : 0;
 	if (track < twoch_count) {
 		sacd_reader->select_area(AREA_TWOCH);
 	}
@@ -369,7 +365,7 @@ scan_file(Path path_fs, TagHandler& handler) noexcept {
 			return false;
 		}
 	}
-	scan_info(track, handler);
+	scan_info(*sacd_reader, track, handler);
 	return true;
 }
 
@@ -389,7 +385,7 @@ static const char* const mime_types[] {
 
 constexpr DecoderPlugin dff_decoder_plugin =
 	DecoderPlugin("dsdiff", dsdiff::file_decode, dsdiff::scan_file)
-	.WithInit(dsdiff::init, dsdiff::finish)
+	.WithInit(dsdiff::init)
 	.WithContainer(dsdiff::container_scan)
 	.WithSuffixes(dsdiff::suffixes)
 	.WithMimeTypes(dsdiff::mime_types);
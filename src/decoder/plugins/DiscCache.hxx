@@ -0,0 +1,159 @@
+/*
+ * Copyright 2003-2022 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DECODER_DISC_CACHE_HXX
+#define MPD_DECODER_DISC_CACHE_HXX
+
+#include "fs/AllocatedPath.hxx"
+#include "fs/FileInfo.hxx"
+#include "fs/Path.hxx"
+#include "thread/Mutex.hxx"
+#include "util/StringAPI.hxx"
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <memory>
+
+/**
+ * A thread-safe, bounded LRU cache of parsed disc images (SACD/DVD-A
+ * ISO files), keyed by path and modification time.
+ *
+ * Entries are handed out as std::shared_ptr, so an entry which gets
+ * evicted (or replaced because the file was modified) stays alive
+ * until the last decoder/scanner using it has finished.  The cached
+ * object is expected to be immutable after it has been opened; all
+ * per-stream state belongs into a separate cursor object owned by the
+ * caller.
+ */
+template<typename T>
+class DiscCache {
+	struct Item {
+		AllocatedPath path;
+		std::chrono::system_clock::time_point mtime;
+		uint64_t size;
+		std::shared_ptr<T> disc;
+	};
+
+	mutable Mutex mutex;
+
+	/**
+	 * The cached discs, most recently used first.
+	 */
+	std::list<Item> items;
+
+	std::size_t capacity;
+
+public:
+	explicit DiscCache(std::size_t _capacity=4) noexcept
+		:capacity(_capacity) {}
+
+	DiscCache(const DiscCache &) = delete;
+	DiscCache &operator=(const DiscCache &) = delete;
+
+	void SetCapacity(std::size_t _capacity) noexcept {
+		const std::scoped_lock<Mutex> lock(mutex);
+		capacity = _capacity;
+		Trim();
+	}
+
+	/**
+	 * Look up the disc at the given path.  If it is not cached
+	 * (or the file has been modified since), the #open function
+	 * is invoked without holding the lock; it receives the #Path
+	 * and returns a std::shared_ptr<T> (nullptr on error).
+	 *
+	 * @return the disc or nullptr if the file does not exist or
+	 * could not be opened
+	 */
+	template<typename F>
+	std::shared_ptr<T> Get(Path path, F &&open) {
+		FileInfo info;
+		if (path.IsNull() || !GetFileInfo(path, info) ||
+		    !info.IsRegular())
+			return nullptr;
+
+		const auto mtime = info.GetModificationTime();
+		const auto size = info.GetSize();
+
+		{
+			const std::scoped_lock<Mutex> lock(mutex);
+			auto i = Find(path);
+			if (i != items.end()) {
+				if (i->mtime == mtime && i->size == size) {
+					items.splice(items.begin(), items, i);
+					return i->disc;
+				}
+
+				/* stale entry: the file was modified */
+				items.erase(i);
+			}
+		}
+
+		std::shared_ptr<T> disc = open(path);
+		if (!disc)
+			return nullptr;
+
+		const std::scoped_lock<Mutex> lock(mutex);
+
+		/* another thread may have opened the same disc
+		   meanwhile; prefer the instance which is already
+		   shared */
+		auto i = Find(path);
+		if (i != items.end()) {
+			if (i->mtime == mtime && i->size == size) {
+				items.splice(items.begin(), items, i);
+				return i->disc;
+			}
+
+			items.erase(i);
+		}
+
+		if (capacity > 0) {
+			items.push_front({AllocatedPath{path}, mtime, size, disc});
+			Trim();
+		}
+
+		return disc;
+	}
+
+	/**
+	 * Drop all cached discs.  Discs still in use remain valid
+	 * until their last reference is released.
+	 */
+	void Clear() noexcept {
+		const std::scoped_lock<Mutex> lock(mutex);
+		items.clear();
+	}
+
+private:
+	typename std::list<Item>::iterator Find(Path path) noexcept {
+		for (auto i = items.begin(); i != items.end(); ++i)
+			if (StringIsEqual(i->path.c_str(), path.c_str()))
+				return i;
+		return items.end();
+	}
+
+	void Trim() noexcept {
+		while (items.size() > capacity)
+			items.pop_back();
+	}
+};
+
+#endif
@@ -0,0 +1,268 @@
+/*
+ * Copyright 2003-2022 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "DiscScanCache.hxx"
+#include "song/DetachedSong.hxx"
+#include "tag/Builder.hxx"
+#include "tag/Handler.hxx"
+#include "tag/Tag.hxx"
+#include "io/FileOutputStream.hxx"
+#include "io/FileReader.hxx"
+#include "fs/FileInfo.hxx"
+#include "fs/Path.hxx"
+#include "util/StringView.hxx"
+#include "Log.hxx"
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/*
+ * File format (host byte order, the cache is local):
+ *
+ *   magic[8] validator count
+ *   count * (uri duration_ms num_items num_items * (type value))
+ *
+ * Strings are stored as uint32_t length followed by the bytes.
+ */
+static constexpr char magic[8] = {'M', 'P', 'D', 'D', 'S', 'C', '0', '1'};
+
+/**
+ * Keep rogue files from making us allocate lots of memory.
+ */
+static constexpr std::size_t max_file_size = 4 * 1024 * 1024;
+
+namespace {
+
+class CacheWriter {
+	std::string buffer;
+
+public:
+	CacheWriter() noexcept {
+		buffer.append(magic, sizeof(magic));
+	}
+
+	void WriteU32(uint32_t value) noexcept {
+		buffer.append((const char *)&value, sizeof(value));
+	}
+
+	void WriteString(std::string_view s) noexcept {
+		WriteU32(s.size());
+		buffer.append(s);
+	}
+
+	const std::string &GetBuffer() const noexcept {
+		return buffer;
+	}
+};
+
+class CacheReader {
+	const char *p, *const end;
+
+public:
+	CacheReader(const char *_p, std::size_t size) noexcept
+		:p(_p), end(_p + size) {}
+
+	bool ReadMagic() noexcept {
+		if (std::size_t(end - p) < sizeof(magic) ||
+		    memcmp(p, magic, sizeof(magic)) != 0)
+			return false;
+		p += sizeof(magic);
+		return true;
+	}
+
+	bool ReadU32(uint32_t &value) noexcept {
+		if (std::size_t(end - p) < sizeof(value))
+			return false;
+		memcpy(&value, p, sizeof(value));
+		p += sizeof(value);
+		return true;
+	}
+
+	bool ReadString(std::string_view &s) noexcept {
+		uint32_t size;
+		if (!ReadU32(size) || std::size_t(end - p) < size)
+			return false;
+		s = {p, size};
+		p += size;
+		return true;
+	}
+};
+
+}
+
+/**
+ * Read the whole cache file into the buffer.
+ */
+static bool
+ReadFile(Path path, std::vector<char> &buffer) noexcept
+try {
+	FileReader reader(path);
+	const auto size = reader.GetFileInfo().GetSize();
+	if (size > max_file_size)
+		return false;
+
+	buffer.resize(size);
+	std::size_t position = 0;
+	while (position < buffer.size()) {
+		std::size_t nbytes = reader.Read(buffer.data() + position,
+						 buffer.size() - position);
+		if (nbytes == 0)
+			return false;
+		position += nbytes;
+	}
+
+	return true;
+} catch (...) {
+	/* no such file (cache miss) or not readable */
+	return false;
+}
+
+/**
+ * Parse a cache file and invoke the callback for each song with its
+ * URI and tag.  The callback returns false to stop.
+ */
+template<typename F>
+static bool
+ParseFile(const std::vector<char> &buffer, std::string_view validator,
+	  F &&f) noexcept
+{
+	CacheReader reader(buffer.data(), buffer.size());
+
+	std::string_view stored_validator;
+	uint32_t count;
+	if (!reader.ReadMagic() ||
+	    !reader.ReadString(stored_validator) ||
+	    stored_validator != validator ||
+	    !reader.ReadU32(count))
+		return false;
+
+	TagBuilder tag;
+	for (uint32_t i = 0; i < count; ++i) {
+		std::string_view uri;
+		uint32_t duration_ms, num_items;
+		if (!reader.ReadString(uri) ||
+		    !reader.ReadU32(duration_ms) ||
+		    !reader.ReadU32(num_items))
+			return false;
+
+		tag.SetDuration(SignedSongTime::FromMS(int32_t(duration_ms)));
+
+		for (uint32_t j = 0; j < num_items; ++j) {
+			uint32_t type;
+			std::string_view value;
+			if (!reader.ReadU32(type) || type >= TAG_NUM_OF_ITEM_TYPES ||
+			    !reader.ReadString(value))
+				return false;
+
+			tag.AddItem(TagType(type), StringView(value.data(), value.size()));
+		}
+
+		if (!f(uri, tag.Commit()))
+			break;
+	}
+
+	return true;
+}
+
+AllocatedPath
+DiscScanCache::GetPath(const char *key) const noexcept
+{
+	const std::string name = std::string(key) + ".cache";
+	return AllocatedPath::Build(directory, name.c_str());
+}
+
+bool
+DiscScanCache::Load(const char *key, std::string_view validator,
+		    std::forward_list<DetachedSong> &songs) const noexcept
+{
+	std::vector<char> buffer;
+	if (!IsEnabled() || !ReadFile(GetPath(key), buffer))
+		return false;
+
+	std::forward_list<DetachedSong> list;
+	auto tail = list.before_begin();
+	if (!ParseFile(buffer, validator, [&](std::string_view uri, Tag &&tag){
+		tail = list.emplace_after(tail, std::string(uri), std::move(tag));
+		return true;
+	}))
+		return false;
+
+	songs = std::move(list);
+	return true;
+}
+
+bool
+DiscScanCache::Lookup(const char *key, std::string_view validator,
+		      const char *uri, TagHandler &handler) const noexcept
+{
+	std::vector<char> buffer;
+	if (!IsEnabled() || !ReadFile(GetPath(key), buffer))
+		return false;
+
+	bool found = false;
+	if (!ParseFile(buffer, validator, [&](std::string_view song_uri, Tag &&tag){
+		if (song_uri != uri)
+			return true;
+
+		if (!tag.duration.IsNegative())
+			handler.OnDuration(SongTime(tag.duration));
+		for (const auto &item : tag)
+			handler.OnTag(item.type, item.value);
+		found = true;
+		return false;
+	}))
+		return false;
+
+	return found;
+}
+
+void
+DiscScanCache::Store(const char *key, std::string_view validator,
+		     const std::forward_list<DetachedSong> &songs) const noexcept
+{
+	if (!IsEnabled())
+		return;
+
+	CacheWriter writer;
+	writer.WriteString(validator);
+	writer.WriteU32(std::distance(songs.begin(), songs.end()));
+	for (const auto &song : songs) {
+		const auto &tag = song.GetTag();
+		writer.WriteString(song.GetURI());
+		writer.WriteU32(uint32_t(tag.duration.ToMS()));
+		writer.WriteU32(tag.num_items);
+		for (const auto &item : tag) {
+			writer.WriteU32(item.type);
+			writer.WriteString(item.value);
+		}
+	}
+
+	try {
+		/* written to a temporary file and renamed on Commit(),
+		   so concurrent readers never see a partial entry */
+		FileOutputStream file(GetPath(key));
+		file.Write(writer.GetBuffer().data(), writer.GetBuffer().size());
+		file.Commit();
+	} catch (...) {
+		LogError(std::current_exception(), "Failed to write disc scan cache");
+	}
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2003-2022 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DECODER_DISC_SCAN_CACHE_HXX
+#define MPD_DECODER_DISC_SCAN_CACHE_HXX
+
+#include "fs/AllocatedPath.hxx"
+
+#include <forward_list>
+#include <string_view>
+
+class DetachedSong;
+class TagHandler;
+
+/**
+ * A persistent on-disk cache of container scan results (the virtual
+ * track list and tags) of disc images, so that rescanning an
+ * unmodified disc does not require parsing its TOC and text again.
+ *
+ * Each disc is stored in a small binary file named after a key which
+ * identifies the disc contents (e.g. a hash of its master TOC).  The
+ * caller also passes a "validator" string describing everything else
+ * the scan result depends on (file size and modification time, plugin
+ * settings, external tag files); an entry whose validator differs is
+ * ignored and overwritten by the next Store().
+ *
+ * The cache is disabled if no directory is configured.  Errors are
+ * logged and otherwise ignored; the caller then just scans the disc.
+ */
+class DiscScanCache {
+	AllocatedPath directory = nullptr;
+
+public:
+	void SetDirectory(AllocatedPath &&_directory) noexcept {
+		directory = std::move(_directory);
+	}
+
+	bool IsEnabled() const noexcept {
+		return !directory.IsNull();
+	}
+
+	/**
+	 * Load the songs stored for the given disc.
+	 *
+	 * @return false if there is no valid entry
+	 */
+	bool Load(const char *key, std::string_view validator,
+		  std::forward_list<DetachedSong> &songs) const noexcept;
+
+	/**
+	 * Pass the tag of the stored song with the given URI to the
+	 * #TagHandler.
+	 *
+	 * @return false if there is no valid entry or it does not
+	 * contain the song
+	 */
+	bool Lookup(const char *key, std::string_view validator,
+		    const char *uri, TagHandler &handler) const noexcept;
+
+	void Store(const char *key, std::string_view validator,
+		   const std::forward_list<DetachedSong> &songs) const noexcept;
+
+private:
+	AllocatedPath GetPath(const char *key) const noexcept;
+};
+
+#endif
@@ -351,13 +351,6 @@ dsdiff_read_metadata(DecoderClient *client, InputStream &is,
 	}
 }
 
-static void
-bit_reverse_buffer(uint8_t *p, uint8_t *end)
-{
-	for (; p < end; ++p)
-		*p = bit_reverse(*p);
-}
-
 static offset_type
 FrameToOffset(uint64_t frame, unsigned channels)
 {
@@ -416,7 +409,7 @@ dsdiff_decode_chunk(DecoderClient &client, InputStream &is,
 		remaining_bytes -= nbytes;
 
 		if (lsbitfirst)
-			bit_reverse_buffer(buffer, buffer + nbytes);
+			BitReverse(buffer, nbytes);
 
 		cmd = client.SubmitData(is, buffer, nbytes,
 					kbit_rate);
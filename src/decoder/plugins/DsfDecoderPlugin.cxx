@@ -180,13 +180,6 @@ dsf_read_metadata(DecoderClient *client, InputStream &is,
 	return true;
 }
 
-static void
-bit_reverse_buffer(uint8_t *p, uint8_t *end)
-{
-	for (; p < end; ++p)
-		*p = bit_reverse(*p);
-}
-
 static void
 InterleaveDsfBlockMono(uint8_t *gcc_restrict dest,
 		       const uint8_t *gcc_restrict src)
@@ -284,7 +277,7 @@ dsf_decode_chunk(DecoderClient &client, InputStream &is,
 			return false;
 
 		if (bitreverse)
-			bit_reverse_buffer(buffer, buffer + block_size);
+			BitReverse(buffer, block_size);
 
 		uint8_t interleaved_buffer[MAX_CHANNELS * DSF_BLOCK_SIZE];
 		InterleaveDsfBlock(interleaved_buffer, buffer, channels);
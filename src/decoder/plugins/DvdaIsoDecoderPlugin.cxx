@@ -25,6 +25,7 @@
 #include <dvda_disc.h>
 #include <dvda_metabase.h>
 #include "DvdaIsoDecoderPlugin.hxx"
+#include "DiscCache.hxx"
 #include "../DecoderAPI.hxx"
 #include "input/InputStream.hxx"
 #include "pcm/CheckAudioFormat.hxx"
@@ -32,8 +33,6 @@
 #include "tag/Builder.hxx"
 #include "song/DetachedSong.hxx"
 #include "fs/Path.hxx"
-#include "fs/AllocatedPath.hxx"
-#include "fs/FileSystem.hxx"
 #include "thread/Cond.hxx"
 #include "thread/Mutex.hxx"
 #include "util/BitReverse.hxx"
@@ -46,7 +45,9 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <atomic>
 #include <memory>
+#include <thread>
 #include <vector>
 
 static constexpr Domain dvdaiso_domain("dvdaiso");
@@ -63,92 +64,122 @@ chmode_t    param_playable_area;
 std::string param_tags_path;
 bool        param_tags_with_iso;
 bool        param_use_stdio;
+unsigned    param_decode_ahead;
 
-AllocatedPath                    dvda_path{ nullptr };
-std::unique_ptr<dvda_media_t>    dvda_media;
-std::unique_ptr<dvda_reader_t>   dvda_reader;
-std::unique_ptr<dvda_metabase_t> dvda_metabase;
+/**
+ * A parsed DVD-Audio image shared through #dvda_cache.  It is never
+ * modified after open_iso(), decoders and scanners access it through
+ * their own #dvda_cursor_t.
+ */
+struct dvda_iso_t {
+	std::unique_ptr<dvda_media_t>    media;
+	std::unique_ptr<dvda_disc_t>     disc;
+	std::unique_ptr<dvda_metabase_t> metabase;
+};
 
-static bool
-get_subsong(Path path_fs, unsigned& index, bool& downmix) {
-	auto ptr = path_fs.GetBase().c_str();
-	char area = '\0';
-	char suffix[4];
-	auto params = sscanf(ptr, DVDA_TRACKXXX_FMT, &index, &area, suffix);
-	index--;
-	downmix = area == 'D';
-	return params == 3;
-}
+/**
+ * Per-decode (or per-scan) view of a cached #dvda_iso_t with its own
+ * track selection, stream buffers, audio decoder and media handle.
+ */
+struct dvda_cursor_t {
+	std::shared_ptr<dvda_iso_t>   iso;
+	std::unique_ptr<dvda_media_t> media;
+	dvda_disc_t                   reader;
+};
 
-static bool
-container_update(Path path_fs) {
-	auto curr_path = AllocatedPath(path_fs);
-	if (dvda_path == curr_path) {
-		return true;
+DiscCache<dvda_iso_t> dvda_cache;
+
+static std::unique_ptr<dvda_media_t>
+new_media() {
+	if (param_use_stdio) {
+		return std::make_unique<dvda_media_file_t>();
 	}
-	if (dvda_reader) {
-		dvda_reader->close();
-		dvda_reader.reset();
+	return std::make_unique<dvda_media_stream_t>();
+}
+
+static std::shared_ptr<dvda_iso_t>
+open_iso(Path path_fs) {
+	auto iso = std::make_shared<dvda_iso_t>();
+	iso->media = new_media();
+	iso->disc = std::make_unique<dvda_disc_t>();
+	if (!iso->media->open(path_fs.c_str())) {
+		std::string err;
+		err  = "dvda_media->open('";
+		err += path_fs.c_str();
+		err += "') failed";
+		LogWarning(dvdaiso_domain, err.c_str());
+		return nullptr;
 	}
-	if (dvda_media) {
-		dvda_media->close();
-		dvda_media.reset();
+	if (!iso->disc->open(iso->media.get())) {
+		//LogWarning(dvdaiso_domain, "dvda_reader->open(...) failed");
+		return nullptr;
 	}
-	dvda_metabase.reset();
-	dvda_path.SetNull();
-	if (FileExists(curr_path)) {
-		if (param_use_stdio) {
-			dvda_media = std::make_unique<dvda_media_file_t>();
-		}
-		else {
-			dvda_media = std::make_unique<dvda_media_stream_t>();
+	if (!param_tags_path.empty() || param_tags_with_iso) {
+		std::string tags_file;
+		if (param_tags_with_iso) {
+			tags_file = path_fs.c_str();
+			tags_file.resize(tags_file.rfind('.') + 1);
+			tags_file.append("xml");
 		}
-		if (!dvda_media) {
-			LogError(dvdaiso_domain, "new dvda_media_t() failed");
-			return false;
-		}
-		dvda_reader = std::make_unique<dvda_disc_t>();
-		if (!dvda_reader) {
-			LogError(dvdaiso_domain, "new dvda_disc_t() failed");
-			return false;
-		}
-		if (!dvda_media->open(curr_path.c_str())) {
+		iso->metabase = std::make_unique<dvda_metabase_t>(iso->disc.get(), param_tags_path.empty() ? nullptr : param_tags_path.c_str(), tags_file.empty() ? nullptr : tags_file.c_str());
+	}
+	return iso;
+}
+
+/**
+ * Obtain a cursor on the (cached) disc at the given path.  Only
+ * cursors which read audio need their own media handle; scanners
+ * just query the shared track list.
+ */
+static std::unique_ptr<dvda_cursor_t>
+open_cursor(Path path_fs, bool with_media) {
+	auto iso = dvda_cache.Get(path_fs, open_iso);
+	if (!iso) {
+		return nullptr;
+	}
+	auto cursor = std::make_unique<dvda_cursor_t>();
+	cursor->iso = std::move(iso);
+	if (with_media) {
+		cursor->media = new_media();
+		if (!cursor->media->open(path_fs.c_str())) {
 			std::string err;
 			err  = "dvda_media->open('";
-			err += curr_path.c_str();
+			err += path_fs.c_str();
 			err += "') failed";
 			LogWarning(dvdaiso_domain, err.c_str());
-			return false;
-		}
-		if (!dvda_reader->open(dvda_media.get())) {
-			//LogWarning(dvdaiso_domain, "dvda_reader->open(...) failed");
-			return false;
-		}
-		if (!param_tags_path.empty() || param_tags_with_iso) {
-			std::string tags_file;
-			if (param_tags_with_iso) {
-				tags_file = curr_path.c_str();
-				tags_file.resize(tags_file.rfind('.') + 1);
-				tags_file.append("xml");
-			}
-			dvda_metabase = std::make_unique<dvda_metabase_t>(reinterpret_cast<dvda_disc_t*>(dvda_reader.get()), param_tags_path.empty() ? nullptr : param_tags_path.c_str(), tags_file.empty() ? nullptr : tags_file.c_str());
+			return nullptr;
 		}
-		dvda_path = curr_path;
 	}
-	return static_cast<bool>(dvda_reader);;
+	if (!cursor->reader.open(cursor->media.get(), cursor->iso->disc.get())) {
+		return nullptr;
+	}
+	return cursor;
+}
+
+static bool
+get_subsong(Path path_fs, unsigned& index, bool& downmix) {
+	auto ptr = path_fs.GetBase().c_str();
+	char area = '\0';
+	char suffix[4];
+	auto params = sscanf(ptr, DVDA_TRACKXXX_FMT, &index, &area, suffix);
+	index--;
+	downmix = area == 'D';
+	return params == 3;
 }
 
 static void
-scan_info(unsigned track_index, bool downmix, TagHandler& handler) {
+scan_info(dvda_cursor_t& cursor, unsigned track_index, bool downmix, TagHandler& handler) {
+	auto& reader = cursor.reader;
+	auto metabase = cursor.iso->metabase.get();
 	auto tag_value = std::to_string(track_index + 1);
 	handler.OnTag(TAG_TRACK, tag_value.c_str());
-	handler.OnDuration(SongTime::FromS(dvda_reader->get_duration(track_index)));
-	if (!dvda_metabase || (dvda_metabase && !dvda_metabase->get_track_info(track_index + 1, downmix, handler))) {
-		dvda_reader->get_info(track_index, downmix, handler);
+	handler.OnDuration(SongTime::FromS(reader.get_duration(track_index)));
+	if (!metabase || (metabase && !metabase->get_track_info(track_index + 1, downmix, handler))) {
+		reader.get_info(track_index, downmix, handler);
 	}
 	if (handler.WantPicture()) {
-		if (dvda_metabase) {
-			dvda_metabase->get_albumart(handler);
+		if (metabase) {
+			metabase->get_albumart(handler);
 		}
 	}
 }
@@ -172,21 +203,25 @@ init(const ConfigBlock& block) {
 	param_tags_path = block.GetBlockValue("tags_path", "");
 	param_tags_with_iso = block.GetBlockValue("tags_with_iso", false);
 	param_use_stdio = block.GetBlockValue("use_stdio", true);
+	param_decode_ahead = block.GetBlockValue("decode_ahead", std::thread::hardware_concurrency() > 1 ? 4u : 0u);
+	dvda_cache.SetCapacity(block.GetBlockValue("disc_cache_size", 4u));
 	return true;
 }
 
 static void
 finish() noexcept {
-	container_update(nullptr);
+	dvda_cache.Clear();
 	my_av_log_set_default_callback();
 }
 
 static std::forward_list<DetachedSong>
 container_scan(Path path_fs) {
 	std::forward_list<DetachedSong> list;
-	if (!container_update(path_fs)) {
+	auto cursor = open_cursor(path_fs, false);
+	if (!cursor) {
 		return list;
 	}
+	auto dvda_reader = &cursor->reader;
 	TagBuilder tag_builder;
 	auto tail = list.before_begin();
 	auto suffix = path_fs.GetSuffix();
@@ -221,7 +256,7 @@ container_scan(Path path_fs) {
 			}
 			if (add_track) {
 				AddTagHandler h(tag_builder);
-				scan_info(track_index, false, h);
+				scan_info(*cursor, track_index, false, h);
 				auto area = dvda_reader->get_channels() > 2 ? 'M' : 'S';
 				tail = list.emplace_after(
 					tail,
@@ -231,7 +266,7 @@ container_scan(Path path_fs) {
 			}
 			if (add_downmix) {
 				AddTagHandler h(tag_builder);
-				scan_info(track_index, true, h);
+				scan_info(*cursor, track_index, true, h);
 				auto area = 'D';
 				tail = list.emplace_after(
 					tail,
@@ -247,11 +282,175 @@ container_scan(Path path_fs) {
 	return list;
 }
 
+/**
+ * Decodes PCM frames of a #dvda_disc_t on a worker thread into a ring
+ * of buffers, so that demultiplexing and MLP decoding of the next
+ * frames overlap the submission of the current one.  While the worker
+ * runs, it owns the reader; Pause() hands it back to the caller (e.g.
+ * for a seek).
+ */
+class DecodeAhead {
+public:
+	struct Buffer {
+		std::vector<uint8_t> data;
+		size_t size = 0;
+	};
+
+private:
+	/**
+	 * Space to leave for one more read_frame() call: an MLP access
+	 * unit decodes to at most 160 samples of 8 channels of 32 bits,
+	 * an LPCM block to at most 4096 bytes.
+	 */
+	static constexpr size_t MAX_FRAME_SIZE = 8192;
+
+	dvda_disc_t& reader;
+
+	Mutex mutex;
+	Cond worker_cond;
+	Cond client_cond;
+
+	std::vector<Buffer> buffers;
+
+	/**
+	 * The oldest filled buffer and the number of filled buffers;
+	 * the worker fills buffers[(head + count) % size] without
+	 * holding the lock.
+	 */
+	size_t head = 0, count = 0;
+
+	/**
+	 * Set while the worker may call the reader; cleared by
+	 * Pause() to make it stop after the current frame.
+	 */
+	std::atomic_bool running{false};
+
+	/**
+	 * The worker is decoding into a buffer.
+	 */
+	bool decoding = false;
+
+	/**
+	 * The reader has no more frames.
+	 */
+	bool eof = false;
+
+	bool quit = false;
+
+	std::thread thread;
+
+public:
+	DecodeAhead(dvda_disc_t& _reader, unsigned n_buffers, size_t buffer_size)
+		:reader(_reader), buffers(n_buffers) {
+		for (auto& buffer : buffers) {
+			buffer.data.resize(buffer_size);
+		}
+		thread = std::thread(&DecodeAhead::Run, this);
+	}
+
+	~DecodeAhead() noexcept {
+		{
+			const std::lock_guard<Mutex> lock(mutex);
+			running = false;
+			quit = true;
+			worker_cond.notify_one();
+		}
+		thread.join();
+	}
+
+	DecodeAhead(const DecodeAhead&) = delete;
+	DecodeAhead& operator=(const DecodeAhead&) = delete;
+
+	/**
+	 * Start (or resume after Pause()) decoding at the current
+	 * position of the reader.
+	 */
+	void Start() noexcept {
+		const std::lock_guard<Mutex> lock(mutex);
+		running = true;
+		worker_cond.notify_one();
+	}
+
+	/**
+	 * Stop decoding and discard all buffers.  After return, the
+	 * worker does not touch the reader until the next Start().
+	 */
+	void Pause() noexcept {
+		std::unique_lock<Mutex> lock(mutex);
+		running = false;
+		client_cond.wait(lock, [this]{ return !decoding; });
+		head = count = 0;
+		eof = false;
+	}
+
+	/**
+	 * Wait for the oldest filled buffer.
+	 *
+	 * @return the buffer or nullptr at the end of the track
+	 */
+	const Buffer* Front() noexcept {
+		std::unique_lock<Mutex> lock(mutex);
+		client_cond.wait(lock, [this]{ return count > 0 || eof; });
+		return count > 0 ? &buffers[head] : nullptr;
+	}
+
+	/**
+	 * Return the buffer obtained by Front() to the worker.
+	 */
+	void Pop() noexcept {
+		const std::lock_guard<Mutex> lock(mutex);
+		assert(count > 0);
+		head = (head + 1) % buffers.size();
+		--count;
+		worker_cond.notify_one();
+	}
+
+private:
+	void Run() noexcept {
+		std::unique_lock<Mutex> lock(mutex);
+		while (!quit) {
+			if (!running || eof || count == buffers.size()) {
+				worker_cond.wait(lock);
+				continue;
+			}
+
+			auto& buffer = buffers[(head + count) % buffers.size()];
+			decoding = true;
+			lock.unlock();
+
+			bool more = true;
+			buffer.size = 0;
+			while (running && buffer.data.size() - buffer.size >= MAX_FRAME_SIZE) {
+				auto frame_size = buffer.data.size() - buffer.size;
+				if (!reader.read_frame(buffer.data.data() + buffer.size, &frame_size)) {
+					more = false;
+					break;
+				}
+				buffer.size += frame_size;
+			}
+
+			lock.lock();
+			decoding = false;
+			if (running) {
+				if (buffer.size > 0) {
+					++count;
+				}
+				if (!more) {
+					eof = true;
+				}
+			}
+			client_cond.notify_one();
+		}
+	}
+};
+
 static void
 file_decode(DecoderClient &client, Path path_fs) {
-	if (!container_update(path_fs.GetDirectoryName())) {
+	auto cursor = open_cursor(path_fs.GetDirectoryName(), true);
+	if (!cursor) {
 		return;
 	}
+	auto dvda_reader = &cursor->reader;
 	unsigned track;
 	bool downmix;
 	if (!get_subsong(path_fs, track, downmix)) {
@@ -270,44 +469,75 @@ file_decode(DecoderClient &client, Path path_fs) {
 	}
 	auto samplerate = dvda_reader->get_samplerate();
 	auto channels = dvda_reader->get_downmix() ? 2u : dvda_reader->get_channels();
+	// 16 bit streams are decoded to 16 bit samples, 20 and 24 bit streams
+	// to left aligned 32 bit samples
+	auto sample_format = dvda_reader->get_bits() > 16 ? SampleFormat::S32 : SampleFormat::S16;
 	std::vector<uint8_t> pcm_data(192000);
 
 	// initialize decoder
-	auto audio_format = CheckAudioFormat(samplerate, SampleFormat::S32, channels);
+	auto audio_format = CheckAudioFormat(samplerate, sample_format, channels);
 	auto songtime = SongTime::FromS(dvda_reader->get_duration(track));
 	client.Ready(audio_format, true, songtime);
 
+	// decode ahead on a worker thread, or here between submissions
+	std::unique_ptr<DecodeAhead> decode_ahead;
+	if (param_decode_ahead > 0) {
+		decode_ahead = std::make_unique<DecodeAhead>(*dvda_reader, param_decode_ahead, pcm_data.size());
+		decode_ahead->Start();
+	}
+
 	// play
 	auto cmd = client.GetCommand();
 	for (;;) {
-		auto pcm_size = pcm_data.size();
-		if (dvda_reader->read_frame(pcm_data.data(), &pcm_size)) {
-			if (pcm_size > 0) {
-				cmd = client.SubmitData(nullptr, pcm_data.data(), pcm_size, channels * samplerate / 1000);
-				if (cmd == DecoderCommand::STOP) {
-					break;
-				}
-				if (cmd == DecoderCommand::SEEK) {
-					auto seconds = client.GetSeekTime().ToDoubleS();
-					if (dvda_reader->seek(seconds)) {
-						client.CommandFinished();
-					}
-					else {
-						client.SeekError();
-					}
-					cmd = client.GetCommand();
-				}
+		const uint8_t* pcm_ptr;
+		size_t pcm_size;
+		if (decode_ahead) {
+			auto buffer = decode_ahead->Front();
+			if (!buffer) {
+				break;
 			}
+			pcm_ptr = buffer->data.data();
+			pcm_size = buffer->size;
 		}
 		else {
-			break;
+			pcm_ptr = pcm_data.data();
+			pcm_size = pcm_data.size();
+			if (!dvda_reader->read_frame(pcm_data.data(), &pcm_size)) {
+				break;
+			}
+		}
+		if (pcm_size > 0) {
+			cmd = client.SubmitData(nullptr, pcm_ptr, pcm_size, channels * samplerate / 1000);
+			if (decode_ahead) {
+				decode_ahead->Pop();
+			}
+			if (cmd == DecoderCommand::STOP) {
+				break;
+			}
+			if (cmd == DecoderCommand::SEEK) {
+				if (decode_ahead) {
+					decode_ahead->Pause();
+				}
+				auto seconds = client.GetSeekTime().ToDoubleS();
+				if (dvda_reader->seek(seconds)) {
+					client.CommandFinished();
+				}
+				else {
+					client.SeekError();
+				}
+				if (decode_ahead) {
+					decode_ahead->Start();
+				}
+				cmd = client.GetCommand();
+			}
 		}
 	}
 }
 
 static bool
 scan_file(Path path_fs, TagHandler& handler) noexcept {
-	if (!container_update(path_fs.GetDirectoryName())) {
+	auto cursor = open_cursor(path_fs.GetDirectoryName(), false);
+	if (!cursor) {
 		return false;
 	}
 	unsigned track_index;
@@ -316,7 +546,7 @@ scan_file(Path path_fs, TagHandler& handler) noexcept {
 		LogError(dvdaiso_domain, "cannot get track number");
 		return false;
 	}
-	scan_info(track_index, downmix, handler);
+	scan_info(*cursor, track_index, downmix, handler);
 	return true;
 }
 
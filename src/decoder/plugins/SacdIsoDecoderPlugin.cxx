@@ -25,15 +25,18 @@
 #include <dst_decoder_mt.h>
 #undef MAX_CHANNELS
 #include "SacdIsoDecoderPlugin.hxx"
+#include "DiscCache.hxx"
+#include "DiscScanCache.hxx"
 #include "../DecoderAPI.hxx"
+#include "config/Block.hxx"
+#include "config/Parser.hxx"
 #include "input/InputStream.hxx"
 #include "pcm/CheckAudioFormat.hxx"
 #include "tag/Handler.hxx"
 #include "tag/Builder.hxx"
 #include "song/DetachedSong.hxx"
 #include "fs/Path.hxx"
-#include "fs/AllocatedPath.hxx"
-#include "fs/FileSystem.hxx"
+#include "fs/FileInfo.hxx"
 #include "thread/Cond.hxx"
 #include "thread/Mutex.hxx"
 #include "util/BitReverse.hxx"
@@ -62,95 +65,188 @@ area_id_e   param_playable_area;
 std::string param_tags_path;
 bool        param_tags_with_iso;
 bool        param_use_stdio;
+bool        param_use_mmap;
+size_t      param_read_ahead;
 
-AllocatedPath                    sacd_path{ nullptr };
-std::unique_ptr<sacd_media_t>    sacd_media;
-std::unique_ptr<sacd_reader_t>   sacd_reader;
-std::unique_ptr<sacd_metabase_t> sacd_metabase;
+/**
+ * A parsed SACD image shared through #sacd_cache.  It is never
+ * modified after open_iso(), decoders and scanners access it through
+ * their own #sacd_cursor_t.
+ */
+struct sacd_iso_t {
+	std::unique_ptr<sacd_media_t>    media;
+	std::unique_ptr<sacd_disc_t>     disc;
+	std::unique_ptr<sacd_metabase_t> metabase;
+};
 
-static unsigned
-get_subsong(Path path_fs) {
-	auto ptr = path_fs.GetBase().c_str();
-	char area = '\0';
-	unsigned index = 0;
-	char suffix[4];
-	auto params = sscanf(ptr, SACD_TRACKXXX_FMT, &area, &index, suffix);
-	if (area == 'M') {
-		index += sacd_reader->get_tracks(AREA_TWOCH);
+/**
+ * Per-decode (or per-scan) view of a cached #sacd_iso_t with its own
+ * area/track selection, read position and media handle.
+ */
+struct sacd_cursor_t {
+	std::shared_ptr<sacd_iso_t>   iso;
+	std::unique_ptr<sacd_media_t> media;
+	sacd_disc_t                   reader;
+};
+
+DiscCache<sacd_iso_t> sacd_cache;
+DiscScanCache         scan_cache;
+
+static std::unique_ptr<sacd_media_t>
+new_media() {
+	if (param_use_mmap) {
+		return std::make_unique<sacd_media_mmap_t>();
 	}
-	index--;
-	return (params == 3) ? index : 0;
+	if (param_use_stdio) {
+		return std::make_unique<sacd_media_file_t>();
+	}
+	return std::make_unique<sacd_media_stream_t>();
 }
 
-static bool
-container_update(Path path_fs) {
-	auto curr_path = AllocatedPath(path_fs);
-	if (sacd_path == curr_path) {
-		return true;
-	}
-	if (sacd_reader) {
-		sacd_reader->close();
-		sacd_reader.reset();
-	}
-	if (sacd_media) {
-		sacd_media->close();
-		sacd_media.reset();
-	}
-	sacd_metabase.reset();
-	sacd_path.SetNull();
-	if (FileExists(curr_path)) {
-		if (param_use_stdio) {
-			sacd_media = std::make_unique<sacd_media_file_t>();
-		}
-		else {
-			sacd_media = std::make_unique<sacd_media_stream_t>();
-		}
-		if (!sacd_media) {
-			LogError(sacdiso_domain, "new sacd_media_t() failed");
-			return false;
-		}
-		sacd_reader = std::make_unique<sacd_disc_t>();
-		if (!sacd_reader) {
-			LogError(sacdiso_domain, "new sacd_disc_t() failed");
-			return false;
+static std::shared_ptr<sacd_iso_t>
+open_iso(Path path_fs) {
+	auto iso = std::make_shared<sacd_iso_t>();
+	iso->media = new_media();
+	iso->disc = std::make_unique<sacd_disc_t>();
+	if (!iso->media->open(path_fs.c_str())) {
+		std::string err;
+		err  = "sacd_media->open('";
+		err += path_fs.c_str();
+		err += "') failed";
+		LogWarning(sacdiso_domain, err.c_str());
+		return nullptr;
+	}
+	if (!iso->disc->open(iso->media.get())) {
+		//LogWarning(sacdiso_domain, "sacd_reader->open(...) failed");
+		return nullptr;
+	}
+	if (!param_tags_path.empty() || param_tags_with_iso) {
+		std::string tags_file;
+		if (param_tags_with_iso) {
+			tags_file = path_fs.c_str();
+			tags_file.resize(tags_file.rfind('.') + 1);
+			tags_file.append("xml");
 		}
-		if (!sacd_media->open(curr_path.c_str())) {
+		iso->metabase = std::make_unique<sacd_metabase_t>(iso->disc.get(), param_tags_path.empty() ? nullptr : param_tags_path.c_str(), tags_file.empty() ? nullptr : tags_file.c_str());
+	}
+	return iso;
+}
+
+/**
+ * Obtain a cursor on the (cached) disc at the given path.  Only
+ * cursors which read audio need their own media handle; scanners
+ * just query the shared TOC.
+ */
+static std::unique_ptr<sacd_cursor_t>
+open_cursor(Path path_fs, bool with_media) {
+	auto iso = sacd_cache.Get(path_fs, open_iso);
+	if (!iso) {
+		return nullptr;
+	}
+	auto cursor = std::make_unique<sacd_cursor_t>();
+	cursor->iso = std::move(iso);
+	if (with_media) {
+		cursor->media = new_media();
+		if (!cursor->media->open(path_fs.c_str())) {
 			std::string err;
 			err  = "sacd_media->open('";
-			err += curr_path.c_str();
+			err += path_fs.c_str();
 			err += "') failed";
 			LogWarning(sacdiso_domain, err.c_str());
-			return false;
-		}
-		if (!sacd_reader->open(sacd_media.get())) {
-			//LogWarning(sacdiso_domain, "sacd_reader->open(...) failed");
-			return false;
+			return nullptr;
 		}
-		if (!param_tags_path.empty() || param_tags_with_iso) {
-			std::string tags_file;
-			if (param_tags_with_iso) {
-				tags_file = curr_path.c_str();
-				tags_file.resize(tags_file.rfind('.') + 1);
-				tags_file.append("xml");
-			}
-			sacd_metabase = std::make_unique<sacd_metabase_t>(reinterpret_cast<sacd_disc_t*>(sacd_reader.get()), param_tags_path.empty() ? nullptr : param_tags_path.c_str(), tags_file.empty() ? nullptr : tags_file.c_str());
-		}
-		sacd_path = curr_path;
 	}
-	return static_cast<bool>(sacd_reader);
+	if (!cursor->reader.open(cursor->media.get(), cursor->iso->disc.get())) {
+		return nullptr;
+	}
+	cursor->reader.set_read_ahead(param_read_ahead);
+	return cursor;
+}
+
+static std::string
+get_mtime_string(Path path_fs) {
+	FileInfo info;
+	if (!GetFileInfo(path_fs, info)) {
+		return "-";
+	}
+	return std::to_string(info.GetModificationTime().time_since_epoch().count());
+}
+
+/**
+ * Identify the disc for #scan_cache: the key is the metabase store id
+ * (MD5 of the master TOC), which costs one small read; the validator
+ * covers the file itself, the settings and the tag files which affect
+ * the scan result.
+ */
+static bool
+get_scan_key(Path path_fs, std::string& key, std::string& validator) {
+	FileInfo info;
+	if (!GetFileInfo(path_fs, info) || !info.IsRegular()) {
+		return false;
+	}
+	auto media = new_media();
+	if (!media->open(path_fs.c_str())) {
+		return false;
+	}
+	sacd_disc_t disc;
+	if (!disc.probe(media.get())) {
+		return false;
+	}
+	key = sacd_metabase_t::get_store_id(&disc);
+	if (key.empty()) {
+		return false;
+	}
+	validator  = std::to_string(info.GetSize());
+	validator += ":";
+	validator += std::to_string(info.GetModificationTime().time_since_epoch().count());
+	validator += ":";
+	validator += std::to_string(unsigned(param_playable_area));
+	validator += ":";
+	validator += path_fs.GetSuffix() ? path_fs.GetSuffix() : "";
+	if (!param_tags_path.empty()) {
+		auto store_file = param_tags_path + "/" + key + ".xml";
+		validator += ":";
+		validator += store_file;
+		validator += ":";
+		validator += get_mtime_string(Path::FromFS(store_file.c_str()));
+	}
+	if (param_tags_with_iso) {
+		std::string tags_file = path_fs.c_str();
+		tags_file.resize(tags_file.rfind('.') + 1);
+		tags_file.append("xml");
+		validator += ":";
+		validator += get_mtime_string(Path::FromFS(tags_file.c_str()));
+	}
+	return true;
+}
+
+static unsigned
+get_subsong(sacd_reader_t& reader, Path path_fs) {
+	auto ptr = path_fs.GetBase().c_str();
+	char area = '\0';
+	unsigned index = 0;
+	char suffix[4];
+	auto params = sscanf(ptr, SACD_TRACKXXX_FMT, &area, &index, suffix);
+	if (area == 'M') {
+		index += reader.get_tracks(AREA_TWOCH);
+	}
+	index--;
+	return (params == 3) ? index : 0;
 }
 
 static void
-scan_info(unsigned track, unsigned track_index, TagHandler& handler) {
+scan_info(sacd_cursor_t& cursor, unsigned track, unsigned track_index, TagHandler& handler) {
+	auto& reader = cursor.reader;
+	auto metabase = cursor.iso->metabase.get();
 	auto tag_value = std::to_string(track + 1);
 	handler.OnTag(TAG_TRACK, tag_value.c_str());
-	handler.OnDuration(SongTime::FromS(sacd_reader->get_duration(track)));
-	if (!sacd_metabase || (sacd_metabase && !sacd_metabase->get_track_info(track_index + 1, handler))) {
-		sacd_reader->get_info(track, handler);
+	handler.OnDuration(SongTime::FromS(reader.get_duration(track)));
+	if (!metabase || (metabase && !metabase->get_track_info(track_index + 1, handler))) {
+		reader.get_info(track, handler);
 	}
 	if (handler.WantPicture()) {
-		if (sacd_metabase) {
-			sacd_metabase->get_albumart(handler);
+		if (metabase) {
+			metabase->get_albumart(handler);
 		}
 	}
 }
@@ -173,20 +269,37 @@ init(const ConfigBlock& block) {
 	param_tags_path = block.GetBlockValue("tags_path", "");
 	param_tags_with_iso = block.GetBlockValue("tags_with_iso", false);
 	param_use_stdio = block.GetBlockValue("use_stdio", true);
+	param_use_mmap = block.GetBlockValue("use_mmap", false);
+	param_read_ahead = SACD_READ_AHEAD_SIZE;
+	if (auto read_ahead = block.GetBlockParam("read_ahead")) {
+		param_read_ahead = read_ahead->With([](const char* s) {
+			return ParseSize(s);
+		});
+	}
+	sacd_cache.SetCapacity(block.GetBlockValue("disc_cache_size", 4u));
+	scan_cache.SetDirectory(block.GetPath("scan_cache_path"));
 	return true;
 }
 
 static void
 finish() noexcept {
-	container_update(nullptr);
+	sacd_cache.Clear();
 }
 
 static std::forward_list<DetachedSong>
 container_scan(Path path_fs) {
 	std::forward_list<DetachedSong> list;
-	if (!container_update(path_fs)) {
+	std::string scan_key, scan_validator;
+	if (scan_cache.IsEnabled() && get_scan_key(path_fs, scan_key, scan_validator)) {
+		if (scan_cache.Load(scan_key.c_str(), scan_validator, list)) {
+			return list;
+		}
+	}
+	auto cursor = open_cursor(path_fs, false);
+	if (!cursor) {
 		return list;
 	}
+	auto sacd_reader = &cursor->reader;
 	TagBuilder tag_builder;
 	auto tail = list.before_begin();
 	auto suffix = path_fs.GetSuffix();
@@ -196,7 +309,7 @@ container_scan(Path path_fs) {
 		sacd_reader->select_area(AREA_TWOCH);
 		for (auto track = 0u; track < twoch_count; track++) {
 			AddTagHandler handler(tag_builder);
-			scan_info(track, track, handler);
+			scan_info(*cursor, track, track, handler);
 			tail = list.emplace_after(
 				tail,
 				StringFormat<64>(SACD_TRACKXXX_FMT, '2', track + 1, suffix),
@@ -208,7 +321,7 @@ container_scan(Path path_fs) {
 		sacd_reader->select_area(AREA_MULCH);
 		for (auto track = 0u; track < mulch_count; track++) {
 			AddTagHandler handler(tag_builder);
-			scan_info(track, track + twoch_count, handler);
+			scan_info(*cursor, track, track + twoch_count, handler);
 			tail = list.emplace_after(
 				tail,
 				StringFormat<64>(SACD_TRACKXXX_FMT, 'M', track + 1, suffix),
@@ -216,23 +329,46 @@ container_scan(Path path_fs) {
 			);
 		}
 	}
+	if (!scan_key.empty()) {
+		scan_cache.Store(scan_key.c_str(), scan_validator, list);
+	}
 	return list;
 }
 
-static void
-bit_reverse_buffer(uint8_t* p, uint8_t* end) {
-	for (; p < end; ++p) {
-		*p = bit_reverse(*p);
+/**
+ * Pass a frame of DSD data to the client, copying it straight into the
+ * music pipe if possible.  Bit reversal needs a writable copy of the
+ * frame, scratch is used for it unless data can be modified in place.
+ */
+static DecoderCommand
+submit_dsd(DecoderClient& client, const uint8_t* data, size_t size, uint16_t kbit_rate, uint8_t* scratch) {
+	auto pipe_data = (uint8_t*)client.GetDataBuffer(size);
+	if (pipe_data) {
+		memcpy(pipe_data, data, size);
+		if (param_lsbitfirst) {
+			BitReverse(pipe_data, size);
+		}
+		return client.CommitData(size, kbit_rate);
 	}
+	if (param_lsbitfirst) {
+		if (data != scratch) {
+			memcpy(scratch, data, size);
+		}
+		BitReverse(scratch, size);
+		data = scratch;
+	}
+	return client.SubmitData(nullptr, data, size, kbit_rate);
 }
 
 static void
 file_decode(DecoderClient &client, Path path_fs) {
-	if (!container_update(path_fs.GetDirectoryName())) {
+	auto cursor = open_cursor(path_fs.GetDirectoryName(), true);
+	if (!cursor) {
 		return;
 	}
+	auto sacd_reader = &cursor->reader;
 
-	auto track = get_subsong(path_fs);
+	auto track = get_subsong(*sacd_reader, path_fs);
 
 	// initialize reader
 	sacd_reader->set_emaster(param_edited_master);
@@ -259,11 +395,10 @@ file_decode(DecoderClient &client, Path path_fs) {
 	auto dsd_samplerate = sacd_reader->get_samplerate();
 	auto dsd_framerate = sacd_reader->get_framerate();
 	auto dsd_buf_size = dsd_samplerate / 8 / dsd_framerate * dsd_channels;
-	auto dst_buf_size = dsd_samplerate / 8 / dsd_framerate * dsd_channels;
 	std::vector<uint8_t> dsd_buf;
-	std::vector<uint8_t> dst_buf;
 	dsd_buf.resize(param_dstdec_threads * dsd_buf_size);
-	dst_buf.resize(param_dstdec_threads * dst_buf_size);
+	// DST frames stay in the reader's frame spans while they are decoded
+	sacd_reader->set_frame_spans(param_dstdec_threads, dsd_buf_size);
 
 	// initialize decoder
 	AudioFormat audio_format = CheckAudioFormat(dsd_samplerate / 8, SampleFormat::DSD, dsd_channels);
@@ -272,23 +407,39 @@ file_decode(DecoderClient &client, Path path_fs) {
 
 	// play
 	uint8_t* dsd_data;
-	uint8_t* dst_data;
 	size_t dsd_size = 0;
-	size_t dst_size = 0;
 	dst_decoder_t* dst_decoder = nullptr;
 	auto cmd = client.GetCommand();
 	for (;;) {
 		auto slot_nr = dst_decoder ? dst_decoder->get_slot_nr() : 0;
 		dsd_data = dsd_buf.data() + dsd_buf_size * slot_nr;
-		dst_data = dst_buf.data() + dst_buf_size * slot_nr;
-		dst_size = dst_buf_size;
+		const uint8_t* frame_data;
+		size_t frame_size = dsd_buf_size;
 		frame_type_e frame_type;
-		if (sacd_reader->read_frame(dst_data, &dst_size, &frame_type)) {
-			if (dst_size > 0) {
+		// plain DSD frames are assembled right in the music pipe
+		auto pipe_data = sacd_reader->is_dst() ? nullptr : (uint8_t*)client.GetDataBuffer(dsd_buf_size);
+		if (pipe_data) {
+			if (!sacd_reader->read_frame(pipe_data, &frame_size, &frame_type)) {
+				client.CommitData(0, 0);
+				break;
+			}
+			if (frame_size > 0 && frame_type != FRAME_DSD) {
+				frame_size = dsd_buf_size;
+				memset(pipe_data, 0xAA, frame_size);
+			}
+			if (param_lsbitfirst) {
+				BitReverse(pipe_data, frame_size);
+			}
+			cmd = client.CommitData(frame_size, 8 * frame_size / 1000);
+		}
+		else if (sacd_reader->read_frame_span(&frame_data, &frame_size, &frame_type)) {
+			if (frame_size > 0) {
 				if (frame_type == FRAME_INVALID) {
-					dst_size = dst_buf_size;
-					memset(dst_data, 0xAA, dst_size);
+					frame_size = dsd_buf_size;
+					memset(dsd_data, 0xAA, frame_size);
+					frame_data = dsd_data;
 				}
+				uint16_t kbit_rate = 8 * frame_size / 1000;
 				if (frame_type == FRAME_DST) {
 					if (!dst_decoder) {
 						dst_decoder = new dst_decoder_t(param_dstdec_threads);
@@ -301,34 +452,37 @@ file_decode(DecoderClient &client, Path path_fs) {
 							break;
 						}
 					}
-					dst_decoder->decode(dst_data, dst_size, &dsd_data, &dsd_size);
+					// a single decoding thread returns the frame it was given, so
+					// it can decode right into the music pipe
+					pipe_data = param_dstdec_threads == 1 ? (uint8_t*)client.GetDataBuffer(dsd_buf_size) : nullptr;
+					if (pipe_data) {
+						dsd_data = pipe_data;
+					}
+					dst_decoder->decode(frame_data, frame_size, &dsd_data, &dsd_size);
+					if (pipe_data) {
+						if (param_lsbitfirst) {
+							BitReverse(pipe_data, dsd_size);
+						}
+						cmd = client.CommitData(dsd_size, kbit_rate);
+					}
+					else if (dsd_size > 0) {
+						cmd = submit_dsd(client, dsd_data, dsd_size, kbit_rate, dsd_data);
+					}
 				}
 				else {
-					dsd_data = dst_data;
-					dsd_size = dst_size;
-				}
-				if (dsd_size > 0) {
-					if (param_lsbitfirst) {
-						bit_reverse_buffer(dsd_data, dsd_data + dsd_size);
-					}
-					cmd = client.SubmitData(nullptr, dsd_data, dsd_size, 8 * dst_size / 1000);
+					cmd = submit_dsd(client, frame_data, frame_size, kbit_rate, dsd_data);
 				}
 			}
 		}
 		else {
 			for (;;) {
-				dst_data = nullptr;
-				dst_size = 0;
 				dsd_data = nullptr;
 				dsd_size = 0;
 				if (dst_decoder) {
-					dst_decoder->decode(dst_data, dst_size, &dsd_data, &dsd_size);
+					dst_decoder->decode(nullptr, 0, &dsd_data, &dsd_size);
 				}
 				if (dsd_size > 0) {
-					if (param_lsbitfirst) {
-						bit_reverse_buffer(dsd_data, dsd_data + dsd_size);
-					}
-					cmd = client.SubmitData(nullptr, dsd_data, dsd_size, 0);
+					cmd = submit_dsd(client, dsd_data, dsd_size, 0, dsd_data);
 					if (cmd == DecoderCommand::STOP || cmd == DecoderCommand::SEEK) {
 						break;
 					}
@@ -345,6 +499,9 @@ file_decode(DecoderClient &client, Path path_fs) {
 		if (cmd == DecoderCommand::SEEK) {
 			auto seconds = client.GetSeekTime().ToDoubleS();
 			if (sacd_reader->seek(seconds)) {
+				if (dst_decoder) {
+					dst_decoder->flush();
+				}
 				client.CommandFinished();
 			}
 			else {
@@ -354,6 +511,12 @@ file_decode(DecoderClient &client, Path path_fs) {
 		}
 	}
 	if (dst_decoder) {
+		const auto& stats = dst_decoder->get_stats();
+		if (stats.frames > 0) {
+			FmtDebug(sacdiso_domain, "DST: {} frames, {} us/frame average, {} us/frame max, queue depth {} max",
+				 stats.frames, stats.decode_ns_total / stats.frames / 1000,
+				 stats.decode_ns_max / 1000, stats.queue_depth_max);
+		}
 		delete dst_decoder;
 		dst_decoder = nullptr;
 	}
@@ -361,10 +524,20 @@ file_decode(DecoderClient &client, Path path_fs) {
 
 static bool
 scan_file(Path path_fs, TagHandler& handler) noexcept {
-	if (!container_update(path_fs.GetDirectoryName())) {
+	if (scan_cache.IsEnabled() && !handler.WantPicture()) {
+		std::string scan_key, scan_validator;
+		if (get_scan_key(path_fs.GetDirectoryName(), scan_key, scan_validator)) {
+			if (scan_cache.Lookup(scan_key.c_str(), scan_validator, path_fs.GetBase().c_str(), handler)) {
+				return true;
+			}
+		}
+	}
+	auto cursor = open_cursor(path_fs.GetDirectoryName(), false);
+	if (!cursor) {
 		return false;
 	}
-	auto track_index = get_subsong(path_fs);
+	auto sacd_reader = &cursor->reader;
+	auto track_index = get_subsong(*sacd_reader, path_fs);
 	auto track = track_index;
 	auto twoch_count = sacd_reader->get_tracks(AREA_TWOCH);
 	auto mulch_count = sacd_reader->get_tracks(AREA_MULCH);
@@ -381,7 +554,7 @@ scan_file(Path path_fs, TagHandler& handler) noexcept {
 			return false;
 		}
 	}
-	scan_info(track, track_index, handler);
+	scan_info(*cursor, track, track_index, handler);
 	return true;
 }
 
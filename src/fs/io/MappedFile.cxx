@@ -0,0 +1,70 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MappedFile.hxx"
+#include "io/FileReader.hxx"
+#include "fs/Path.hxx"
+#include "system/Error.hxx"
+
+#include <cstdint>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+MappedFile::MappedFile(Path path)
+{
+	FileReader reader(path);
+
+	const uint64_t file_size = reader.GetSize();
+	if (file_size > SIZE_MAX)
+		throw std::runtime_error("File is too large");
+
+	size = file_size;
+	if (size == 0)
+		return;
+
+#ifdef _WIN32
+	buffer = std::make_unique<std::byte[]>(size);
+	for (std::size_t position = 0; position < size;) {
+		std::size_t nbytes = reader.Read(buffer.get() + position,
+						 size - position);
+		if (nbytes == 0)
+			throw std::runtime_error("Unexpected end of file");
+		position += nbytes;
+	}
+	data = buffer.get();
+#else
+	void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED,
+		       reader.GetFD().Get(), 0);
+	if (p == MAP_FAILED)
+		throw FormatErrno("Failed to map %s", path.ToUTF8().c_str());
+
+	data = p;
+#endif
+}
+
+MappedFile::~MappedFile() noexcept
+{
+#ifndef _WIN32
+	if (data != nullptr)
+		munmap(const_cast<void *>(data), size);
+#endif
+}
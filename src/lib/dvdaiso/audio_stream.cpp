@@ -342,9 +342,44 @@ audio_stream_info_t* pcm_audio_stream_t::get_info(uint8_t* buf, int buf_size) {
 	return this;
 }
 
+// Unpacks the two samples per channel of a group into pack, upper bytes
+// first within the sample (little endian), the first sample of every channel
+// first
+template<int bits, int sample_size>
+static void unpack_group(const uint8_t* inp, int channels, uint8_t* pack) {
+	for (int i = 0; i < 2 * channels; i++) {
+		if (sample_size == 4) {
+			*pack++ = 0;
+			if (bits == 24)
+				*pack++ = inp[4 * channels + i];
+			else if (bits == 20)
+				*pack++ = (i % 2) ? inp[4 * channels + i / 2] << 4 : inp[4 * channels + i / 2] & 0xf0;
+			else
+				*pack++ = 0;
+		}
+		*pack++ = inp[2 * i + 1];
+		*pack++ = inp[2 * i];
+	}
+}
+
+static decltype(&unpack_group<16, 2>) get_unpack_group(int bits, int sample_size) {
+	if (sample_size == 2)
+		return unpack_group<16, 2>;
+	switch (bits) {
+	case 20:
+		return unpack_group<20, 4>;
+	case 24:
+		return unpack_group<24, 4>;
+	default:
+		return unpack_group<16, 4>;
+	}
+}
+
 int pcm_audio_stream_t::init(uint8_t* buf, int buf_size, bool downmix, bool reset_statistics) {
 	if (!get_info(buf, buf_size))
 		return -1;
+	if (group1_bits == 0 || group1_channels == 0 || (group2_channels > 0 && (group2_bits == 0 || group2_samplerate == 0)))
+		return -1;
 	raw_group2_index = 0;
 	raw_group2_factor = group2_channels > 0 ? group1_samplerate / group2_samplerate : 1;
 	raw_group1_size = group1_channels * group1_bits / 4;
@@ -352,6 +387,9 @@ int pcm_audio_stream_t::init(uint8_t* buf, int buf_size, bool downmix, bool rese
 	pcm_sample_size = group1_bits > 16 ? 4 : 2;
 	pcm_group1_size = 2 * group1_channels * pcm_sample_size;
 	pcm_group2_size = 2 * group2_channels * pcm_sample_size;
+	unpack_group1 = get_unpack_group(group1_bits, pcm_sample_size);
+	unpack_group2 = get_unpack_group(group2_bits, pcm_sample_size);
+	unpack_units = (group2_channels == 0 || raw_group2_factor == 1) && unpack.init(group1_channels, group1_bits, group2_channels, group2_bits);
 	do_downmix = downmix;
 	if (downmix)
 		set_downmix_coef();
@@ -365,79 +403,31 @@ int pcm_audio_stream_t::decode(uint8_t* data, int* data_size, uint8_t* buf, int
 	uint8_t* buf_inp = buf;
 	if (buf_size > DVD_BLOCK_SIZE)
 		buf_size = DVD_BLOCK_SIZE;
-	while (buf_inp + raw_group1_size + (raw_group2_index == 0 ? raw_group2_size : 0) <= buf + buf_size) {
-		int pcm_byte_index;
-		pcm_byte_index = 0;
-		if (raw_group2_index == 0) {
-			for (int i = 0; i < 2 * group2_channels; i++) {
-				switch (group2_bits) {
-				case 16:
-					if (group1_bits > 16) {
-						pcm_group2_pack[pcm_byte_index++] = 0;
-						pcm_group2_pack[pcm_byte_index++] = 0;
-					}
-					pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-					pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i];
-					break;
-				case 20:
-					pcm_group2_pack[pcm_byte_index++] = 0;
-					if (i % 2)
-						pcm_group2_pack[pcm_byte_index++] = buf_inp[4 * group2_channels + i / 2] & 0x0f;
-					else
-						pcm_group2_pack[pcm_byte_index++] = buf_inp[4 * group2_channels + i / 2] >> 4;
-					pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-					pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i];
-					break;
-				case 24:
-					pcm_group2_pack[pcm_byte_index++] = 0;
-					pcm_group2_pack[pcm_byte_index++] = buf_inp[4 * group2_channels + i];
-					pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-					pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i];
-					break;
-				default:
-					break;
-				}
-			}
-			buf_inp += raw_group2_size;
-		}
-		raw_group2_index++;
-		if (raw_group2_index == raw_group2_factor)
-			raw_group2_index = 0;
-		pcm_byte_index = 0;
-		for (int i = 0; i < 2 * group1_channels; i++) {
-			switch (group1_bits) {
-			case 16:
-				pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-				pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i];
-				break;
-			case 20:
-				pcm_group1_pack[pcm_byte_index++] = 0;
-				if (i % 2)
-					pcm_group1_pack[pcm_byte_index++] = buf_inp[4 * group1_channels + i / 2] << 4;
-				else
-					pcm_group1_pack[pcm_byte_index++] = buf_inp[4 * group1_channels + i / 2] & 0xf0;
-				pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-				pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i];
-				break;
-			case 24:
-				pcm_group1_pack[pcm_byte_index++] = 0;
-				pcm_group1_pack[pcm_byte_index++] = buf_inp[4 * group1_channels + i];
-				pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-				pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i];
-				break;
-			default:
-				break;
+	if (unpack_units) {
+		size_t units = (buf + buf_size - buf_inp) / unpack.unit_size;
+		buf_out += unpack.unpack(buf_inp, units, buf_out);
+		buf_inp += units * unpack.unit_size;
+	}
+	else {
+		while (buf_inp + raw_group1_size + (raw_group2_index == 0 ? raw_group2_size : 0) <= buf + buf_size) {
+			if (raw_group2_index == 0) {
+				unpack_group2(buf_inp, group2_channels, pcm_group2_pack);
+				buf_inp += raw_group2_size;
 			}
+			raw_group2_index++;
+			if (raw_group2_index == raw_group2_factor)
+				raw_group2_index = 0;
+			unpack_group1(buf_inp, group1_channels, pcm_group1_pack);
+			buf_inp += raw_group1_size;
+			memcpy(buf_out, pcm_group1_pack, pcm_group1_size / 2);
+			buf_out += pcm_group1_size / 2;
+			memcpy(buf_out, pcm_group2_pack, pcm_group2_size / 2);
+			buf_out += pcm_group2_size / 2;
+			memcpy(buf_out, pcm_group1_pack + pcm_group1_size / 2, pcm_group1_size / 2);
+			buf_out += pcm_group1_size / 2;
+			memcpy(buf_out, pcm_group2_pack + pcm_group2_size / 2, pcm_group2_size / 2);
+			buf_out += pcm_group2_size / 2;
 		}
-		buf_inp += raw_group1_size;
-		memcpy(buf_out, pcm_group1_pack, pcm_group1_size / 2);
-		buf_out += pcm_group1_size / 2;
-		memcpy(buf_out, pcm_group2_pack, pcm_group2_size / 2);
-		buf_out += pcm_group2_size / 2;
-		memcpy(buf_out, pcm_group1_pack + pcm_group1_size / 2, pcm_group1_size / 2);
-		buf_out += pcm_group1_size / 2;
-		memcpy(buf_out, pcm_group2_pack + pcm_group2_size / 2, pcm_group2_size / 2);
-		buf_out += pcm_group2_size / 2;
 	}
 	*data_size = buf_out - data;
 	int bytes_decoded = buf_inp - buf;
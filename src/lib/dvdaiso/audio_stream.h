@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include "audio_stream_info.h"
+#include "pcm_unpack.h"
 
 extern "C" {
 #include "avcodec.h"
@@ -130,6 +131,11 @@ public:
 };
 
 class pcm_audio_stream_t : public audio_stream_t {
+	typedef void (*unpack_group_t)(const uint8_t* inp, int channels, uint8_t* pack);
+	unpack_group_t unpack_group1;
+	unpack_group_t unpack_group2;
+	pcm_unpack_t unpack;
+	bool unpack_units; // all units have the same layout, use the byte shuffle
 	int raw_group2_index;
 	int raw_group2_factor;
 	int raw_group1_size;
@@ -36,6 +36,23 @@ int dvda_block_t::get_ps1_info_length(uint8_t* p_substream_buffer, int substream
 	return header_length;
 }
 
+bool dvda_block_t::get_pts(uint8_t* p_block, uint64_t* p_pts) {
+	uint8_t* p_curr = p_block;
+	if (*(uint32_t*)p_curr == 0xba010000) {
+		p_curr += 14 + (p_curr[13] & 0x07);
+		while (p_curr < p_block + DVD_BLOCK_SIZE - 14) {
+			if ((*(uint32_t*)p_curr & 0x00ffffff) != 0x00010000)
+				break;
+			if (p_curr[3] == 0xbd && (p_curr[7] & 0x80)) { // private stream 1 with PTS
+				*p_pts = ((uint64_t)(p_curr[9] & 0x0e) << 29) | (p_curr[10] << 22) | ((p_curr[11] & 0xfe) << 14) | (p_curr[12] << 7) | (p_curr[13] >> 1);
+				return true;
+			}
+			p_curr += 6 + (p_curr[4] << 8) + p_curr[5];
+		}
+	}
+	return false;
+}
+
 void dvda_block_t::get_ps1(uint8_t* p_block, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info) {
 	uint8_t* p_ps1_header;
 	uint8_t* p_ps1_body;
@@ -59,7 +76,8 @@ void dvda_block_t::get_ps1(uint8_t* p_block, uint8_t* p_ps1_buffer, int* p_ps1_o
 							p_ps1_body = p_ps1_header + ps1_header_length;
 							int ps1_body_length = p_ps1_end - p_ps1_body;
 							if (ps1_body_length > 0) {
-								memcpy(p_ps1_buffer + *p_ps1_offset + ps1_offset, p_ps1_body, ps1_body_length);
+								// p_ps1_buffer may be p_block: the payload never moves forward
+								memmove(p_ps1_buffer + *p_ps1_offset + ps1_offset, p_ps1_body, ps1_body_length);
 								ps1_offset += ps1_body_length;
 							}
 						}
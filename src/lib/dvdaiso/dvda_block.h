@@ -63,6 +63,9 @@ class dvda_block_t {
 	static int get_ps1_info_length(uint8_t* p_substream_buffer, int substream_length);
 public:
 	static void get_ps1(uint8_t* p_block, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info);
+	// PTS of the first PS1 packet in the block which carries one
+	static bool get_pts(uint8_t* p_block, uint64_t* p_pts);
+	// p_ps1_buffer may equal p_block to demultiplex the blocks in place
 	static void get_ps1(uint8_t* p_block, int blocks, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info);
 };
 
@@ -33,6 +33,9 @@ static constexpr Domain dvdaiso_domain("dvdaiso");
 dvda_disc_t::dvda_disc_t() {
 	dvda_media = nullptr;
 	dvda_filesystem = nullptr;
+	disc_label_ok = false;
+	toc_disc = this;
+	stream_media = nullptr;
 	audio_stream = nullptr;
 	stream_downmix = false;
 	sel_track_index = -1;
@@ -46,19 +49,19 @@ dvda_disc_t::~dvda_disc_t() {
 }
 
 dvda_filesystem_t* dvda_disc_t::get_filesystem() {
-	return dvda_filesystem;
+	return toc_disc->dvda_filesystem;
 }
 
 audio_track_t* dvda_disc_t::get_track(uint32_t track_index) {
-	return track_index < get_tracks() ? &track_list[track_index] : nullptr;
+	return track_index < get_tracks() ? &toc_disc->track_list[track_index] : nullptr;
 }
 
 uint32_t dvda_disc_t::get_tracks() {
-	return track_list.size();
+	return toc_disc->track_list.size();
 }
 
 uint32_t dvda_disc_t::get_channels() {
-	audio_stream_info_t& info = track_list[sel_track_index].audio_stream_info;
+	audio_stream_info_t& info = toc_disc->track_list[sel_track_index].audio_stream_info;
 	return info.group1_channels + info.group2_channels;
 }
 
@@ -67,38 +70,38 @@ uint32_t dvda_disc_t::get_loudspeaker_config() {
 }
 
 uint32_t dvda_disc_t::get_samplerate() {
-	return track_list[sel_track_index].audio_stream_info.group1_samplerate;
+	return toc_disc->track_list[sel_track_index].audio_stream_info.group1_samplerate;
+}
+
+uint32_t dvda_disc_t::get_bits() {
+	return toc_disc->track_list[sel_track_index].audio_stream_info.group1_bits;
 }
 
 double dvda_disc_t::get_duration() {
-	return track_list[sel_track_index].duration;
+	return toc_disc->track_list[sel_track_index].duration;
 }
 
 double dvda_disc_t::get_duration(uint32_t track_index) {
-	if (track_index < track_list.size()) {
-		return track_list[track_index].duration;
+	if (track_index < toc_disc->track_list.size()) {
+		return toc_disc->track_list[track_index].duration;
 	}
 	return 0.0;
 }
 
 bool dvda_disc_t::can_downmix() {
-	return track_list[sel_track_index].audio_stream_info.can_downmix;
+	return toc_disc->track_list[sel_track_index].audio_stream_info.can_downmix;
 }
 
 void dvda_disc_t::get_info(uint32_t track_index, bool downmix, TagHandler& handler) {
-	if (!(track_index < track_list.size())) {
+	if (!(track_index < toc_disc->track_list.size())) {
 		return;
 	}
-	audio_stream_info_t& info = track_list[track_index].audio_stream_info;
-	//int ts = track_list[track_index].dvda_titleset;
-	//int ti = track_list[track_index].dvda_title;
-	int tr = track_list[track_index].dvda_track;
+	audio_stream_info_t& info = toc_disc->track_list[track_index].audio_stream_info;
+	//int ts = toc_disc->track_list[track_index].dvda_titleset;
+	//int ti = toc_disc->track_list[track_index].dvda_title;
+	int tr = toc_disc->track_list[track_index].dvda_track;
 
-	char disc_label[32];
-	bool label_ok = dvda_filesystem->get_name(disc_label);
-	disc_label[31] = '\0';
-
-	string disc_path = dvda_media->get_name();
+	string disc_path = toc_disc->dvda_media->get_name();
 	size_t s0 = disc_path.rfind('/');
 	size_t s1 = disc_path.rfind('.');
 	string disc_name;
@@ -107,7 +110,7 @@ void dvda_disc_t::get_info(uint32_t track_index, bool downmix, TagHandler& handl
 	}
 
 	string tag_value;
-	tag_value  = label_ok ? disc_label : "DVD-Audio";
+	tag_value  = toc_disc->disc_label_ok ? toc_disc->disc_label : "DVD-Audio";
 	handler.OnTag(TAG_DISC, tag_value.c_str());
 
 	tag_value  = !disc_name.empty() ? disc_name : "Album";
@@ -134,7 +137,7 @@ void dvda_disc_t::get_info(uint32_t track_index, bool downmix, TagHandler& handl
 	tag_value += " - ";
 	tag_value += "Track " + to_string(tr);
 	tag_value += " (";
-	if (!(downmix && track_list[track_index].audio_stream_info.can_downmix)) {
+	if (!(downmix && toc_disc->track_list[track_index].audio_stream_info.can_downmix)) {
 		for (int i = 0; i < info.group1_channels; i++) {
 			if (i > 0) {
 				tag_value += "-";
@@ -183,6 +186,7 @@ bool dvda_disc_t::open(dvda_media_t* _dvda_media) {
 		return false;
 	}
 	dvda_media = _dvda_media;
+	stream_media = _dvda_media;
 	dvda_filesystem = new iso_dvda_filesystem_t;
 	if (!dvda_filesystem) {
 		return false;
@@ -197,17 +201,45 @@ bool dvda_disc_t::open(dvda_media_t* _dvda_media) {
 		return false;
 	}
 	track_list.init(dvda_zone);
+	char label[32];
+	disc_label_ok = dvda_filesystem->get_name(label);
+	label[31] = '\0';
+	disc_label = disc_label_ok ? label : "";
 	return track_list.size() > 0;
 }
 
+// Open a cursor on a disc which has already been opened by another
+// instance: the filesystem, zone and track list are shared read-only
+// with toc_disc, blocks are read through the cursor's own media (which
+// may be nullptr for cursors only used to query track info and tags).
+bool dvda_disc_t::open(dvda_media_t* _dvda_media, dvda_disc_t* _toc_disc) {
+	if (!close()) {
+		return false;
+	}
+	toc_disc = _toc_disc->toc_disc;
+	stream_media = _dvda_media;
+	return get_tracks() > 0;
+}
+
 bool dvda_disc_t::close() {
+	stream_prefetch.stop();
+	if (toc_disc != this) {
+		toc_disc = this;
+		stream_media = nullptr;
+		sel_track_index = -1;
+		return true;
+	}
 	track_list.clear();
+	seek_index.clear();
 	dvda_zone.close();
 	if (dvda_filesystem) {
 		delete dvda_filesystem;
 		dvda_filesystem = nullptr;
 	}
 	dvda_media = nullptr;
+	stream_media = nullptr;
+	disc_label.clear();
+	disc_label_ok = false;
 	sel_track_index = -1;
 	return true;
 }
@@ -215,11 +247,12 @@ bool dvda_disc_t::close() {
 bool dvda_disc_t::select_track(uint32_t track_index, size_t offset) {
 	sel_track_index = track_index;
 	sel_track_offset = offset;
-	audio_track = track_list[sel_track_index];
+	audio_track = toc_disc->track_list[sel_track_index];
 	sel_titleset_index = audio_track.dvda_titleset - 1;
 	track_stream.init(512 * DVD_BLOCK_SIZE, 4 * DVD_BLOCK_SIZE, 16 * DVD_BLOCK_SIZE);
-	ps1_data.resize(16 * DVD_BLOCK_SIZE);
 	stream_block_current = audio_track.block_first;
+	stream_segment_offset = 0;
+	stream_prefetch_start();
 	stream_size = (audio_track.block_last + 1 - audio_track.block_first) * DVD_BLOCK_SIZE;
 	stream_ps1_info.header.stream_id = UNK_STREAM_ID;
 	stream_duration = audio_track.duration;
@@ -326,16 +359,15 @@ bool dvda_disc_t::read_frame(uint8_t* frame_data, size_t* frame_size) {
 }
 
 bool dvda_disc_t::seek(double seconds) {
+	stream_prefetch.stop();
 	track_stream.reinit();
 	if (audio_stream) {
 		delete audio_stream;
 		audio_stream = nullptr;
 	}
-	uint32_t offset = (uint32_t)((seconds / (audio_track.duration + 1.0)) * (double)(audio_track.block_last + 1 - audio_track.block_first));
-	if (offset > audio_track.block_last - audio_track.block_first - 1) {
-		offset = audio_track.block_last - audio_track.block_first - 1;
-	}
-	stream_block_current = audio_track.block_first + offset;
+	stream_block_current = seek_block(seconds);
+	stream_segment_offset = 0;
+	stream_prefetch_start();
 	stream_ps1_info.header.stream_id = UNK_STREAM_ID;
 	return true;
 }
@@ -383,47 +415,137 @@ bool dvda_disc_t::create_audio_stream(sub_header_t& p_ps1_info, uint8_t* p_buf,
 	return true;
 }
 
+// Blocks are read ahead and demultiplexed by stream_prefetch, so this only
+// copies the PS1 payload of the front segment into the write bank.
 void dvda_disc_t::stream_buffer_read() {
-	sub_header_t ps1_info;
-	int blocks_to_read, blocks_read, bytes_written = 0;
-	blocks_to_read = track_stream.get_write_size() / DVD_BLOCK_SIZE;
-	if (stream_block_current <= audio_track.block_last) {
-		if (stream_block_current + blocks_to_read > audio_track.block_last + 1) {
-			blocks_to_read = audio_track.block_last + 1 - stream_block_current;
-		}
-		blocks_read = dvda_zone.get_blocks(sel_titleset_index, stream_block_current, blocks_to_read, track_stream.get_write_ptr());
-		dvda_block_t::get_ps1(track_stream.get_write_ptr(), blocks_read, ps1_data.data(), &bytes_written, &ps1_info);
-		memcpy(track_stream.get_write_ptr(), ps1_data.data(), bytes_written);
-		track_stream.move_write_ptr(bytes_written);
+	dvda_segment_t* segment = stream_prefetch.front();
+	if (!segment) {
+		return;
+	}
+	if (stream_segment_offset == 0 && segment->blocks_read < segment->blocks_to_read) {
+		LogFmt(LogLevel::ERROR, dvdaiso_domain, "DVD-Audio Decoder cannot read track {}: titleset = {}, block_number = {}, blocks_to_read = {}", segment->block_first <= audio_track.block_last ? "data" : "tail", sel_titleset_index, segment->block_first + segment->blocks_read, segment->blocks_to_read - segment->blocks_read);
+	}
+	if (segment->block_first <= audio_track.block_last) {
 		if (stream_ps1_info.header.stream_id == UNK_STREAM_ID) {
-			stream_ps1_info = ps1_info;
+			stream_ps1_info = segment->ps1_info;
 		}
-		if (blocks_read < blocks_to_read) {
-			LogFmt(LogLevel::ERROR, dvdaiso_domain, "DVD-Audio Decoder cannot read track data: titleset = %d, block_number = %d, blocks_to_read = %d", sel_titleset_index, stream_block_current + blocks_read, blocks_to_read - blocks_read);
+		int bytes_to_write = segment->ps1_size - stream_segment_offset;
+		if (bytes_to_write > track_stream.get_write_size()) {
+			bytes_to_write = track_stream.get_write_size();
 		}
-		stream_block_current += blocks_to_read;
-		if (stream_block_current > audio_track.block_last) {
-			int blocks_after_last = dvda_zone.get_titleset(sel_titleset_index).get_last() - audio_track.block_last;
-			int blocks_to_sync = blocks_after_last < 8 ? blocks_after_last : 8;
-			if (stream_block_current <= audio_track.block_last + blocks_to_sync) {
-				if (stream_block_current + blocks_to_read > audio_track.block_last + 1 + blocks_to_sync) {
-					blocks_to_read = audio_track.block_last + 1 + blocks_to_sync - stream_block_current;
-				}
-				blocks_read = dvda_zone.get_blocks(sel_titleset_index, stream_block_current, blocks_to_read, track_stream.get_write_ptr());
-				bytes_written = 0;
-				dvda_block_t::get_ps1(track_stream.get_write_ptr(), blocks_read, ps1_data.data(), &bytes_written, nullptr);
-				memcpy(track_stream.get_write_ptr(), ps1_data.data(), bytes_written);
-				if (audio_stream) {
-					int major_sync = audio_stream->resync(track_stream.get_write_ptr(), bytes_written);
-					if (major_sync > 0) {
-						track_stream.move_write_ptr(major_sync);
-					}
-				}
-				if (blocks_read < blocks_to_read) {
-					LogFmt(LogLevel::ERROR, dvdaiso_domain, "DVD-Audio Decoder cannot read track tail: titleset = %d, block_number = %d, blocks_to_read = %d", sel_titleset_index, stream_block_current + blocks_read, blocks_to_read - blocks_read);
-				}
-				stream_block_current += blocks_to_read;
+		memcpy(track_stream.get_write_ptr(), segment->data.data() + stream_segment_offset, bytes_to_write);
+		track_stream.move_write_ptr(bytes_to_write);
+		stream_segment_offset += bytes_to_write;
+		if (stream_segment_offset < segment->ps1_size) {
+			return;
+		}
+	}
+	else {
+		// The blocks after the track only complete its last frame: append
+		// them up to the next major sync.
+		if (audio_stream) {
+			int major_sync = audio_stream->resync(segment->data.data(), segment->ps1_size);
+			if (major_sync > track_stream.get_write_size()) {
+				major_sync = track_stream.get_write_size();
 			}
+			if (major_sync > 0) {
+				memcpy(track_stream.get_write_ptr(), segment->data.data(), major_sync);
+				track_stream.move_write_ptr(major_sync);
+			}
+		}
+	}
+	if (segment->has_pts && segment->block_first <= audio_track.block_last) {
+		toc_disc->seek_index.insert(sel_track_index, {segment->pts_block, segment->pts});
+	}
+	stream_block_current = segment->block_first + segment->blocks_to_read;
+	stream_segment_offset = 0;
+	stream_prefetch.pop();
+}
+
+void dvda_disc_t::stream_prefetch_start() {
+	if (!stream_media) {
+		return;
+	}
+	uint32_t blocks_after_last = toc_disc->dvda_zone.get_titleset(sel_titleset_index).get_last() - audio_track.block_last;
+	uint32_t blocks_to_sync = blocks_after_last < 8 ? blocks_after_last : 8;
+	stream_prefetch.start(&toc_disc->dvda_zone, sel_titleset_index, stream_media, stream_block_current, audio_track.block_last + 1, audio_track.block_last + 1 + blocks_to_sync);
+}
+
+// Find the block to resume playback from: the last one whose first PTS is
+// not past the target. MLP is VBR, so the block is searched for by probing
+// PTS values, alternating interpolation and bisection; every probe and every
+// block played goes into the disc's seek index, which usually leaves only a
+// few blocks to probe. Falls back to interpolating the block range linearly.
+uint32_t dvda_disc_t::seek_block(double seconds) {
+	static constexpr int SEEK_PROBES_MAX = 32;
+	uint32_t offset = (uint32_t)((seconds / (audio_track.duration + 1.0)) * (double)(audio_track.block_last + 1 - audio_track.block_first));
+	if (offset > audio_track.block_last - audio_track.block_first - 1) {
+		offset = audio_track.block_last - audio_track.block_first - 1;
+	}
+	uint32_t block_estimate = audio_track.block_first + offset;
+	if (!stream_media) {
+		return block_estimate;
+	}
+	dvda_seek_index_t& index = toc_disc->seek_index;
+	dvda_seek_point_t lo, hi;
+	if (!index.get_first(sel_track_index, audio_track.block_first, SEEK_PROBE_BLOCKS, lo)) {
+		if (!seek_probe(audio_track.block_first, lo)) {
+			return block_estimate;
+		}
+		index.insert(sel_track_index, lo);
+	}
+	hi.block = audio_track.block_last + 1;
+	hi.pts = lo.pts + (uint64_t)((audio_track.duration + 1.0) * 90000.0);
+	uint64_t pts = lo.pts + (uint64_t)(seconds * 90000.0);
+	if (pts >= hi.pts) {
+		pts = hi.pts - 1;
+	}
+	for (int probe = 0; probe < SEEK_PROBES_MAX; probe++) {
+		index.bracket(sel_track_index, pts, lo, hi);
+		if (hi.block - lo.block <= 1) {
+			break;
+		}
+		uint32_t block;
+		if (probe & 1) {
+			block = lo.block + (hi.block - lo.block) / 2;
+		}
+		else {
+			block = lo.block + (uint32_t)((double)(pts - lo.pts) * (double)(hi.block - lo.block) / (double)(hi.pts - lo.pts));
+		}
+		if (block <= lo.block) {
+			block = lo.block + 1;
+		}
+		if (block >= hi.block) {
+			block = hi.block - 1;
+		}
+		dvda_seek_point_t point;
+		if (!seek_probe(block, point) || point.block >= hi.block || point.pts <= lo.pts || point.pts >= hi.pts) {
+			break;
+		}
+		index.insert(sel_track_index, point);
+		if (point.pts <= pts) {
+			lo = point;
+		}
+		else {
+			hi = point;
+		}
+	}
+	return lo.block;
+}
+
+// Read SEEK_PROBE_BLOCKS blocks at once and take the first PTS among them.
+bool dvda_disc_t::seek_probe(uint32_t block, dvda_seek_point_t& point) {
+	uint8_t block_data[SEEK_PROBE_BLOCKS * DVD_BLOCK_SIZE];
+	int blocks_to_read = SEEK_PROBE_BLOCKS;
+	if (block + blocks_to_read > audio_track.block_last + 1) {
+		blocks_to_read = audio_track.block_last + 1 - block;
+	}
+	int blocks_read = toc_disc->dvda_zone.get_blocks(sel_titleset_index, block, blocks_to_read, block_data, stream_media);
+	for (int i = 0; i < blocks_read; i++) {
+		if (dvda_block_t::get_pts(block_data + i * DVD_BLOCK_SIZE, &point.pts)) {
+			point.block = block + i;
+			return true;
 		}
 	}
+	return false;
 }
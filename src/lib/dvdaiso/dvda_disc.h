@@ -20,23 +20,35 @@
 #ifndef DVDA_DISC_H_INCLUDED
 #define DVDA_DISC_H_INCLUDED
 
+#include <string>
 #include "audio_stream.h"
 #include "audio_track.h"
 #include "stream_buffer.h"
 #include "dvda_reader.h"
 #include "dvda_filesystem.h"
+#include "dvda_prefetch.h"
+#include "dvda_seek_index.h"
 #include "dvda_zone.h"
 
 
 class dvda_disc_t : public dvda_reader_t {
 private:
+	static constexpr int SEEK_PROBE_BLOCKS = 4;
+
 	dvda_media_t*      dvda_media;
 	dvda_filesystem_t* dvda_filesystem;
 	dvda_zone_t        dvda_zone;
 	track_list_t       track_list;
+	std::string        disc_label;
+	bool               disc_label_ok;
+	dvda_seek_index_t  seek_index;
+
+	dvda_disc_t*       toc_disc;
+	dvda_media_t*      stream_media;
 
 	stream_buffer_t<uint8_t, int> track_stream;
-	vector<uint8_t>               ps1_data;
+	dvda_prefetch_t               stream_prefetch;
+	int                           stream_segment_offset; // PS1 bytes of the front segment already in track_stream
 	audio_stream_t*               audio_stream;
 	audio_track_t                 audio_track;
 
@@ -65,12 +77,14 @@ public:
 	uint32_t get_channels() override;
 	uint32_t get_loudspeaker_config() override;
 	uint32_t get_samplerate() override;
+	uint32_t get_bits() override;
 	double get_duration() override;
 	double get_duration(uint32_t track_index) override;
 	bool can_downmix() override;
 	void get_info(uint32_t track_index, bool downmix, TagHandler& handler) override;
 	uint32_t get_track_length_lsn();
 	bool open(dvda_media_t* dvda_media) override;
+	bool open(dvda_media_t* dvda_media, dvda_disc_t* toc_disc);
 	bool close() override;
 	bool select_track(uint32_t track_index, size_t offset = 0) override;
 	bool get_downmix() override;
@@ -80,6 +94,9 @@ public:
 private:
 	bool create_audio_stream(sub_header_t& p_ps1_info, uint8_t* p_buf, int p_buf_size, bool p_downmix);
 	void stream_buffer_read();
+	void stream_prefetch_start();
+	uint32_t seek_block(double seconds);
+	bool seek_probe(uint32_t block, dvda_seek_point_t& point);
 };
 
 #endif
@@ -46,6 +46,22 @@ bool iso_dvda_fileobject_t::seek(int64_t offset) {
 	return ok;
 }
 
+// Positioned read through the given media handle (nullptr: the media
+// the filesystem was mounted from), so that several streams can read
+// the same file object concurrently through their own handles.
+int iso_dvda_fileobject_t::read_at(dvda_media_t* media, int64_t offset, void* buffer, int count) {
+	if (!media) {
+		media = fo;
+	}
+	if (!(offset < size)) {
+		return 0;
+	}
+	if (!media->seek((int64_t)2048 * (int64_t)lba + offset)) {
+		return 0;
+	}
+	return media->read(buffer, count);
+}
+
 bool iso_dvda_filesystem_t::mount(dvda_media_t* _dvda_media) {
 	dvda_media = _dvda_media;
 	iso_reader = DVDOpen(dvda_media);
@@ -55,6 +55,7 @@ public:
 	virtual bool close() = 0;
 	virtual int read(void* buffer, int count) = 0;
 	virtual bool seek(int64_t offset) = 0;
+	virtual int read_at(dvda_media_t* media, int64_t offset, void* buffer, int count) = 0;
 	virtual int64_t get_size() {
 		return size;
 	}
@@ -92,6 +93,7 @@ public:
 	bool close() override;
 	int read(void* buffer, int count) override;
 	bool seek(int64_t offset) override;
+	int read_at(dvda_media_t* media, int64_t offset, void* buffer, int count) override;
 };
 
 #endif
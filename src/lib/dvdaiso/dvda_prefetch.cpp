@@ -0,0 +1,132 @@
+/*
+* MPD DVD-Audio Decoder plugin
+* Copyright (c) 2021 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* DVD-Audio Decoder is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* DVD-Audio Decoder is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "dvda_prefetch.h"
+
+using namespace std;
+
+dvda_prefetch_t::dvda_prefetch_t() {
+	segments.resize(SEGMENTS);
+	for (auto& segment : segments) {
+		segment.data.resize(SEGMENT_BLOCKS * DVD_BLOCK_SIZE);
+	}
+	segment_head = 0;
+	segment_count = 0;
+	zone = nullptr;
+	titleset_index = 0;
+	media = nullptr;
+	block_next = 0;
+	block_split = 0;
+	block_end = 0;
+	generation = 0;
+	reading = false;
+	run_reader = false;
+}
+
+dvda_prefetch_t::~dvda_prefetch_t() {
+	{
+		lock_guard<mutex> lock(prefetch_mutex);
+		run_reader = false;
+		reader_cond.notify_one();
+	}
+	if (reader_thread.joinable()) {
+		reader_thread.join();
+	}
+}
+
+void dvda_prefetch_t::start(dvda_zone_t* _zone, int _titleset_index, dvda_media_t* _media, uint32_t _block_first, uint32_t _block_split, uint32_t _block_end) {
+	lock_guard<mutex> lock(prefetch_mutex);
+	generation++;
+	segment_count = 0;
+	zone = _zone;
+	titleset_index = _titleset_index;
+	media = _media;
+	block_next = _block_first;
+	block_split = _block_split;
+	block_end = _block_end;
+	if (!run_reader) {
+		run_reader = true;
+		reader_thread = thread(&dvda_prefetch_t::run, this);
+	}
+	reader_cond.notify_one();
+}
+
+void dvda_prefetch_t::stop() {
+	unique_lock<mutex> lock(prefetch_mutex);
+	generation++;
+	segment_count = 0;
+	zone = nullptr;
+	media = nullptr;
+	block_next = block_end = 0;
+	consumer_cond.wait(lock, [this] { return !reading; });
+}
+
+dvda_segment_t* dvda_prefetch_t::front() {
+	unique_lock<mutex> lock(prefetch_mutex);
+	consumer_cond.wait(lock, [this] { return segment_count > 0 || (block_next >= block_end && !reading); });
+	return segment_count > 0 ? &segments[segment_head] : nullptr;
+}
+
+void dvda_prefetch_t::pop() {
+	lock_guard<mutex> lock(prefetch_mutex);
+	if (segment_count > 0) {
+		segment_head = (segment_head + 1) % SEGMENTS;
+		segment_count--;
+		reader_cond.notify_one();
+	}
+}
+
+void dvda_prefetch_t::run() {
+	unique_lock<mutex> lock(prefetch_mutex);
+	while (run_reader) {
+		if (block_next >= block_end || segment_count == SEGMENTS) {
+			reader_cond.wait(lock);
+			continue;
+		}
+		// The slot past the ready ones stays the same while the consumer
+		// pops or discards segments, so it may be filled without the lock.
+		dvda_segment_t& segment = segments[(segment_head + segment_count) % SEGMENTS];
+		uint64_t segment_generation = generation;
+		uint32_t block_limit = block_next < block_split ? block_split : block_end;
+		segment.block_first = block_next;
+		segment.blocks_to_read = block_limit - block_next < (uint32_t)SEGMENT_BLOCKS ? block_limit - block_next : SEGMENT_BLOCKS;
+		block_next += segment.blocks_to_read;
+		dvda_zone_t* read_zone = zone;
+		dvda_media_t* read_media = media;
+		int read_titleset_index = titleset_index;
+		reading = true;
+		lock.unlock();
+
+		segment.blocks_read = read_zone->get_blocks(read_titleset_index, segment.block_first, segment.blocks_to_read, segment.data.data(), read_media);
+		segment.has_pts = false;
+		for (int i = 0; i < segment.blocks_read && !segment.has_pts; i++) {
+			segment.has_pts = dvda_block_t::get_pts(segment.data.data() + i * DVD_BLOCK_SIZE, &segment.pts);
+			segment.pts_block = segment.block_first + i;
+		}
+		segment.ps1_size = 0;
+		dvda_block_t::get_ps1(segment.data.data(), segment.blocks_read, segment.data.data(), &segment.ps1_size, &segment.ps1_info);
+
+		lock.lock();
+		reading = false;
+		if (generation == segment_generation) {
+			segment_count++;
+		}
+		consumer_cond.notify_one();
+	}
+}
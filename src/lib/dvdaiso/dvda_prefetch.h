@@ -0,0 +1,98 @@
+/*
+* MPD DVD-Audio Decoder plugin
+* Copyright (c) 2021 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* DVD-Audio Decoder is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* DVD-Audio Decoder is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _DVDA_PREFETCH_H_INCLUDED
+#define _DVDA_PREFETCH_H_INCLUDED
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "dvda_block.h"
+#include "dvda_media.h"
+#include "dvda_zone.h"
+
+using std::condition_variable;
+using std::mutex;
+using std::thread;
+using std::vector;
+
+// A run of consecutive AOB blocks read by the prefetcher. The PS1 payload
+// is demultiplexed in place: after the read, data holds ps1_size bytes of
+// audio stream instead of the raw blocks.
+struct dvda_segment_t {
+	vector<uint8_t> data;
+	uint32_t        block_first;
+	int             blocks_to_read;
+	int             blocks_read;
+	int             ps1_size;
+	sub_header_t    ps1_info;
+	bool            has_pts;   // pts_block and pts are valid
+	uint32_t        pts_block; // first block of the segment with a PTS
+	uint64_t        pts;
+};
+
+// Background read-ahead of the AOB blocks of one track, so that the decoder
+// thread never waits on a seek+read of the media (which may be an ISO on
+// network storage). A single reader thread fills a ring of segments ahead of
+// the consumer; segments never straddle split_block, so that the blocks read
+// past the end of a track for resynchronization come in segments of their own.
+class dvda_prefetch_t {
+public:
+	static constexpr int SEGMENT_BLOCKS = 64;
+	static constexpr int SEGMENTS = 8;
+private:
+	mutex              prefetch_mutex;
+	condition_variable reader_cond;   // signalled on new work and on consumed segments
+	condition_variable consumer_cond; // signalled on ready segments and when the reader goes idle
+	thread             reader_thread;
+
+	vector<dvda_segment_t> segments;
+	int      segment_head;  // first ready segment, owned by the consumer
+	int      segment_count; // number of ready segments
+
+	dvda_zone_t*  zone;
+	int           titleset_index;
+	dvda_media_t* media;
+	uint32_t      block_next;  // next block the reader will fetch
+	uint32_t      block_split; // first block past the track
+	uint32_t      block_end;   // first block not to fetch at all
+	uint64_t      generation;  // bumped whenever the pending segments are discarded
+	bool          reading;     // the reader is inside get_blocks()
+	bool          run_reader;
+public:
+	dvda_prefetch_t();
+	~dvda_prefetch_t();
+	dvda_prefetch_t(const dvda_prefetch_t& prefetch) = delete;
+	dvda_prefetch_t& operator=(const dvda_prefetch_t& prefetch) = delete;
+	// Start fetching [block_first, block_end) of the titleset through media,
+	// dropping the pending segments.
+	void start(dvda_zone_t* zone, int titleset_index, dvda_media_t* media, uint32_t block_first, uint32_t block_split, uint32_t block_end);
+	// Wait until the reader no longer touches zone and media.
+	void stop();
+	// The oldest ready segment, waiting for the reader if necessary; nullptr
+	// once the whole range has been consumed or after stop().
+	dvda_segment_t* front();
+	void pop();
+private:
+	void run();
+};
+
+#endif
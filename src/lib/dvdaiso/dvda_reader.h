@@ -33,6 +33,7 @@ public:
 	virtual uint32_t get_channels() = 0;
 	virtual uint32_t get_loudspeaker_config() = 0;
 	virtual uint32_t get_samplerate() = 0;
+	virtual uint32_t get_bits() = 0;
 	virtual double get_duration() = 0;
 	virtual double get_duration(uint32_t track_index) = 0;
 	virtual bool can_downmix() = 0;
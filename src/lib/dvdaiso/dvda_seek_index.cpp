@@ -0,0 +1,73 @@
+/*
+* MPD DVD-Audio Decoder plugin
+* Copyright (c) 2021 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* DVD-Audio Decoder is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* DVD-Audio Decoder is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <algorithm>
+#include "dvda_seek_index.h"
+
+using namespace std;
+
+void dvda_seek_index_t::clear() {
+	lock_guard<mutex> lock(index_mutex);
+	tracks.clear();
+}
+
+void dvda_seek_index_t::insert(int track_index, const dvda_seek_point_t& point) {
+	lock_guard<mutex> lock(index_mutex);
+	auto& points = tracks[track_index];
+	auto it = lower_bound(points.begin(), points.end(), point.block, [](const dvda_seek_point_t& p, uint32_t block) { return p.block < block; });
+	if (it != points.end() && it->block == point.block) {
+		return;
+	}
+	// PTS must grow with the block number, drop anything contradicting the
+	// known points
+	if ((it != points.begin() && prev(it)->pts >= point.pts) || (it != points.end() && it->pts <= point.pts)) {
+		return;
+	}
+	points.insert(it, point);
+}
+
+bool dvda_seek_index_t::get_first(int track_index, uint32_t block_first, uint32_t blocks_max, dvda_seek_point_t& point) {
+	lock_guard<mutex> lock(index_mutex);
+	auto it = tracks.find(track_index);
+	if (it == tracks.end() || it->second.empty()) {
+		return false;
+	}
+	const auto& first = it->second.front();
+	if (first.block < block_first || first.block >= block_first + blocks_max) {
+		return false;
+	}
+	point = first;
+	return true;
+}
+
+void dvda_seek_index_t::bracket(int track_index, uint64_t pts, dvda_seek_point_t& lo, dvda_seek_point_t& hi) {
+	lock_guard<mutex> lock(index_mutex);
+	auto it = tracks.find(track_index);
+	if (it == tracks.end()) {
+		return;
+	}
+	const auto& points = it->second;
+	auto next = upper_bound(points.begin(), points.end(), pts, [](uint64_t value, const dvda_seek_point_t& p) { return value < p.pts; });
+	if (next != points.end() && next->block < hi.block && next->block > lo.block) {
+		hi = *next;
+	}
+	if (next != points.begin() && prev(next)->block > lo.block && prev(next)->block < hi.block) {
+		lo = *prev(next);
+	}
+}
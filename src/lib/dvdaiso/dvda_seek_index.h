@@ -0,0 +1,53 @@
+/*
+* MPD DVD-Audio Decoder plugin
+* Copyright (c) 2021 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* DVD-Audio Decoder is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* DVD-Audio Decoder is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _DVDA_SEEK_INDEX_H_INCLUDED
+#define _DVDA_SEEK_INDEX_H_INCLUDED
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+using std::map;
+using std::mutex;
+using std::vector;
+
+struct dvda_seek_point_t {
+	uint32_t block;
+	uint64_t pts;
+};
+
+// Per-track map of AOB blocks to the PTS of the first PS1 packet in them,
+// kept by the disc and shared by all of its cursors. The points come from
+// seek probes and from the blocks read while a track is played, so repeated
+// seeks into a region need no probing at all.
+class dvda_seek_index_t {
+	mutex index_mutex;
+	map<int, vector<dvda_seek_point_t>> tracks; // points sorted by block
+public:
+	void clear();
+	void insert(int track_index, const dvda_seek_point_t& point);
+	// The first point of the track, if it is within blocks_max of block_first.
+	bool get_first(int track_index, uint32_t block_first, uint32_t blocks_max, dvda_seek_point_t& point);
+	// Narrow [lo, hi) to the closest known points with lo.pts <= pts < hi.pts.
+	void bracket(int track_index, uint64_t pts, dvda_seek_point_t& lo, dvda_seek_point_t& hi);
+};
+
+#endif
@@ -384,7 +384,7 @@ DVDAERROR dvda_titleset_t::get_block(uint32_t block_index, uint8_t* block_data)
 	return DVDAERR_AOB_BLOCK_NOT_FOUND;
 }
 
-int dvda_titleset_t::get_blocks(uint32_t block_first, uint32_t block_last, uint8_t* block_data) {
+int dvda_titleset_t::get_blocks(uint32_t block_first, uint32_t block_last, uint8_t* block_data, dvda_media_t* media) {
 	int blocks_read = 0;
 	int aob_index = -1;
 	for (int i = 0; i < 9; i++) {
@@ -395,24 +395,21 @@ int dvda_titleset_t::get_blocks(uint32_t block_first, uint32_t block_last, uint8
 	}
 	if (aob_index >= 0) {
 		if (aobs[aob_index].dvda_fileobject) {
-			if (aobs[aob_index].dvda_fileobject->seek((block_first - aobs[aob_index].block_first) * DVD_BLOCK_SIZE)) {
-				if (block_last <= aobs[aob_index].block_last) {
-					int bytes_to_read = (block_last + 1 - block_first) * DVD_BLOCK_SIZE;
-					int bytes_read = aobs[aob_index].dvda_fileobject->read((char*)block_data, bytes_to_read);
-					blocks_read += bytes_read / DVD_BLOCK_SIZE;
-				}
-				else {
-					int bytes_to_read_1 = (aobs[aob_index].block_last + 1 - block_first) * DVD_BLOCK_SIZE;
-					int bytes_read_1 = aobs[aob_index].dvda_fileobject->read((char*)block_data, bytes_to_read_1);
-					blocks_read += bytes_read_1 / DVD_BLOCK_SIZE;
-					if (aob_index + 1 < 9) {
-						if (aobs[aob_index + 1].dvda_fileobject) {
-							if (aobs[aob_index + 1].dvda_fileobject->seek(0)) {
-								int bytes_to_read_2 = (block_last + 1 - aobs[aob_index + 1].block_first) * DVD_BLOCK_SIZE;
-								int bytes_read_2 = aobs[aob_index + 1].dvda_fileobject->read((char*)block_data + blocks_read * DVD_BLOCK_SIZE, bytes_to_read_2);
-								blocks_read += bytes_read_2 / DVD_BLOCK_SIZE;
-							}
-						}
+			int64_t aob_offset = (int64_t)(block_first - aobs[aob_index].block_first) * DVD_BLOCK_SIZE;
+			if (block_last <= aobs[aob_index].block_last) {
+				int bytes_to_read = (block_last + 1 - block_first) * DVD_BLOCK_SIZE;
+				int bytes_read = aobs[aob_index].dvda_fileobject->read_at(media, aob_offset, block_data, bytes_to_read);
+				blocks_read += bytes_read / DVD_BLOCK_SIZE;
+			}
+			else {
+				int bytes_to_read_1 = (aobs[aob_index].block_last + 1 - block_first) * DVD_BLOCK_SIZE;
+				int bytes_read_1 = aobs[aob_index].dvda_fileobject->read_at(media, aob_offset, block_data, bytes_to_read_1);
+				blocks_read += bytes_read_1 / DVD_BLOCK_SIZE;
+				if (aob_index + 1 < 9) {
+					if (aobs[aob_index + 1].dvda_fileobject) {
+						int bytes_to_read_2 = (block_last + 1 - aobs[aob_index + 1].block_first) * DVD_BLOCK_SIZE;
+						int bytes_read_2 = aobs[aob_index + 1].dvda_fileobject->read_at(media, 0, block_data + blocks_read * DVD_BLOCK_SIZE, bytes_to_read_2);
+						blocks_read += bytes_read_2 / DVD_BLOCK_SIZE;
 					}
 				}
 			}
@@ -518,6 +515,6 @@ DVDAERROR dvda_zone_t::get_block(int titleset_index, uint32_t block_index, uint8
 	return get_titleset(titleset_index).get_block(block_index, block_data);
 }
 
-int dvda_zone_t::get_blocks(int titleset_index, uint32_t block_index, int block_count, uint8_t* block_data) {
-	return get_titleset(titleset_index).get_blocks(block_index, block_index + block_count - 1, block_data);
+int dvda_zone_t::get_blocks(int titleset_index, uint32_t block_index, int block_count, uint8_t* block_data, dvda_media_t* media) {
+	return get_titleset(titleset_index).get_blocks(block_index, block_index + block_count - 1, block_data, media);
 }
@@ -153,7 +153,7 @@ public:
 	bool open(dvda_zone_t* zone, int titleset_index);
 	void close();
 	DVDAERROR get_block(uint32_t block_index, uint8_t* buf_ptr);
-	int get_blocks(uint32_t block_first, uint32_t block_last, uint8_t* block_data);
+	int get_blocks(uint32_t block_first, uint32_t block_last, uint8_t* block_data, dvda_media_t* media = nullptr);
 };
 
 class dvda_zone_t : public dvda_object_t {
@@ -171,7 +171,7 @@ public:
 	bool open(dvda_filesystem_t* filesystem);
 	void close();
 	DVDAERROR get_block(int titleset_index, uint32_t block_index, uint8_t* block_data);
-	int get_blocks(int titleset_index, uint32_t block_index, int block_count, uint8_t* block_data);
+	int get_blocks(int titleset_index, uint32_t block_index, int block_count, uint8_t* block_data, dvda_media_t* media = nullptr);
 };
 
 #endif
@@ -79,7 +79,7 @@ typedef struct {
 } FilterParams;
 
 /** sample data coding information */
-typedef struct {
+typedef struct ChannelParams {
     FilterParams filter_params[NUM_FILTERS];
     int32_t     coeff[NUM_FILTERS][MAX_FIR_ORDER];
 
@@ -21,7 +21,6 @@
 void av_freep(void* arg);
 void* ff_realloc_static(void* ptr, unsigned int size);
 void ff_mlp_init(DSPContext* c, AVCodecContext *avctx);
-void ff_mlp_init_x86(DSPContext* c, AVCodecContext *avctx);
 
 /*****************************************************************************/
 /***   utils.c                                                             ***/
@@ -507,7 +506,23 @@ void dsputil_init(DSPContext* p, AVCodecContext *avctx) {
 	 ff_mlp_init(p, avctx);
 }
 
-void ff_mlp_init_x86(DSPContext* c, AVCodecContext *avctx) {
-	(void)c; // Unused parameter
-	(void)avctx; // Unused parameter
+/*****************************************************************************/
+/***   cpu.c                                                               ***/
+/*****************************************************************************/
+
+static int cpu_flags_forced = -1;
+
+int av_get_cpu_flags(void) {
+	int flags = 0;
+	if (cpu_flags_forced != -1)
+		return cpu_flags_forced;
+#if ARCH_X86
+	if (__builtin_cpu_supports("avx2"))
+		flags |= AV_CPU_FLAG_AVX2;
+#endif
+	return flags;
+}
+
+void av_force_cpu_flags(int flags) {
+	cpu_flags_forced = flags;
 }
@@ -687,17 +687,64 @@ int ff_combine_frame(ParseContext* pc, int next, const uint8_t** buf, int* buf_s
 /**
  * DSPContext.
  */
+struct ChannelParams;
+
 typedef struct DSPContext {
     /* mlp/truehd functions */
     void (*mlp_filter_channel)(int32_t *state, const int32_t *coeff,
                                int firorder, int iirorder,
                                unsigned int filter_shift, int32_t mask, int blocksize,
                                int32_t *sample_buffer);
+    /**
+     * Filter all channels of a substream block at once, updating the filter
+     * state in params; mask holds the quantization mask of each channel.
+     * NULL if there is no such implementation, mlp_filter_channel() is then
+     * called for each channel.
+     */
+    void (*mlp_filter_channels)(struct ChannelParams *params, const int32_t *mask,
+                                int channels, int blocksize,
+                                int32_t *sample_buffer);
+    void (*mlp_rematrix_channel)(int32_t *samples, const int32_t *coeffs,
+                                 const int8_t *bypassed_lsbs, const int8_t *noise_buffer,
+                                 int index, unsigned int dest_ch, uint16_t blockpos,
+                                 unsigned int maxchan, int matrix_noise_shift,
+                                 int access_unit_size_pow2, int32_t mask);
 } DSPContext;
 
 void dsputil_init(DSPContext* p, AVCodecContext *avctx);
 
+/**
+ * The portable rematrix; SIMD versions fall back to it for the cases they
+ * don't handle.
+ */
+void ff_mlp_rematrix_channel(int32_t *samples, const int32_t *coeffs,
+                             const int8_t *bypassed_lsbs, const int8_t *noise_buffer,
+                             int index, unsigned int dest_ch, uint16_t blockpos,
+                             unsigned int maxchan, int matrix_noise_shift,
+                             int access_unit_size_pow2, int32_t mask);
+
 #define CONFIG_MLP_DECODER 1
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
 #define ARCH_X86 1
+#else
+#define ARCH_X86 0
+#endif
+
+/*****************************************************************************/
+/***   cpu.h                                                               ***/
+/*****************************************************************************/
+
+#define AV_CPU_FLAG_AVX2         0x8000
+
+/**
+ * Return the flags which specify extensions supported by the CPU.
+ */
+int av_get_cpu_flags(void);
+
+/**
+ * Disables cpu detection and forces the specified flags.
+ * -1 is a special case that disables forcing of specific flags.
+ */
+void av_force_cpu_flags(int flags);
 
 #endif /* MLP_UTIL_H */
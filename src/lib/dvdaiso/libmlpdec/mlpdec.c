@@ -746,6 +746,22 @@ static void filter_channel(MLPDecodeContext *m, unsigned int substr,
     memcpy(iir->state, iirbuf - s->blocksize, MAX_IIR_ORDER * sizeof(int32_t));
 }
 
+/** Filter all channels of the substream at once. */
+
+static void filter_channels(MLPDecodeContext *m, unsigned int substr)
+{
+    SubStream *s = &m->substream[substr];
+    int32_t mask[MAX_CHANNELS_ALL];
+    unsigned int ch;
+
+    for (ch = s->min_channel; ch <= s->max_channel; ch++)
+        mask[ch - s->min_channel] = MSB_MASK(s->quant_step_size[ch]);
+
+    m->dsp.mlp_filter_channels(&m->channel_params[s->min_channel], mask,
+                               s->max_channel - s->min_channel + 1, s->blocksize,
+                               &m->sample_buffer[s->blockpos][s->min_channel]);
+}
+
 /** Read a block of PCM residual data (or actual if no filtering active). */
 
 static int read_block_data(MLPDecodeContext *m, GetBitContext *gbp,
@@ -773,8 +789,11 @@ static int read_block_data(MLPDecodeContext *m, GetBitContext *gbp,
         if (read_huff_channels(m, gbp, substr, i) < 0)
             return -1;
 
-    for (ch = s->min_channel; ch <= s->max_channel; ch++)
-        filter_channel(m, substr, ch);
+    if (m->dsp.mlp_filter_channels && s->max_channel > s->min_channel)
+        filter_channels(m, substr);
+    else
+        for (ch = s->min_channel; ch <= s->max_channel; ch++)
+            filter_channel(m, substr, ch);
 
     s->blockpos += s->blocksize;
 
@@ -860,7 +879,7 @@ static void fill_noise_buffer(MLPDecodeContext *m, unsigned int substr)
 static void rematrix_channels(MLPDecodeContext *m, unsigned int substr)
 {
     SubStream *s = &m->substream[substr];
-    unsigned int mat, src_ch, i;
+    unsigned int mat;
     unsigned int maxchan;
 
     maxchan = s->max_matrix_channel;
@@ -872,31 +891,19 @@ static void rematrix_channels(MLPDecodeContext *m, unsigned int substr)
     }
 
     for (mat = 0; mat < s->num_primitive_matrices; mat++) {
-        int matrix_noise_shift = s->matrix_noise_shift[mat];
         unsigned int dest_ch = s->matrix_out_ch[mat];
-        int32_t mask = MSB_MASK(s->quant_step_size[dest_ch]);
-        int32_t *coeffs = s->matrix_coeff[mat];
-        int index  = s->num_primitive_matrices - mat;
-        int index2 = 2 * index + 1;
-
-        /* TODO: DSPContext? */
-
-        for (i = 0; i < s->blockpos; i++) {
-            int32_t bypassed_lsb = m->bypassed_lsbs[i][mat];
-            int32_t *samples = m->sample_buffer[i];
-            int64_t accum = 0;
 
-            for (src_ch = 0; src_ch <= maxchan; src_ch++)
-                accum += (int64_t) samples[src_ch] * coeffs[src_ch];
-
-            if (matrix_noise_shift) {
-                index &= m->access_unit_size_pow2 - 1;
-                accum += m->noise_buffer[index] << (matrix_noise_shift + 7);
-                index += index2;
-            }
-
-            samples[dest_ch] = ((accum >> 14) & mask) + bypassed_lsb;
-        }
+        m->dsp.mlp_rematrix_channel(&m->sample_buffer[0][0],
+                                    s->matrix_coeff[mat],
+                                    &m->bypassed_lsbs[0][mat],
+                                    m->noise_buffer,
+                                    s->num_primitive_matrices - mat,
+                                    dest_ch,
+                                    s->blockpos,
+                                    maxchan,
+                                    s->matrix_noise_shift[mat],
+                                    m->access_unit_size_pow2,
+                                    MSB_MASK(s->quant_step_size[dest_ch]));
     }
 }
 
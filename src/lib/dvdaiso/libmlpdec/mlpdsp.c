@@ -58,14 +58,43 @@ static void ff_mlp_filter_channel(int32_t *state, const int32_t *coeff,
 	}
 }
 
+void ff_mlp_rematrix_channel(int32_t *samples, const int32_t *coeffs,
+                             const int8_t *bypassed_lsbs, const int8_t *noise_buffer,
+                             int index, unsigned int dest_ch, uint16_t blockpos,
+                             unsigned int maxchan, int matrix_noise_shift,
+                             int access_unit_size_pow2, int32_t mask)
+{
+	unsigned int src_ch, i;
+	int index2 = 2 * index + 1;
+
+	for (i = 0; i < blockpos; i++) {
+		int64_t accum = 0;
+
+		for (src_ch = 0; src_ch <= maxchan; src_ch++)
+			accum += (int64_t) samples[src_ch] * coeffs[src_ch];
+
+		if (matrix_noise_shift) {
+			index &= access_unit_size_pow2 - 1;
+			accum += noise_buffer[index] << (matrix_noise_shift + 7);
+			index += index2;
+		}
+
+		samples[dest_ch] = ((accum >> 14) & mask) + *bypassed_lsbs;
+		bypassed_lsbs += MAX_CHANNELS_ALL;
+		samples += MAX_CHANNELS_ALL;
+	}
+}
+
 void ff_mlp_init(DSPContext* c, AVCodecContext *avctx);
 void ff_mlp_init_x86(DSPContext* c, AVCodecContext *avctx);
 
 void ff_mlp_init(DSPContext* c, AVCodecContext *avctx)
 {
 	c->mlp_filter_channel = ff_mlp_filter_channel;
+	c->mlp_filter_channels = NULL;
+	c->mlp_rematrix_channel = ff_mlp_rematrix_channel;
 
-	if (ARCH_X86) {
-		ff_mlp_init_x86(c, avctx);
-	}
+#if ARCH_X86
+	ff_mlp_init_x86(c, avctx);
+#endif
 }
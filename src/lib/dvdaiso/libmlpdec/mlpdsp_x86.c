@@ -0,0 +1,247 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file mlpdsp_x86.c
+ * AVX2 versions of the MLP channel filter and rematrix.
+ *
+ * The filter is recursive, so instead of vectorizing one channel it runs
+ * four channels in the 64 bit lanes of a vector, two vectors (all eight
+ * channels of a substream) interleaved. The rematrix multiplies one sample
+ * row (MAX_CHANNELS_ALL int32) with the coefficients at a time. Both give
+ * bit exact results, as all products are 32x32->64 bit.
+ */
+
+#include "mlp.h"
+#include "dsputil.h"
+
+#if ARCH_X86
+
+#include <immintrin.h>
+
+void ff_mlp_init_x86(DSPContext* c, AVCodecContext *avctx);
+
+/** Arithmetic right shift of 64 bit lanes by per lane counts. */
+__attribute__((target("avx2")))
+static inline __m256i sra_epi64(__m256i x, __m256i shift)
+{
+	const __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), x);
+	return _mm256_xor_si256(_mm256_srlv_epi64(_mm256_xor_si256(x, sign), shift), sign);
+}
+
+typedef struct FilterLanes {
+	__m256i fir_coeff[MAX_FIR_ORDER];
+	__m256i iir_coeff[MAX_IIR_ORDER];
+	__m256i shift;
+	__m256i mask;
+	__m128i lanes;  ///< load/store mask of the channels in use
+	/** past results and past (result - prediction), newest first from the
+	 *  current position on */
+	__m256i firbuf[MAX_BLOCKSIZE + MAX_FIR_ORDER];
+	__m256i iirbuf[MAX_BLOCKSIZE + MAX_IIR_ORDER];
+} FilterLanes;
+
+__attribute__((target("avx2")))
+static void load_lanes(FilterLanes *f, const ChannelParams *params,
+                       const int32_t *mask, int channels, int blocksize)
+{
+	int64_t fir_coeff[MAX_FIR_ORDER][4] = {{0}}, iir_coeff[MAX_IIR_ORDER][4] = {{0}};
+	int64_t fir_state[MAX_FIR_ORDER][4] = {{0}}, iir_state[MAX_IIR_ORDER][4] = {{0}};
+	int64_t shift[4] = {0}, lane_mask[4] = {0};
+	int32_t lanes[4] = {0};
+	int ch, k;
+
+	for (ch = 0; ch < channels; ch++) {
+		const FilterParams *fir = &params[ch].filter_params[FIR];
+		const FilterParams *iir = &params[ch].filter_params[IIR];
+
+		for (k = 0; k < fir->order; k++)
+			fir_coeff[k][ch] = params[ch].coeff[FIR][k];
+		for (k = 0; k < iir->order; k++)
+			iir_coeff[k][ch] = params[ch].coeff[IIR][k];
+		for (k = 0; k < MAX_FIR_ORDER; k++)
+			fir_state[k][ch] = fir->state[k];
+		for (k = 0; k < MAX_IIR_ORDER; k++)
+			iir_state[k][ch] = iir->state[k];
+
+		shift[ch] = fir->shift;
+		lane_mask[ch] = mask[ch];
+		lanes[ch] = -1;
+	}
+
+	for (k = 0; k < MAX_FIR_ORDER; k++) {
+		f->fir_coeff[k] = _mm256_loadu_si256((const __m256i *)fir_coeff[k]);
+		f->firbuf[blocksize + k] = _mm256_loadu_si256((const __m256i *)fir_state[k]);
+	}
+	for (k = 0; k < MAX_IIR_ORDER; k++) {
+		f->iir_coeff[k] = _mm256_loadu_si256((const __m256i *)iir_coeff[k]);
+		f->iirbuf[blocksize + k] = _mm256_loadu_si256((const __m256i *)iir_state[k]);
+	}
+	f->shift = _mm256_loadu_si256((const __m256i *)shift);
+	f->mask = _mm256_loadu_si256((const __m256i *)lane_mask);
+	f->lanes = _mm_loadu_si128((const __m128i *)lanes);
+}
+
+__attribute__((target("avx2")))
+static void store_lanes(const FilterLanes *f, ChannelParams *params, int channels)
+{
+	int64_t fir_state[MAX_FIR_ORDER][4], iir_state[MAX_IIR_ORDER][4];
+	int ch, k;
+
+	for (k = 0; k < MAX_FIR_ORDER; k++)
+		_mm256_storeu_si256((__m256i *)fir_state[k], f->firbuf[k]);
+	for (k = 0; k < MAX_IIR_ORDER; k++)
+		_mm256_storeu_si256((__m256i *)iir_state[k], f->iirbuf[k]);
+
+	for (ch = 0; ch < channels; ch++) {
+		for (k = 0; k < MAX_FIR_ORDER; k++)
+			params[ch].filter_params[FIR].state[k] = (int32_t)fir_state[k][ch];
+		for (k = 0; k < MAX_IIR_ORDER; k++)
+			params[ch].filter_params[IIR].state[k] = (int32_t)iir_state[k][ch];
+	}
+}
+
+/** Filter one sample of four channels; pos is the index of the new result
+ *  in the history buffers. */
+__attribute__((target("avx2")))
+static inline void filter_sample(FilterLanes *f, int pos, int32_t *sample_buffer)
+{
+	static const int32_t low_halves[8] = {0, 2, 4, 6, 0, 2, 4, 6};
+	const __m256i *firbuf = f->firbuf + pos + 1;
+	const __m256i *iirbuf = f->iirbuf + pos + 1;
+	__m256i accum, residual, result;
+
+	/* only the low 32 bits of each lane are significant, the products
+	 * sign extend them */
+	accum = _mm256_add_epi64(
+		_mm256_add_epi64(
+			_mm256_add_epi64(_mm256_mul_epi32(firbuf[0], f->fir_coeff[0]),
+							 _mm256_mul_epi32(firbuf[1], f->fir_coeff[1])),
+			_mm256_add_epi64(_mm256_mul_epi32(firbuf[2], f->fir_coeff[2]),
+							 _mm256_mul_epi32(firbuf[3], f->fir_coeff[3]))),
+		_mm256_add_epi64(
+			_mm256_add_epi64(_mm256_mul_epi32(firbuf[4], f->fir_coeff[4]),
+							 _mm256_mul_epi32(firbuf[5], f->fir_coeff[5])),
+			_mm256_add_epi64(_mm256_mul_epi32(firbuf[6], f->fir_coeff[6]),
+							 _mm256_mul_epi32(firbuf[7], f->fir_coeff[7]))));
+	accum = _mm256_add_epi64(accum,
+		_mm256_add_epi64(
+			_mm256_add_epi64(_mm256_mul_epi32(iirbuf[0], f->iir_coeff[0]),
+							 _mm256_mul_epi32(iirbuf[1], f->iir_coeff[1])),
+			_mm256_add_epi64(_mm256_mul_epi32(iirbuf[2], f->iir_coeff[2]),
+							 _mm256_mul_epi32(iirbuf[3], f->iir_coeff[3]))));
+
+	accum = sra_epi64(accum, f->shift);
+	residual = _mm256_cvtepi32_epi64(_mm_maskload_epi32(sample_buffer, f->lanes));
+	result = _mm256_and_si256(_mm256_add_epi64(accum, residual), f->mask);
+
+	f->firbuf[pos] = result;
+	f->iirbuf[pos] = _mm256_sub_epi64(result, accum);
+
+	result = _mm256_permutevar8x32_epi32(result, _mm256_loadu_si256((const __m256i *)low_halves));
+	_mm_maskstore_epi32(sample_buffer, f->lanes, _mm256_castsi256_si128(result));
+}
+
+__attribute__((target("avx2")))
+static void mlp_filter_channels_avx2(ChannelParams *params, const int32_t *mask,
+                                     int channels, int blocksize,
+                                     int32_t *sample_buffer)
+{
+	FilterLanes f[2];
+	int i, pos;
+
+	load_lanes(&f[0], params, mask, FFMIN(channels, 4), blocksize);
+
+	if (channels > 4) {
+		load_lanes(&f[1], params + 4, mask + 4, channels - 4, blocksize);
+
+		/* the two chains are independent, interleave them */
+		for (i = 0, pos = blocksize - 1; i < blocksize; i++, pos--) {
+			filter_sample(&f[0], pos, sample_buffer);
+			filter_sample(&f[1], pos, sample_buffer + 4);
+			sample_buffer += MAX_CHANNELS_ALL;
+		}
+
+		store_lanes(&f[1], params + 4, channels - 4);
+	} else {
+		for (i = 0, pos = blocksize - 1; i < blocksize; i++, pos--) {
+			filter_sample(&f[0], pos, sample_buffer);
+			sample_buffer += MAX_CHANNELS_ALL;
+		}
+	}
+
+	store_lanes(&f[0], params, FFMIN(channels, 4));
+}
+
+__attribute__((target("avx2")))
+static void mlp_rematrix_channel_avx2(int32_t *samples, const int32_t *coeffs,
+                                      const int8_t *bypassed_lsbs, const int8_t *noise_buffer,
+                                      int index, unsigned int dest_ch, uint16_t blockpos,
+                                      unsigned int maxchan, int matrix_noise_shift,
+                                      int access_unit_size_pow2, int32_t mask)
+{
+	int32_t row_coeffs[MAX_CHANNELS_ALL] = {0};
+	__m256i even_coeffs, odd_coeffs;
+	unsigned int i;
+	int index2 = 2 * index + 1;
+
+	if (maxchan >= MAX_CHANNELS_ALL) {
+		ff_mlp_rematrix_channel(samples, coeffs, bypassed_lsbs, noise_buffer,
+								index, dest_ch, blockpos, maxchan,
+								matrix_noise_shift, access_unit_size_pow2, mask);
+		return;
+	}
+
+	memcpy(row_coeffs, coeffs, (maxchan + 1) * sizeof(int32_t));
+	even_coeffs = _mm256_loadu_si256((const __m256i *)row_coeffs);
+	odd_coeffs = _mm256_srli_epi64(even_coeffs, 32);
+
+	for (i = 0; i < blockpos; i++) {
+		const __m256i row = _mm256_loadu_si256((const __m256i *)samples);
+		__m256i products = _mm256_add_epi64(_mm256_mul_epi32(row, even_coeffs),
+											_mm256_mul_epi32(_mm256_srli_epi64(row, 32), odd_coeffs));
+		__m128i sum = _mm_add_epi64(_mm256_castsi256_si128(products),
+									_mm256_extracti128_si256(products, 1));
+		int64_t accum;
+
+		sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+		_mm_storel_epi64((__m128i *)&accum, sum);
+
+		if (matrix_noise_shift) {
+			index &= access_unit_size_pow2 - 1;
+			accum += noise_buffer[index] << (matrix_noise_shift + 7);
+			index += index2;
+		}
+
+		samples[dest_ch] = ((accum >> 14) & mask) + *bypassed_lsbs;
+		bypassed_lsbs += MAX_CHANNELS_ALL;
+		samples += MAX_CHANNELS_ALL;
+	}
+}
+
+void ff_mlp_init_x86(DSPContext* c, AVCodecContext *avctx)
+{
+	(void)avctx; // Unused parameter
+
+	if (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) {
+		c->mlp_filter_channels = mlp_filter_channels_avx2;
+		c->mlp_rematrix_channel = mlp_rematrix_channel_avx2;
+	}
+}
+
+#endif /* ARCH_X86 */
@@ -0,0 +1,162 @@
+/*
+* MPD DVD-Audio Decoder plugin
+* Copyright (c) 2014 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* DVD-Audio Decoder is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* DVD-Audio Decoder is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <string.h>
+#include "pcm_unpack.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PCM_UNPACK_SSSE3
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define PCM_UNPACK_NEON
+#include <arm_neon.h>
+#endif
+
+static void map_group(uint8_t* map, int base, int channels, int bits, int first_channel, int total_channels, int sample_size) {
+	for (int i = 0; i < 2 * channels; i++) {
+		uint8_t* out = map + ((i / channels) * total_channels + first_channel + i % channels) * sample_size;
+		if (sample_size == 2) {
+			out[0] = base + 2 * i + 1;
+			out[1] = base + 2 * i;
+		}
+		else {
+			out[0] = pcm_unpack_t::ZERO;
+			out[1] = bits == 24 ? base + 4 * channels + i : pcm_unpack_t::ZERO;
+			out[2] = base + 2 * i + 1;
+			out[3] = base + 2 * i;
+		}
+	}
+}
+
+static void run_scalar(const pcm_unpack_t& unpack, const uint8_t* inp, size_t units, uint8_t* out) {
+	for (size_t n = 0; n < units; n++) {
+		for (int i = 0; i < unpack.out_size; i++) {
+			out[i] = unpack.map[i] == pcm_unpack_t::ZERO ? 0 : inp[unpack.map[i]];
+		}
+		inp += unpack.unit_size;
+		out += unpack.out_size;
+	}
+}
+
+// The vector kernels always load 48 input bytes and store whole 16 byte
+// output chunks per unit. Leave enough trailing units to the scalar kernel
+// so that neither runs past the end of the data.
+static size_t get_vector_units(const pcm_unpack_t& unpack, size_t units) {
+	size_t tail = (3 * 16 + unpack.unit_size - 1) / unpack.unit_size + (16 + unpack.out_size - 1) / unpack.out_size;
+	return units > tail ? units - tail : 0;
+}
+
+#ifdef PCM_UNPACK_SSSE3
+
+__attribute__((target("ssse3")))
+static void run_ssse3(const pcm_unpack_t& unpack, const uint8_t* inp, size_t units, uint8_t* out) {
+	size_t vector_units = get_vector_units(unpack, units);
+	int out_chunks = (unpack.out_size + 15) / 16;
+	__m128i m[3][3];
+	for (int k = 0; k < 3; k++) {
+		for (int j = 0; j < 3; j++) {
+			m[k][j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(unpack.chunk_map[k][j]));
+		}
+	}
+	for (size_t n = 0; n < vector_units; n++) {
+		__m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inp));
+		__m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inp + 16));
+		__m128i in2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inp + 32));
+		for (int k = 0; k < out_chunks; k++) {
+			__m128i r = _mm_or_si128(_mm_shuffle_epi8(in0, m[k][0]), _mm_or_si128(_mm_shuffle_epi8(in1, m[k][1]), _mm_shuffle_epi8(in2, m[k][2])));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * k), r);
+		}
+		inp += unpack.unit_size;
+		out += unpack.out_size;
+	}
+	run_scalar(unpack, inp, units - vector_units, out);
+}
+
+#endif
+
+#ifdef PCM_UNPACK_NEON
+
+// tbl with three table registers covers the whole unit, out of range
+// indices (ZERO) produce zero bytes
+static void run_neon(const pcm_unpack_t& unpack, const uint8_t* inp, size_t units, uint8_t* out) {
+	size_t vector_units = get_vector_units(unpack, units);
+	int out_chunks = (unpack.out_size + 15) / 16;
+	uint8x16_t m[3];
+	for (int k = 0; k < 3; k++) {
+		m[k] = vld1q_u8(unpack.map + 16 * k);
+	}
+	for (size_t n = 0; n < vector_units; n++) {
+		uint8x16x3_t t = {{vld1q_u8(inp), vld1q_u8(inp + 16), vld1q_u8(inp + 32)}};
+		for (int k = 0; k < out_chunks; k++) {
+			vst1q_u8(out + 16 * k, vqtbl3q_u8(t, m[k]));
+		}
+		inp += unpack.unit_size;
+		out += unpack.out_size;
+	}
+	run_scalar(unpack, inp, units - vector_units, out);
+}
+
+#endif
+
+pcm_unpack_t::pcm_unpack_t() {
+	unit_size = 0;
+	out_size = 0;
+	memset(map, ZERO, sizeof(map));
+	memset(chunk_map, 0x80, sizeof(chunk_map));
+	run = run_scalar;
+}
+
+bool pcm_unpack_t::init(int group1_channels, int group1_bits, int group2_channels, int group2_bits) {
+	if (group2_channels == 0) {
+		group2_bits = 0;
+	}
+	if (!(group1_bits == 16 || group1_bits == 24) || !(group2_bits == 0 || group2_bits == 16 || group2_bits == 24)) {
+		return false;
+	}
+	if (group1_bits == 16 && group2_bits > 16) {
+		return false;
+	}
+	int sample_size = group1_bits > 16 ? 4 : 2;
+	int group2_size = group2_channels * group2_bits / 4;
+	unit_size = group1_channels * group1_bits / 4 + group2_size;
+	out_size = 2 * (group1_channels + group2_channels) * sample_size;
+	if (unit_size == 0 || unit_size > MAX_UNIT_SIZE || out_size > MAX_UNIT_SIZE) {
+		return false;
+	}
+	memset(map, ZERO, sizeof(map));
+	map_group(map, 0, group2_channels, group2_bits, group1_channels, group1_channels + group2_channels, sample_size);
+	map_group(map, group2_size, group1_channels, group1_bits, 0, group1_channels + group2_channels, sample_size);
+	for (int k = 0; k < 3; k++) {
+		for (int j = 0; j < 3; j++) {
+			for (int b = 0; b < 16; b++) {
+				uint8_t index = map[16 * k + b];
+				chunk_map[k][j][b] = (index != ZERO && index / 16 == j) ? index % 16 : 0x80;
+			}
+		}
+	}
+	run = run_scalar;
+#if defined(PCM_UNPACK_SSSE3)
+	if (__builtin_cpu_supports("ssse3")) {
+		run = run_ssse3;
+	}
+#elif defined(PCM_UNPACK_NEON)
+	run = run_neon;
+#endif
+	return true;
+}
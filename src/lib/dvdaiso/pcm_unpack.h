@@ -0,0 +1,58 @@
+/*
+* MPD DVD-Audio Decoder plugin
+* Copyright (c) 2014 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* DVD-Audio Decoder is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* DVD-Audio Decoder is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _PCM_UNPACK_H_INCLUDED
+#define _PCM_UNPACK_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A DVD-Audio LPCM sample unit holds two samples per channel of group 2
+// followed by group 1; each group stores the big endian upper 16 bits of all
+// its samples first, then their lower bits. With 16 or 24 bit samples the
+// conversion of a unit into interleaved S16 (16 bit streams) or left aligned
+// S32 samples is a fixed byte shuffle, which pcm_unpack_t precomputes once.
+class pcm_unpack_t {
+public:
+	static const int MAX_UNIT_SIZE = 48;
+	static const uint8_t ZERO = 0xff;
+
+	typedef void (*run_t)(const pcm_unpack_t& unpack, const uint8_t* inp, size_t units, uint8_t* out);
+
+	int     unit_size; // input bytes per unit
+	int     out_size;  // output bytes per unit
+	uint8_t map[MAX_UNIT_SIZE];         // source byte of each output byte or ZERO
+	uint8_t chunk_map[3][3][16];        // map split into 16 byte input/output chunks
+	run_t   run;
+
+	pcm_unpack_t();
+
+	// Returns false if the layout is not a plain byte shuffle (20 bit
+	// samples, too many channels). Group 2 at a lower sample rate than
+	// group 1 does not have uniform units either, the caller checks that.
+	bool init(int group1_channels, int group1_bits, int group2_channels, int group2_bits);
+
+	// Unpacks whole units, returns the number of output bytes
+	size_t unpack(const uint8_t* inp, size_t units, uint8_t* out) const {
+		run(*this, inp, units, out);
+		return units * out_size;
+	}
+};
+
+#endif
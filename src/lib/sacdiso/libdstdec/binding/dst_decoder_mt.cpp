@@ -17,10 +17,13 @@
 * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
+
 #include <stdlib.h>
 #include <memory.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <chrono>
+#include <system_error>
 #include "dst_decoder_mt.h"
 
 #define DSD_SILENCE_BYTE 0x69
@@ -31,36 +34,112 @@
 
 #define LOG(p1, p2) log_printf("%s%s", p1, p2)
 
-static void dst_run_thread(frame_slot_t& slot) {
-	while (slot.run_slot) {
-		slot.dst_semaphore.wait();
-		if (slot.run_slot) {
-			slot.state = slot_state_t::SLOT_RUNNING;
-			slot.dec.decode(slot.dst_data, slot.dst_size * 8, slot.dsd_data);
-			slot.state = slot_state_t::SLOT_READY;
+using std::lock_guard;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+
+dst_worker_t::dst_worker_t() {
+	run_worker = true;
+	run_thread = thread(&dst_worker_t::run, this);
+}
+
+dst_worker_t::~dst_worker_t() {
+	run_worker = false;
+	job_event.notify(); // Release worker (decoding) thread for exit
+	run_thread.join(); // Wait until worker (decoding) thread exit
+}
+
+void dst_worker_t::submit(frame_slot_t* slot) {
+	while (!jobs.push(slot)) {
+		std::this_thread::yield();
+	}
+	job_event.notify();
+}
+
+void dst_worker_t::wait(frame_slot_t* slot) {
+	done_event.wait([slot] { return slot->state.load(memory_order_acquire) != slot_state_t::SLOT_LOADED; });
+}
+
+size_t dst_worker_t::get_queue_depth() {
+	return jobs.size();
+}
+
+void dst_worker_t::run() {
+	for (;;) {
+		job_event.wait([this] { return jobs.size() > 0 || !run_worker.load(); });
+		if (!run_worker) {
+			break;
 		}
-		else {
-			slot.dsd_data = nullptr;
-			slot.dst_size = 0;
+		frame_slot_t* slot;
+		while (jobs.pop(slot)) {
+			auto t0 = std::chrono::steady_clock::now();
+			slot->dec.decode(slot->dst_data, slot->dst_size * 8, slot->dsd_data);
+			auto t1 = std::chrono::steady_clock::now();
+			slot->decode_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+			slot->state.store(slot_state_t::SLOT_READY, memory_order_release);
+			done_event.notify();
 		}
-		slot.dsd_semaphore.notify();
 	}
 }
 
+dst_worker_pool_t& dst_worker_pool_t::get_instance() {
+	static dst_worker_pool_t pool;
+	return pool;
+}
+
+vector<dst_worker_t*> dst_worker_pool_t::lease(unsigned int count) {
+	lock_guard<mutex> lock(pool_mutex);
+	vector<dst_worker_t*> leased;
+	while (leased.size() < count) {
+		if (idle_workers.empty()) {
+			try {
+				workers.emplace_back(new dst_worker_t);
+			}
+			catch (const std::system_error&) {
+				LOG(LOG_ERROR, ("Could not start decoder thread"));
+				break;
+			}
+			idle_workers.push_back(workers.back().get());
+		}
+		leased.push_back(idle_workers.back());
+		idle_workers.pop_back();
+	}
+	return leased;
+}
+
+void dst_worker_pool_t::release(vector<dst_worker_t*>& leased) {
+	lock_guard<mutex> lock(pool_mutex);
+	idle_workers.insert(idle_workers.end(), leased.begin(), leased.end());
+	leased.clear();
+}
+
+size_t dst_worker_pool_t::get_size() {
+	lock_guard<mutex> lock(pool_mutex);
+	return workers.size();
+}
+
 dst_decoder_t::dst_decoder_t(unsigned int threads) {
 	frame_slots.resize(threads);
 	slot_nr            = 0;
 	channel_count      = 0;
 	channel_frame_size = 0;
+	frame_nr           = 0;
+	stats              = {};
 }
 
 dst_decoder_t::~dst_decoder_t() {
-	for (auto& slot : frame_slots) {
+	for (size_t i = 0; i < frame_slots.size(); i++) {
+		auto& slot = frame_slots[i];
+		if (slot.state.load(memory_order_acquire) == slot_state_t::SLOT_LOADED) {
+			// the worker still references the slot (and the caller's buffers)
+			workers[i % workers.size()]->wait(&slot);
+		}
 		slot.state = slot_state_t::SLOT_TERMINATING;
 		slot.dec.close();
-		slot.run_slot = false;
-		slot.dst_semaphore.notify(); // Release worker (decoding) thread for exit
-		slot.run_thread.join(); // Wait until worker (decoding) thread exit
+	}
+	if (!workers.empty()) {
+		dst_worker_pool_t::get_instance().release(workers);
 	}
 }   
 
@@ -68,6 +147,10 @@ unsigned int dst_decoder_t::get_slot_nr() {
 	return slot_nr;
 }
 
+const dst_decoder_stats_t& dst_decoder_t::get_stats() {
+	return stats;
+}
+
 int dst_decoder_t::init(unsigned int channels, unsigned int samplerate, unsigned int framerate) {
 	channel_count = channels;
 	channel_frame_size = samplerate / 8 / framerate;
@@ -76,22 +159,33 @@ int dst_decoder_t::init(unsigned int channels, unsigned int samplerate, unsigned
 			slot.channel_count = channel_count;
 			slot.channel_frame_size = channel_frame_size;
 			slot.dsd_size = (size_t)(channel_count * channel_frame_size);
-			slot.run_slot = true;
-			slot.run_thread = thread(dst_run_thread, ref(slot));
-			if (!slot.run_thread.joinable()) {
-				LOG(LOG_ERROR, ("Could not start decoder thread"));
-				return -1;
-			}
 		}
 		else {
 			LOG(LOG_ERROR, ("Could not initialize decoder slot"));
 			return -1;
 		}
 	}
+	workers = dst_worker_pool_t::get_instance().lease(frame_slots.size());
+	if (workers.empty()) {
+		return -1;
+	}
 	return 0;
 }
 
-int dst_decoder_t::decode(uint8_t* dst_data, size_t dst_size, uint8_t** dsd_data, size_t* dsd_size) {
+// Discard all frames still in flight, e.g. after a seek: they belong to the
+// old position and would otherwise be returned ahead of the new one.
+void dst_decoder_t::flush() {
+	for (size_t i = 0; i < frame_slots.size(); i++) {
+		auto& slot = frame_slots[i];
+		if (slot.state.load(memory_order_acquire) == slot_state_t::SLOT_LOADED) {
+			workers[i % workers.size()]->wait(&slot);
+		}
+		slot.state.store(slot_state_t::SLOT_EMPTY, memory_order_relaxed);
+	}
+	stats.queue_depth = 0;
+}
+
+int dst_decoder_t::decode(const uint8_t* dst_data, size_t dst_size, uint8_t** dsd_data, size_t* dsd_size) {
 
 	/* Get current slot */
 	frame_slot_t& slot_set = frame_slots[slot_nr];
@@ -101,13 +195,18 @@ int dst_decoder_t::decode(uint8_t* dst_data, size_t dst_size, uint8_t** dsd_data
 	slot_set.dst_data = dst_data;
 	slot_set.dst_size = dst_size;
     
-	/* Release worker (decoding) thread on the loaded slot */
+	/* Queue the loaded slot to its worker (decoding) thread */
 	if (dst_size > 0)	{
-		slot_set.state = slot_state_t::SLOT_LOADED;
-		slot_set.dst_semaphore.notify();
+		slot_set.frame_nr = frame_nr++;
+		slot_set.state.store(slot_state_t::SLOT_LOADED, memory_order_relaxed);
+		workers[slot_nr % workers.size()]->submit(&slot_set);
+		stats.queue_depth++;
+		if (stats.queue_depth > stats.queue_depth_max) {
+			stats.queue_depth_max = stats.queue_depth;
+		}
 	}
 	else {
-		slot_set.state = slot_state_t::SLOT_EMPTY;
+		slot_set.state.store(slot_state_t::SLOT_EMPTY, memory_order_relaxed);
 	}
 
 	/* Move to the oldest slot */
@@ -115,10 +214,12 @@ int dst_decoder_t::decode(uint8_t* dst_data, size_t dst_size, uint8_t** dsd_data
 	frame_slot_t& slot_get = frame_slots[slot_nr];
 
 	/* Dump decoded frame */
-	if (slot_get.state != slot_state_t::SLOT_EMPTY) {
-		slot_get.dsd_semaphore.wait();
+	auto state = slot_get.state.load(memory_order_acquire);
+	if (state == slot_state_t::SLOT_LOADED) {
+		workers[slot_nr % workers.size()]->wait(&slot_get);
+		state = slot_get.state.load(memory_order_acquire);
 	}
-	switch (slot_get.state) {
+	switch (state) {
 	case slot_state_t::SLOT_READY:
 		*dsd_data = slot_get.dsd_data;
 		*dsd_size = (size_t)(channel_count * channel_frame_size);
@@ -133,5 +234,14 @@ int dst_decoder_t::decode(uint8_t* dst_data, size_t dst_size, uint8_t** dsd_data
 		*dsd_size = 0;
 		break;
 	}
+	if (state == slot_state_t::SLOT_READY || state == slot_state_t::SLOT_READY_WITH_ERROR) {
+		stats.queue_depth--;
+		stats.frames++;
+		stats.decode_ns_total += slot_get.decode_ns;
+		if (slot_get.decode_ns > stats.decode_ns_max) {
+			stats.decode_ns_max = slot_get.decode_ns;
+		}
+		slot_get.state.store(slot_state_t::SLOT_EMPTY, memory_order_relaxed);
+	}
 	return 0;
 }
@@ -17,40 +17,46 @@
 * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
+
 #ifndef _DST_DECODER_MT_H_INCLUDED
 #define _DST_DECODER_MT_H_INCLUDED
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 #include <semaphore.h>
+#include <spsc_ring.h>
 #include "decoder.h"
 
+using std::atomic;
+using std::mutex;
 using std::thread;
+using std::unique_ptr;
 using std::vector;
-using std::ref;
 using dst::decoder_t;
 
 enum class slot_state_t {SLOT_EMPTY, SLOT_LOADED, SLOT_RUNNING, SLOT_READY, SLOT_READY_WITH_ERROR, SLOT_TERMINATING};
 
 class frame_slot_t {
 public:
-	bool         run_slot;
-	thread       run_thread;
-	semaphore    dsd_semaphore;
-	semaphore    dst_semaphore;
+	atomic<slot_state_t> state;
+	uint64_t             frame_nr;    // sequence number of the loaded frame
+	uint64_t             decode_ns;   // decode time of the frame, set by the worker
 
-	slot_state_t state;
 	uint8_t*     dsd_data;
 	unsigned int dsd_size;
-	uint8_t*     dst_data;
+	const uint8_t* dst_data;
 	unsigned int dst_size;
 	unsigned int channel_count;
 	unsigned int channel_frame_size;
 	decoder_t    dec;
 
 	frame_slot_t() {
-		run_slot = false;
 		state = slot_state_t::SLOT_EMPTY;
+		frame_nr = 0;
+		decode_ns = 0;
 		dsd_data = nullptr;
 		dsd_size = 0;
 		dst_data = nullptr;
@@ -59,8 +65,9 @@ public:
 		channel_frame_size = 0;
 	}
 	frame_slot_t(const frame_slot_t& slot) {
-		run_slot = slot.run_slot;
-		state = slot.state;
+		state = slot.state.load();
+		frame_nr = slot.frame_nr;
+		decode_ns = slot.decode_ns;
 		dsd_data = slot.dsd_data;
 		dsd_size = slot.dsd_size;
 		dst_data = slot.dst_data;
@@ -71,17 +78,66 @@ public:
 	frame_slot_t& operator=(const frame_slot_t& slot) = delete;
 };
 
+// Persistent decoding thread. While leased it is fed by exactly one
+// dst_decoder_t through a lock-free single producer/single consumer ring.
+// The completion event lives here rather than in the slot: the worker must
+// not touch a slot once it has been marked ready.
+class dst_worker_t {
+	spsc_ring_t<frame_slot_t*, 8> jobs;
+	lazy_event_t                  job_event;
+	lazy_event_t                  done_event;
+	atomic<bool>                  run_worker;
+	thread                        run_thread;
+public:
+	dst_worker_t();
+	~dst_worker_t();
+	dst_worker_t(const dst_worker_t& worker) = delete;
+	dst_worker_t& operator=(const dst_worker_t& worker) = delete;
+	void submit(frame_slot_t* slot);
+	void wait(frame_slot_t* slot);
+	size_t get_queue_depth();
+private:
+	void run();
+};
+
+// Process wide pool of DST decoding threads, shared by all tracks and all
+// concurrent decoders so that no threads are created or joined at track
+// boundaries. The pool only grows up to the largest concurrent demand.
+class dst_worker_pool_t {
+	mutex                        pool_mutex;
+	vector<unique_ptr<dst_worker_t>> workers;
+	vector<dst_worker_t*>        idle_workers;
+public:
+	static dst_worker_pool_t& get_instance();
+	vector<dst_worker_t*> lease(unsigned int count);
+	void release(vector<dst_worker_t*>& leased);
+	size_t get_size();
+};
+
+struct dst_decoder_stats_t {
+	uint64_t     frames;          // frames decoded
+	uint64_t     decode_ns_total; // sum of the per-frame decode times
+	uint64_t     decode_ns_max;   // slowest frame
+	unsigned int queue_depth;     // frames currently in flight
+	unsigned int queue_depth_max;
+};
+
 class dst_decoder_t {
-	vector<frame_slot_t> frame_slots;
+	vector<frame_slot_t>  frame_slots;
+	vector<dst_worker_t*> workers;
 	unsigned int slot_nr;       
 	unsigned int channel_count;
 	unsigned int channel_frame_size;
+	uint64_t     frame_nr;
+	dst_decoder_stats_t stats;
 public:
 	dst_decoder_t(unsigned int threads);
 	~dst_decoder_t();
 	unsigned int get_slot_nr();
+	const dst_decoder_stats_t& get_stats();
 	int init(unsigned int channels, unsigned int samplerate, unsigned int framerate);
-	int decode(uint8_t* dst_data, size_t dst_size, uint8_t** dsd_data, size_t* dsd_size);
+	void flush();
+	int decode(const uint8_t* dst_data, size_t dst_size, uint8_t** dsd_data, size_t* dsd_size);
 };
 
 #endif
@@ -20,8 +20,10 @@
 #ifndef _SEMAPHORE_H_INCLUDED
 #define _SEMAPHORE_H_INCLUDED
 
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
 
 using std::mutex;
 using std::condition_variable;
@@ -59,4 +61,41 @@ public:
 	}
 };
 
+// Wakeup for a single waiter which only touches the semaphore when the
+// waiter is actually about to block: the notifier pays one atomic
+// exchange, the waiter spins briefly before it announces itself.
+class lazy_event_t {
+	static constexpr int SPIN_COUNT = 16;
+	std::atomic<bool> waiting{false};
+	semaphore         sem;
+public:
+	template<typename Ready>
+	void wait(Ready ready) {
+		for (int i = 0; i < SPIN_COUNT; i++) {
+			if (ready()) {
+				return;
+			}
+			std::this_thread::yield();
+		}
+		for (;;) {
+			waiting.store(true);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (ready()) {
+				waiting.store(false);
+				return;
+			}
+			sem.wait();
+			if (ready()) {
+				return;
+			}
+		}
+	}
+	void notify() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (waiting.exchange(false)) {
+			sem.notify();
+		}
+	}
+};
+
 #endif
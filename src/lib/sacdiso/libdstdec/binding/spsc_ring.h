@@ -0,0 +1,66 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _SPSC_RING_H_INCLUDED
+#define _SPSC_RING_H_INCLUDED
+
+#include <stddef.h>
+#include <atomic>
+
+using std::atomic;
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+
+// Bounded lock-free ring for exactly one producer and one consumer thread.
+// N must be a power of two.
+template<typename T, size_t N>
+class spsc_ring_t {
+	static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+	alignas(64) atomic<size_t> head{0}; // next item to pop, owned by the consumer
+	alignas(64) atomic<size_t> tail{0}; // next item to push, owned by the producer
+	T items[N];
+public:
+	spsc_ring_t() = default;
+	spsc_ring_t(const spsc_ring_t& ring) = delete;
+	spsc_ring_t& operator=(const spsc_ring_t& ring) = delete;
+	bool push(const T& item) {
+		size_t t = tail.load(memory_order_relaxed);
+		if (t - head.load(memory_order_acquire) == N) {
+			return false;
+		}
+		items[t & (N - 1)] = item;
+		tail.store(t + 1, memory_order_release);
+		return true;
+	}
+	bool pop(T& item) {
+		size_t h = head.load(memory_order_relaxed);
+		if (h == tail.load(memory_order_acquire)) {
+			return false;
+		}
+		item = items[h & (N - 1)];
+		head.store(h + 1, memory_order_release);
+		return true;
+	}
+	size_t size() const {
+		return tail.load(memory_order_acquire) - head.load(memory_order_acquire);
+	}
+};
+
+#endif
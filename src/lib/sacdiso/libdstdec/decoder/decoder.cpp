@@ -40,6 +40,7 @@ decoder_t::decoder_t() {
 		}
 		GC_ICoefInit = true;
 	}
+	RunFilters = get_run_filters();
 }
 
 decoder_t::~decoder_t() {
@@ -51,8 +52,10 @@ int decoder_t::init(unsigned int channels, unsigned int channel_frame_size) {
 	m_pt.init(2 * channels);
 	P_one.resize(2 * channels);
 	AData.resize(channels * channel_frame_size);
-	LT_ICoefI.resize(2 * channels);
+	LT_ICoefI.resize(2 * channels + 1); // spare table for the overread of vector kernels
 	LT_Status.resize(channels);
+	LT_Filters.resize(channels);
+	LT_Predict.resize(channels);
 	return 0;
 }
 
@@ -91,14 +94,18 @@ int decoder_t::decode(const uint8_t* dst_data, unsigned int dst_bits, uint8_t* d
 
 		memset(dsd_data, 0, (NrOfBitsPerCh * NrOfChannels + 7) / 8);
 		for (auto BitNr = 0u; BitNr < NrOfBitsPerCh; BitNr++) {
+			/* Calculate output value of the FIR filters, all channels at once: */
+			/* they only depend on the previous bits of each channel           */
 			for (auto ChNr = 0u; ChNr < NrOfChannels; ChNr++) {
-				int16_t Predict;
-				uint8_t Residual;
-				int16_t BitVal;
 				auto FilterNr = GET_NIBBLE(m_fr.Filter4Bit[ChNr].data(), BitNr);
+				LT_Filters[ChNr] = &LT_ICoefI[FilterNr];
+			}
+			RunFilters(LT_Filters.data(), LT_Status.data(), NrOfChannels, LT_Predict.data());
 
-				/* Calculate output value of the FIR filter */
-				Predict = LT_RunFilter(LT_ICoefI[FilterNr], LT_Status[ChNr]);
+			for (auto ChNr = 0u; ChNr < NrOfChannels; ChNr++) {
+				int16_t Predict = LT_Predict[ChNr];
+				uint8_t Residual;
+				int16_t BitVal;
 
 				/* Arithmetic decode the incoming bit */
 				if ((m_fr.HalfProb[ChNr]/* == 1*/) && (BitNr < m_fr.NrOfHalfBits[ChNr])) {
@@ -209,7 +216,7 @@ void decoder_t::fillTable4Bit(segment_t& S, vector<vector<uint8_t>>& Table4Bit)
 	}
 }
 
-void decoder_t::LT_InitCoefTables(vector<array<array<int16_t, 256>, 16>>& ICoefI) {
+void decoder_t::LT_InitCoefTables(vector<fir_table_t>& ICoefI) {
 	for (auto FilterNr = 0u; FilterNr < m_fr.NrOfFilters; FilterNr++) {
 		auto FilterLength = m_fr.PredOrder[FilterNr];
 		for (auto TableNr = 0u; TableNr < 16u; TableNr++) {
@@ -231,7 +238,7 @@ void decoder_t::LT_InitCoefTables(vector<array<array<int16_t, 256>, 16>>& ICoefI
 	}
 }
 
-void decoder_t::GC_InitCoefTables(vector<array<array<int16_t, 256>, 16>>& ICoefI) {
+void decoder_t::GC_InitCoefTables(vector<fir_table_t>& ICoefI) {
 	for (auto FilterNr = 0u; FilterNr < m_fr.NrOfFilters; FilterNr++) {
 		auto FilterLength = m_fr.PredOrder[FilterNr];
 		for (auto TableNr = 0u; TableNr < 16u; TableNr++) {
@@ -259,7 +266,7 @@ void decoder_t::GC_InitCoefTables(vector<array<array<int16_t, 256>, 16>>& ICoefI
 	}
 }
 
-void decoder_t::LT_InitStatus(vector<array<uint8_t, 16>>& Status) {
+void decoder_t::LT_InitStatus(vector<fir_status_t>& Status) {
 	for (auto ChNr = 0u; ChNr < m_fr.NrOfChannels; ChNr++) {
 		for (auto TableNr = 0u; TableNr < 16u; TableNr++) {
 			Status[ChNr][TableNr] = 0xaa;
@@ -267,25 +274,4 @@ void decoder_t::LT_InitStatus(vector<array<uint8_t, 16>>& Status) {
 	}
 }
 
-int16_t decoder_t::LT_RunFilter(array<array<int16_t, 256>, 16>& FilterTable, array<uint8_t, 16>& ChannelStatus) {
-	int Predict;
-	Predict = FilterTable[0][ChannelStatus[0]];
-	Predict += FilterTable[1][ChannelStatus[1]];
-	Predict += FilterTable[2][ChannelStatus[2]];
-	Predict += FilterTable[3][ChannelStatus[3]];
-	Predict += FilterTable[4][ChannelStatus[4]];
-	Predict += FilterTable[5][ChannelStatus[5]];
-	Predict += FilterTable[6][ChannelStatus[6]];
-	Predict += FilterTable[7][ChannelStatus[7]];
-	Predict += FilterTable[8][ChannelStatus[8]];
-	Predict += FilterTable[9][ChannelStatus[9]];
-	Predict += FilterTable[10][ChannelStatus[10]];
-	Predict += FilterTable[11][ChannelStatus[11]];
-	Predict += FilterTable[12][ChannelStatus[12]];
-	Predict += FilterTable[13][ChannelStatus[13]];
-	Predict += FilterTable[14][ChannelStatus[14]];
-	Predict += FilterTable[15][ChannelStatus[15]];
-	return (int16_t)Predict;
-}
-
 }
@@ -15,6 +15,7 @@
 #include "ac.h"
 #include "fr.h"
 #include "stream.h"
+#include "fir.h"
 
 using std::array;
 using std::vector;
@@ -33,8 +34,12 @@ public:
 	vector<array<unsigned int, AC_HISMAX>> P_one; // Probability table for arithmetic coder
 	vector<uint8_t> AData;                        // Contains the arithmetic coded bit stream of a complete frame	vector<uint8_t> AData;               // Contains the arithmetic coded bit stream of a complete frame
 	int             ADataLen;                     // Number of code bits contained in AData[]
-	vector<array<array<int16_t, 256>, 16>> LT_ICoefI;
-	vector<array<uint8_t, 16>>             LT_Status;
+	vector<fir_table_t>  LT_ICoefI;
+	vector<fir_status_t> LT_Status;
+	run_filters_t        RunFilters;              // FIR kernel, see get_run_filters()
+private:
+	vector<const fir_table_t*> LT_Filters;        // Filter used by each channel for the current bit
+	vector<int16_t>            LT_Predict;        // Prediction of each channel for the current bit
 public:
 	decoder_t();
 	~decoder_t();
@@ -45,10 +50,9 @@ private:
 	int unpack(const uint8_t* dst_data, uint8_t* dsd_data);
 	int16_t reverse7LSBs(int16_t c);
 	void fillTable4Bit(segment_t& S, vector<vector<uint8_t>>& Table4Bit);
-	void LT_InitCoefTables(vector<array<array<int16_t, 256>, 16>>& ICoefI);
-	void GC_InitCoefTables(vector<array<array<int16_t, 256>, 16>>& ICoefI);
-	void LT_InitStatus(vector<array<uint8_t, 16>>& Status);
-	int16_t LT_RunFilter(array<array<int16_t, 256>, 16>& FilterTable, array<uint8_t, 16>& ChannelStatus);
+	void LT_InitCoefTables(vector<fir_table_t>& ICoefI);
+	void GC_InitCoefTables(vector<fir_table_t>& ICoefI);
+	void LT_InitStatus(vector<fir_status_t>& Status);
 };
 
 }
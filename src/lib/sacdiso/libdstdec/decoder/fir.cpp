@@ -0,0 +1,73 @@
+/*
+* Direct Stream Transfer (DST) codec
+* ISO/IEC 14496-3 Part 3 Subpart 10: Technical description of lossless coding of oversampled audio
+*/
+
+#include "fir.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DST_FIR_AVX2
+#include <immintrin.h>
+#endif
+
+namespace dst {
+
+void run_filters_scalar(const fir_table_t* const* tables, const fir_status_t* status, unsigned int channel_count, int16_t* predict) {
+	for (auto ChNr = 0u; ChNr < channel_count; ChNr++) {
+		const fir_table_t& FilterTable = *tables[ChNr];
+		const fir_status_t& ChannelStatus = status[ChNr];
+		int Predict;
+		Predict = FilterTable[0][ChannelStatus[0]];
+		Predict += FilterTable[1][ChannelStatus[1]];
+		Predict += FilterTable[2][ChannelStatus[2]];
+		Predict += FilterTable[3][ChannelStatus[3]];
+		Predict += FilterTable[4][ChannelStatus[4]];
+		Predict += FilterTable[5][ChannelStatus[5]];
+		Predict += FilterTable[6][ChannelStatus[6]];
+		Predict += FilterTable[7][ChannelStatus[7]];
+		Predict += FilterTable[8][ChannelStatus[8]];
+		Predict += FilterTable[9][ChannelStatus[9]];
+		Predict += FilterTable[10][ChannelStatus[10]];
+		Predict += FilterTable[11][ChannelStatus[11]];
+		Predict += FilterTable[12][ChannelStatus[12]];
+		Predict += FilterTable[13][ChannelStatus[13]];
+		Predict += FilterTable[14][ChannelStatus[14]];
+		Predict += FilterTable[15][ChannelStatus[15]];
+		predict[ChNr] = (int16_t)Predict;
+	}
+}
+
+#ifdef DST_FIR_AVX2
+
+// Gather the 16 table entries of a channel with two 8 lane gathers. The
+// gathers load 32 bits at 16 bit offsets; the upper halves are garbage but
+// do not affect the low 16 bits of the sum.
+__attribute__((target("avx2")))
+static void run_filters_avx2(const fir_table_t* const* tables, const fir_status_t* status, unsigned int channel_count, int16_t* predict) {
+	const __m256i offsets_lo = _mm256_setr_epi32(0 * 256, 1 * 256, 2 * 256, 3 * 256, 4 * 256, 5 * 256, 6 * 256, 7 * 256);
+	const __m256i offsets_hi = _mm256_setr_epi32(8 * 256, 9 * 256, 10 * 256, 11 * 256, 12 * 256, 13 * 256, 14 * 256, 15 * 256);
+	for (auto ChNr = 0u; ChNr < channel_count; ChNr++) {
+		const int* base = reinterpret_cast<const int*>((*tables[ChNr])[0].data());
+		__m128i st = _mm_loadu_si128(reinterpret_cast<const __m128i*>(status[ChNr].data()));
+		__m256i index_lo = _mm256_add_epi32(_mm256_cvtepu8_epi32(st), offsets_lo);
+		__m256i index_hi = _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(st, 8)), offsets_hi);
+		__m256i sum = _mm256_add_epi32(_mm256_i32gather_epi32(base, index_lo, 2), _mm256_i32gather_epi32(base, index_hi, 2));
+		__m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+		predict[ChNr] = (int16_t)_mm_cvtsi128_si32(s);
+	}
+}
+
+#endif
+
+run_filters_t get_run_filters() {
+#ifdef DST_FIR_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return run_filters_avx2;
+	}
+#endif
+	return run_filters_scalar;
+}
+
+}
@@ -0,0 +1,37 @@
+/*
+* Direct Stream Transfer (DST) codec
+* ISO/IEC 14496-3 Part 3 Subpart 10: Technical description of lossless coding of oversampled audio
+*/
+
+#ifndef FIR_H
+#define FIR_H
+
+#include <stdint.h>
+#include <array>
+
+using std::array;
+
+namespace dst {
+
+// Lookup tables of one prediction filter: 16 tables of 8 taps each,
+// indexed by 8 bits of the channel history
+using fir_table_t = array<array<int16_t, 256>, 16>;
+
+// The last 128 output bits of a channel
+using fir_status_t = array<uint8_t, 16>;
+
+// Compute the FIR prediction of channel_count channels; channel ChNr runs
+// filter tables[ChNr] over status[ChNr]. Only the low 16 bits of the sum
+// are significant.
+typedef void (*run_filters_t)(const fir_table_t* const* tables, const fir_status_t* status, unsigned int channel_count, int16_t* predict);
+
+void run_filters_scalar(const fir_table_t* const* tables, const fir_status_t* status, unsigned int channel_count, int16_t* predict);
+
+// The fastest implementation supported by the running CPU. Vector kernels
+// may read 2 bytes past the end of a table, callers allocate one spare
+// fir_table_t after the last one.
+run_filters_t get_run_filters();
+
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include <string>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 #include "sacd_disc.h"
 #include "util/StringView.hxx"
 
@@ -110,11 +111,21 @@ static inline std::string charset_convert(const char* instring, size_t insize, u
 
 sacd_disc_t::sacd_disc_t() {
 	sacd_media = nullptr;
+	sb_toc = &sb_handle;
 	sb_handle.master_data = nullptr;
 	sb_handle.twoch_area_idx = -1;
 	sb_handle.mulch_area_idx = -1;
 	sb_handle.area_count = 0;
 	track_area = AREA_BOTH;
+	is_emaster = false;
+	is_dst_encoded = false;
+	read_buffer_lsn = 0;
+	read_buffer_sectors = 0;
+	read_ahead_size = SACD_READ_AHEAD_SIZE;
+	buffer = nullptr;
+	buffer_mapped = false;
+	frame_starts_to_skip = 0;
+	frame_index = &frame_index_store;
 }
 
 sacd_disc_t::~sacd_disc_t() {
@@ -122,19 +133,19 @@ sacd_disc_t::~sacd_disc_t() {
 }
 
 scarletbook_handle_t* sacd_disc_t::get_handle() {
-	return &sb_handle;
+	return sb_toc;
 }
 
 scarletbook_area_t* sacd_disc_t::get_area(area_id_e area_id) {
 	switch (area_id) {
 	case AREA_TWOCH:
-		if (sb_handle.twoch_area_idx != -1) {
-			return &sb_handle.area[sb_handle.twoch_area_idx];
+		if (sb_toc->twoch_area_idx != -1) {
+			return &sb_toc->area[sb_toc->twoch_area_idx];
 		}
 		break;
 	case AREA_MULCH:
-		if (sb_handle.mulch_area_idx != -1) {
-			return &sb_handle.area[sb_handle.mulch_area_idx];
+		if (sb_toc->mulch_area_idx != -1) {
+			return &sb_toc->area[sb_toc->mulch_area_idx];
 		}
 		break;
 	default:
@@ -289,25 +300,18 @@ void sacd_disc_t::set_emaster(bool emaster) {
 	is_emaster = emaster;
 }
 
-bool sacd_disc_t::open(sacd_media_t* _sacd_media, open_mode_e _mode) {
+bool sacd_disc_t::probe(sacd_media_t* _sacd_media) {
 	sacd_media = _sacd_media;
-	mode = _mode;
-	sb_handle.master_data = nullptr;
-	sb_handle.area_count = 0;
-	sb_handle.twoch_area_idx = -1;
-	sb_handle.mulch_area_idx = -1;
-	sb_handle.area[0].area_data = nullptr;
-	sb_handle.area[1].area_data = nullptr;
 	char sacdmtoc[8];
 	sector_size = 0;
 	sector_bad_reads = 0;
+	read_buffer_sectors = 0;
 	if (!sacd_media->seek((uint64_t)START_OF_MASTER_TOC * (uint64_t)SACD_LSN_SIZE)) {
 		return false;
 	}
 	if (sacd_media->read(sacdmtoc, 8) == 8) {
 		if (memcmp(sacdmtoc, "SACDMTOC", 8) == 0) {
 			sector_size = SACD_LSN_SIZE;
-			buffer = sector_buffer;
 		}
 	}
 	if (!sacd_media->seek((uint64_t)START_OF_MASTER_TOC * (uint64_t)SACD_PSN_SIZE + 12)) {
@@ -316,13 +320,24 @@ bool sacd_disc_t::open(sacd_media_t* _sacd_media, open_mode_e _mode) {
 	if (sacd_media->read(sacdmtoc, 8) == 8) {
 		if (memcmp(sacdmtoc, "SACDMTOC", 8) == 0) {
 			sector_size = SACD_PSN_SIZE;
-			buffer = sector_buffer + 12;
 		}
 	}
 	if (!sacd_media->seek(0)) {
 		return false;
 	}
-	if (sector_size == 0) {
+	return sector_size != 0;
+}
+
+bool sacd_disc_t::open(sacd_media_t* _sacd_media, open_mode_e _mode) {
+	mode = _mode;
+	sb_toc = &sb_handle;
+	sb_handle.master_data = nullptr;
+	sb_handle.area_count = 0;
+	sb_handle.twoch_area_idx = -1;
+	sb_handle.mulch_area_idx = -1;
+	sb_handle.area[0].area_data = nullptr;
+	sb_handle.area[1].area_data = nullptr;
+	if (!probe(_sacd_media)) {
 		return false;
 	}
 	if (!read_master_toc()) {
@@ -370,7 +385,33 @@ bool sacd_disc_t::open(sacd_media_t* _sacd_media, open_mode_e _mode) {
 	return true;
 }
 
+// Attach to the TOC parsed by another (already opened) sacd_disc_t.
+// The TOC is shared read-only, all playback state stays private to
+// this instance, so several cursors may read the same disc concurrently
+// through their own sacd_media. The TOC owner must outlive the cursor.
+// sacd_media may be nullptr for cursors that only query track info.
+bool sacd_disc_t::open(sacd_media_t* _sacd_media, sacd_disc_t* toc_disc) {
+	close();
+	sacd_media = _sacd_media;
+	mode = toc_disc->mode;
+	sb_toc = toc_disc->get_handle();
+	sector_size = toc_disc->sector_size;
+	sector_bad_reads = 0;
+	read_buffer_sectors = 0;
+	frame_index = toc_disc->frame_index;
+	track_area = AREA_BOTH;
+	return sector_size != 0;
+}
+
 bool sacd_disc_t::close() {
+	if (sb_toc != &sb_handle) {
+		// cursor: the TOC belongs to another sacd_disc_t
+		sb_toc = &sb_handle;
+		read_buffer_sectors = 0;
+		frame_index = &frame_index_store;
+		return true;
+	}
+	frame_index_store.clear();
 	if (has_two_channel(&sb_handle)) {
 		free_area(&sb_handle.area[sb_handle.twoch_area_idx]);
 		if (sb_handle.area[sb_handle.twoch_area_idx].area_data) {
@@ -428,13 +469,29 @@ bool sacd_disc_t::select_track(uint32_t track_index, area_id_e area_id, uint32_t
 		memset(&audio_sector, 0, sizeof(audio_sector));
 		memset(&frame, 0, sizeof(frame));
 		packet_info_idx = 0;
-		sacd_media->seek((uint64_t)sel_track_current_lsn * (uint64_t)sector_size);
+		frame_starts_to_skip = 0;
 		return true;
 	}
 	return false;
 }
 
 bool sacd_disc_t::read_frame(uint8_t* frame_data, size_t* frame_size, frame_type_e* frame_type) {
+	return assemble_frame(frame_data, frame_size, frame_type, nullptr);
+}
+
+bool sacd_disc_t::read_frame_span(const uint8_t** frame_data, size_t* frame_size, frame_type_e* frame_type) {
+	uint8_t* data = get_frame_span(frame_size);
+	return assemble_frame(data, frame_size, frame_type, frame_data);
+}
+
+// Collect the audio packets of the next frame into frame_data. With
+// frame_span, a frame which lies contiguously in mapped media is not copied
+// at all: *frame_span then points into the media instead of frame_data.
+bool sacd_disc_t::assemble_frame(uint8_t* frame_data, size_t* frame_size, frame_type_e* frame_type, const uint8_t** frame_span) {
+	const uint8_t* in_place = nullptr;
+	if (frame_span) {
+		*frame_span = frame_data;
+	}
 	sector_bad_reads = 0;
 	while (sel_track_current_lsn < sel_track_start_lsn + sel_track_length_lsn) {
 		if (sector_bad_reads > 0) {
@@ -449,9 +506,9 @@ bool sacd_disc_t::read_frame(uint8_t* frame_data, size_t* frame_size, frame_type
 			// obtain the next sector data block
 			buffer_offset = 0;
 			packet_info_idx = 0;
-			size_t read_bytes = sacd_media->read(sector_buffer, sector_size);
+			bool sector_ok = read_sector(sel_track_current_lsn);
 			sel_track_current_lsn++;
-			if (read_bytes != sector_size) {
+			if (!sector_ok) {
 				sector_bad_reads++;
 				continue;
 			}
@@ -480,29 +537,45 @@ bool sacd_disc_t::read_frame(uint8_t* frame_data, size_t* frame_size, frame_type
 			case DATA_TYPE_AUDIO:
 				if (frame.started) {
 					if (packet->frame_start) {
-						if ((size_t)frame.size <= *frame_size) {
-							memcpy(frame_data, frame.data, frame.size);
-							*frame_size = frame.size;
-						}
-						else {
-							sector_bad_reads++;
-							continue;
-						}
+						*frame_size = frame.size;
 						*frame_type = sector_bad_reads > 0 ? FRAME_INVALID : frame.dst_encoded ? FRAME_DST : FRAME_DSD;
 						frame.started = false;
+						if (in_place) {
+							*frame_span = in_place;
+						}
 						return true;
 					}
 				}
 				else {
 					if (packet->frame_start) {
-						frame.size = 0;
-						frame.dst_encoded = audio_sector.header.dst_encoded;
-						frame.started = true;
+						if (frame_starts_to_skip > 0) {
+							// seek target is a later frame in this sector
+							frame_starts_to_skip--;
+						}
+						else {
+							frame.size = 0;
+							frame.dst_encoded = audio_sector.header.dst_encoded;
+							frame.started = true;
+						}
 					}
 				}
 				if (frame.started) {
 					if ((size_t)frame.size + packet->packet_length <= *frame_size && buffer_offset + packet->packet_length <= SACD_LSN_SIZE) {
-						memcpy(frame.data + frame.size, buffer + buffer_offset, packet->packet_length);
+						const uint8_t* packet_data = buffer + buffer_offset;
+						if (in_place && in_place + frame.size == packet_data) {
+							// the frame goes on in place
+						}
+						else if (frame.size == 0 && frame_span && buffer_mapped) {
+							in_place = packet_data;
+						}
+						else {
+							if (in_place) {
+								// the frame is split by a sector header, assemble it after all
+								memcpy(frame_data, in_place, frame.size);
+								in_place = nullptr;
+							}
+							memcpy(frame_data + frame.size, packet_data, packet->packet_length);
+						}
 						frame.size += packet->packet_length;
 					}
 					else {
@@ -522,19 +595,12 @@ bool sacd_disc_t::read_frame(uint8_t* frame_data, size_t* frame_size, frame_type
 		}
 	}
 	if (frame.started) {
-		if ((size_t)frame.size <= *frame_size) {
-			memcpy(frame_data, frame.data, frame.size);
-			*frame_size = frame.size;
-		}
-		else {
-			sector_bad_reads++;
-			buffer_offset = 0;
-			packet_info_idx = 0;
-			memset(&audio_sector, 0, sizeof(audio_sector));
-			memset(&frame, 0, sizeof(frame));
-		}
+		*frame_size = frame.size;
 		frame.started = false;
 		*frame_type = sector_bad_reads > 0 ? FRAME_INVALID : frame.dst_encoded ? FRAME_DST : FRAME_DSD;
+		if (in_place) {
+			*frame_span = in_place;
+		}
 		return true;
 	}
 	*frame_type = FRAME_INVALID;
@@ -542,6 +608,18 @@ bool sacd_disc_t::read_frame(uint8_t* frame_data, size_t* frame_size, frame_type
 }
 
 bool sacd_disc_t::seek(double seconds) {
+	if (is_dst_encoded) {
+		// DST frames have variable size, locate the frame through the sector headers
+		uint32_t frame_lsn;
+		uint32_t frame_skip;
+		if (locate_frame((uint32_t)(seconds * get_framerate()), &frame_lsn, &frame_skip)) {
+			if (!select_track(get_track_index(), get_track_area_id(), frame_lsn - sel_track_start_lsn)) {
+				return false;
+			}
+			frame_starts_to_skip = frame_skip;
+			return true;
+		}
+	}
 	uint64_t offset = (uint64_t)(get_size() * seconds / get_duration());
 	return select_track(get_track_index(), get_track_area_id(), (uint32_t)(offset / sector_size));
 }
@@ -555,16 +633,244 @@ bool sacd_disc_t::read_blocks_raw(uint32_t lb_start, uint32_t block_count, uint8
 			return false;
 		}
 		break;
-	case SACD_PSN_SIZE:
+	case SACD_PSN_SIZE: {
+		// read the whole run of raw sectors at once and strip the
+		// 12 byte header and 4 byte trailer of each one
+		std::vector<uint8_t> psn_data((size_t)block_count * SACD_PSN_SIZE);
+		sacd_media->seek((uint64_t)lb_start * (uint64_t)SACD_PSN_SIZE);
+		if (sacd_media->read(psn_data.data(), psn_data.size()) != psn_data.size()) {
+			sector_bad_reads++;
+			return false;
+		}
 		for (uint32_t i = 0; i < block_count; i++) {
-			sacd_media->seek((uint64_t)(lb_start + i) * (uint64_t)SACD_PSN_SIZE + 12);
-			if (sacd_media->read(data + i * SACD_LSN_SIZE, SACD_LSN_SIZE) != SACD_LSN_SIZE) {
-				sector_bad_reads++;
-				return false;
-			}
+			memcpy(data + i * SACD_LSN_SIZE, psn_data.data() + i * SACD_PSN_SIZE + 12, SACD_LSN_SIZE);
 		}
 		break;
 	}
+	}
+	return true;
+}
+
+bool sacd_frame_index_t::get(uint32_t track_start_lsn, uint32_t frame_nr, uint32_t* base, sacd_frame_mark_t* lo, sacd_frame_mark_t* hi) {
+	const std::scoped_lock<Mutex> lock(mutex);
+	auto i = tracks.find(track_start_lsn);
+	if (i == tracks.end()) {
+		return true;
+	}
+	const track_t& track = i->second;
+	if (track.failed) {
+		return false;
+	}
+	*base = track.base;
+	// the frame numbers of the marks grow with their lsn
+	for (const auto& [lsn, frame] : track.marks) {
+		if (frame <= frame_nr) {
+			if (lsn > lo->lsn) {
+				*lo = { lsn, frame };
+			}
+		}
+		else {
+			if (lsn < hi->lsn) {
+				*hi = { lsn, frame };
+			}
+			break;
+		}
+	}
+	return true;
+}
+
+void sacd_frame_index_t::put(uint32_t track_start_lsn, uint32_t base, sacd_frame_mark_t mark) {
+	const std::scoped_lock<Mutex> lock(mutex);
+	track_t& track = tracks[track_start_lsn];
+	track.base = base;
+	track.marks[mark.lsn] = mark.frame;
+}
+
+void sacd_frame_index_t::fail(uint32_t track_start_lsn) {
+	const std::scoped_lock<Mutex> lock(mutex);
+	track_t& track = tracks[track_start_lsn];
+	track.failed = true;
+	track.marks.clear();
+}
+
+void sacd_frame_index_t::clear() {
+	const std::scoped_lock<Mutex> lock(mutex);
+	tracks.clear();
+}
+
+// Read just the header of the audio sector at lsn, bypassing the read
+// buffer. Sets *frame_starts to the number of audio frames which start in
+// the sector and, if there are any, *timecode to the time code (in frames)
+// of the first one.
+bool sacd_disc_t::read_frame_starts(uint32_t lsn, uint32_t* frame_starts, uint32_t* timecode) {
+	uint8_t data[SACD_PSN_SIZE];
+	const uint8_t* sector = sacd_media->get_data((int64_t)lsn * (int64_t)sector_size, sector_size);
+	if (!sector) {
+		if (!sacd_media->seek((uint64_t)lsn * (uint64_t)sector_size)) {
+			return false;
+		}
+		if (sacd_media->read(data, sector_size) != sector_size) {
+			return false;
+		}
+		sector = data;
+	}
+	if (sector_size == SACD_PSN_SIZE) {
+		sector += 12;
+	}
+	audio_frame_header_t header;
+	memcpy(&header, sector, AUDIO_SECTOR_HEADER_SIZE);
+	*frame_starts = 0;
+	for (uint8_t i = 0; i < header.packet_info_count; i++) {
+		const uint8_t* packet_info = sector + AUDIO_SECTOR_HEADER_SIZE + i * AUDIO_PACKET_INFO_SIZE;
+		bool frame_start = (packet_info[0] >> 7) & 1;
+		int data_type = (packet_info[0] >> 3) & 7;
+		if (frame_start && data_type == DATA_TYPE_AUDIO) {
+			(*frame_starts)++;
+		}
+	}
+	if (*frame_starts > 0) {
+		if (header.frame_info_count == 0) {
+			return false;
+		}
+		const uint8_t* frame_info = sector + AUDIO_SECTOR_HEADER_SIZE + header.packet_info_count * AUDIO_PACKET_INFO_SIZE;
+		*timecode = ((uint32_t)frame_info[0] * 60 + frame_info[1]) * SACD_FRAMES_PER_SECOND + frame_info[2];
+	}
+	return true;
+}
+
+// Advance *lsn to the first sector before end_lsn in which audio frames
+// start. Frames span at most a few dozen sectors, so give up (and return
+// false) after that many.
+bool sacd_disc_t::find_frame_starts(uint32_t* lsn, uint32_t end_lsn, uint32_t* frame_starts, uint32_t* timecode) {
+	for (uint32_t n = 0; *lsn < end_lsn && n < MAX_SECTORS_PER_FRAME; (*lsn)++, n++) {
+		if (!read_frame_starts(*lsn, frame_starts, timecode)) {
+			return false;
+		}
+		if (*frame_starts > 0) {
+			return true;
+		}
+	}
+	*frame_starts = 0;
+	return *lsn == end_lsn;
+}
+
+// Locate the sector in which frame frame_nr of the selected DST track
+// starts, and the number of earlier frame starts in that sector. Probes
+// single sector headers by interpolation between the closest known
+// positions, so a seek reads only a handful of sectors. Returns false
+// (and the caller falls back to a linear estimate) if the frame cannot be
+// located; a track with inconsistent time codes is not tried again.
+bool sacd_disc_t::locate_frame(uint32_t frame_nr, uint32_t* frame_lsn, uint32_t* frame_skip) {
+	const uint32_t track_end_lsn = sel_track_start_lsn + sel_track_length_lsn;
+	uint32_t base = UINT32_MAX;
+	sacd_frame_mark_t lo = { sel_track_start_lsn, 0 };
+	sacd_frame_mark_t hi = { track_end_lsn, (uint32_t)(get_duration() * get_framerate()) + 1 };
+	if (!frame_index->get(sel_track_start_lsn, frame_nr, &base, &lo, &hi)) {
+		return false;
+	}
+	// no frames start between hi and the end of the track
+	bool hi_is_end = hi.lsn == track_end_lsn;
+	uint32_t lsn;
+	uint32_t frame_starts;
+	uint32_t timecode;
+	if (base == UINT32_MAX) {
+		lsn = sel_track_start_lsn;
+		if (!find_frame_starts(&lsn, track_end_lsn, &frame_starts, &timecode) || frame_starts == 0) {
+			frame_index->fail(sel_track_start_lsn);
+			return false;
+		}
+		base = timecode;
+		frame_index->put(sel_track_start_lsn, base, { lsn, 0 });
+	}
+	for (uint32_t probes = 0; lo.lsn < hi.lsn; probes++) {
+		// interpolate, and bisect if that does not converge quickly
+		uint32_t guess = lo.lsn + (hi.lsn - lo.lsn) / 2;
+		if (probes < 8 && hi.frame > frame_nr) {
+			guess = lo.lsn + (uint32_t)((uint64_t)(frame_nr - lo.frame) * (hi.lsn - lo.lsn) / (hi.frame - lo.frame));
+		}
+		lsn = guess;
+		if (!find_frame_starts(&lsn, hi.lsn, &frame_starts, &timecode)) {
+			break;
+		}
+		if (frame_starts == 0) {
+			// no frame starts between guess and hi
+			hi.lsn = guess;
+			continue;
+		}
+		if (timecode < base + lo.frame) {
+			break;
+		}
+		uint32_t first_frame = timecode - base;
+		if (frame_nr < first_frame) {
+			if (guess == lo.lsn) {
+				break;
+			}
+			hi = { guess, first_frame };
+			hi_is_end = false;
+		}
+		else if (frame_nr < first_frame + frame_starts) {
+			frame_index->put(sel_track_start_lsn, base, { lsn, first_frame });
+			*frame_lsn = lsn;
+			*frame_skip = frame_nr - first_frame;
+			return true;
+		}
+		else {
+			lo = { lsn + 1, first_frame + frame_starts };
+		}
+		frame_index->put(sel_track_start_lsn, base, { guess, first_frame });
+		frame_index->put(sel_track_start_lsn, base, { lsn + 1, first_frame + frame_starts });
+	}
+	if (lo.lsn < hi.lsn || !hi_is_end) {
+		// only a target beyond the last frame is not an error
+		frame_index->fail(sel_track_start_lsn);
+	}
+	return false;
+}
+
+void sacd_disc_t::set_read_ahead(size_t size) {
+	read_ahead_size = size;
+	read_buffer_sectors = 0;
+}
+
+// Make the sector at lsn current (buffer points to its user data).
+// Sectors are read in runs of up to read_ahead_size bytes, bounded by
+// the end of the selected track, and served from read_buffer until the
+// stream leaves the cached run. Media which can map the image skip the
+// buffer altogether. Returns false on a short read.
+bool sacd_disc_t::read_sector(uint32_t lsn) {
+	const uint8_t* span = sacd_media->get_data((int64_t)lsn * (int64_t)sector_size, sector_size);
+	if (span) {
+		// memory mapped media: use the sector in place
+		buffer = sector_size == SACD_PSN_SIZE ? span + 12 : span;
+		buffer_mapped = true;
+		return true;
+	}
+	if (!(lsn >= read_buffer_lsn && lsn < read_buffer_lsn + read_buffer_sectors)) {
+		uint32_t track_end_lsn = sel_track_start_lsn + sel_track_length_lsn;
+		uint32_t sectors = std::max<uint32_t>(1, read_ahead_size / sector_size);
+		if (lsn < track_end_lsn) {
+			sectors = std::min(sectors, track_end_lsn - lsn);
+		}
+		read_buffer.resize((size_t)sectors * sector_size);
+		read_buffer_lsn = lsn;
+		read_buffer_sectors = 0;
+		if (!sacd_media->seek((uint64_t)lsn * (uint64_t)sector_size)) {
+			return false;
+		}
+		size_t read_bytes = sacd_media->read(read_buffer.data(), read_buffer.size());
+		if (read_bytes == (size_t)-1) {
+			return false;
+		}
+		read_buffer_sectors = read_bytes / sector_size;
+		if (read_buffer_sectors == 0) {
+			return false;
+		}
+	}
+	buffer = read_buffer.data() + (size_t)(lsn - read_buffer_lsn) * sector_size;
+	buffer_mapped = false;
+	if (sector_size == SACD_PSN_SIZE) {
+		buffer += 12;
+	}
 	return true;
 }
 
@@ -25,6 +25,10 @@
 #include "config.h"
 
 #include <cstdint>
+#include <map>
+#include <vector>
+
+#include "thread/Mutex.hxx"
 
 #include "endianess.h"
 #include "scarletbook.h"
@@ -33,21 +37,52 @@
 #define CP_ACP 0
 
 #define SACD_PSN_SIZE 2064
-#define MAX_DATA_SIZE (1024 * 64)
+#define SACD_READ_AHEAD_SIZE (1024 * 1024)
+#define SACD_FRAMES_PER_SECOND 75
+#define MAX_SECTORS_PER_FRAME 32
 
 typedef struct {
-	uint8_t data[MAX_DATA_SIZE];
 	int     size;
 	bool    started;
 	int     sector_count;
 	int     dst_encoded;
 } audio_frame_t;
 
+// A known position in a DST track: the first audio frame which starts at
+// or after sector lsn is frame number frame, counted from the track start.
+typedef struct {
+	uint32_t lsn;
+	uint32_t frame;
+} sacd_frame_mark_t;
+
+// Frame positions of the DST tracks of a disc, keyed by the track start
+// LSN. The positions are located on demand from the time codes in the
+// audio sector headers, and remembered to narrow down later seeks. Shared
+// by all cursors of a disc.
+class sacd_frame_index_t {
+	struct track_t {
+		bool     failed = false;
+		uint32_t base = 0; // time code of the first frame of the track
+		std::map<uint32_t, uint32_t> marks; // lsn -> frame, see sacd_frame_mark_t
+	};
+	Mutex mutex;
+	std::map<uint32_t, track_t> tracks;
+public:
+	// Narrow lo/hi down to the known positions closest to frame_nr and set
+	// *base if it is known. Returns false if locating frames in this track
+	// failed before.
+	bool get(uint32_t track_start_lsn, uint32_t frame_nr, uint32_t* base, sacd_frame_mark_t* lo, sacd_frame_mark_t* hi);
+	void put(uint32_t track_start_lsn, uint32_t base, sacd_frame_mark_t mark);
+	void fail(uint32_t track_start_lsn);
+	void clear();
+};
+
 class sacd_disc_t : public sacd_reader_t {
 private:
 	sacd_media_t*        sacd_media;
 	open_mode_e          mode;
 	scarletbook_handle_t sb_handle;
+	scarletbook_handle_t* sb_toc;
 	area_id_e            track_area;
 	uint32_t             sel_track_index;
 	uint32_t             sel_track_start_lsn;
@@ -59,10 +94,17 @@ private:
 	audio_sector_t       audio_sector;
 	audio_frame_t        frame;
 	int                  packet_info_idx;
-	uint8_t              sector_buffer[SACD_PSN_SIZE];
+	int                  frame_starts_to_skip;
+	sacd_frame_index_t   frame_index_store;
+	sacd_frame_index_t*  frame_index;
+	std::vector<uint8_t> read_buffer;
+	uint32_t             read_buffer_lsn;
+	uint32_t             read_buffer_sectors;
+	size_t               read_ahead_size;
 	uint32_t             sector_size;
 	int                  sector_bad_reads;
-	uint8_t*             buffer;
+	const uint8_t*       buffer;
+	bool                 buffer_mapped; // buffer points into mapped media, valid until close()
 	int                  buffer_offset;
 public:
 	sacd_disc_t();
@@ -85,13 +127,24 @@ public:
 	bool is_dst() override;
 	void set_emaster(bool emaster) override;
 	bool open(sacd_media_t* sacd_media, open_mode_e mode = MODE_MULTI_TRACK) override;
+	bool open(sacd_media_t* sacd_media, sacd_disc_t* toc_disc);
+	// Only detect the sector layout, so that raw blocks (e.g. the master TOC)
+	// can be read without parsing the TOCs
+	bool probe(sacd_media_t* sacd_media);
 	bool close() override;
 	void select_area(area_id_e area_id) override;
 	bool select_track(uint32_t track_index, area_id_e area_id = AREA_BOTH, uint32_t offset = 0) override;
 	bool read_frame(uint8_t* frame_data, size_t* frame_size, frame_type_e* frame_type) override;
+	bool read_frame_span(const uint8_t** frame_data, size_t* frame_size, frame_type_e* frame_type) override;
 	bool seek(double seconds) override;
 	bool read_blocks_raw(uint32_t lb_start, uint32_t block_count, uint8_t* data);
+	void set_read_ahead(size_t size);
 private:
+	bool read_sector(uint32_t lsn);
+	bool assemble_frame(uint8_t* frame_data, size_t* frame_size, frame_type_e* frame_type, const uint8_t** frame_span);
+	bool read_frame_starts(uint32_t lsn, uint32_t* frame_starts, uint32_t* timecode);
+	bool find_frame_starts(uint32_t* lsn, uint32_t end_lsn, uint32_t* frame_starts, uint32_t* timecode);
+	bool locate_frame(uint32_t frame_nr, uint32_t* frame_lsn, uint32_t* frame_skip);
 	scarletbook_handle_t* get_handle();
 	bool read_master_toc();
 	bool read_area_toc(int area_idx);
@@ -18,8 +18,10 @@
 */
 
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <string.h>
 
 #include "sacd_media.h"
 
@@ -49,6 +51,10 @@ bool sacd_media_file_t::open(const char* path) {
 		fd = -1;
 		return false;
 	}
+#ifdef POSIX_FADV_SEQUENTIAL
+	// audio is read in long sequential runs, let the kernel read ahead
+	::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 	return true;
 }
 
@@ -91,6 +97,94 @@ int64_t sacd_media_file_t::skip(int64_t bytes) {
 	return ::lseek(fd, (off_t)bytes, SEEK_CUR);
 }
 
+sacd_media_mmap_t::sacd_media_mmap_t() {
+	data = nullptr;
+	size = 0;
+	position = 0;
+}
+
+sacd_media_mmap_t::~sacd_media_mmap_t() {
+	sacd_media_mmap_t::close();
+}
+
+bool sacd_media_mmap_t::open(const char* path) {
+	struct stat st;
+	int fd = ::open(path, O_RDONLY, 0);
+	if (fd < 0) {
+		return false;
+	}
+	if (::fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+		::close(fd);
+		return false;
+	}
+	void* map = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED) {
+		return false;
+	}
+#ifdef MADV_SEQUENTIAL
+	::madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+	data = (uint8_t*)map;
+	size = st.st_size;
+	position = 0;
+	return true;
+}
+
+bool sacd_media_mmap_t::close() {
+	if (!data) {
+		return false;
+	}
+	::munmap(data, (size_t)size);
+	data = nullptr;
+	size = 0;
+	position = 0;
+	return true;
+}
+
+bool sacd_media_mmap_t::seek(int64_t _position) {
+	if (_position < 0) {
+		return false;
+	}
+	position = _position;
+	return true;
+}
+
+int64_t sacd_media_mmap_t::get_position() {
+	return position;
+}
+
+int64_t sacd_media_mmap_t::get_size() {
+	return size;
+}
+
+size_t sacd_media_mmap_t::read(void* _data, size_t _size) {
+	if (position >= size) {
+		return 0;
+	}
+	if ((int64_t)_size > size - position) {
+		_size = (size_t)(size - position);
+	}
+	memcpy(_data, data + position, _size);
+	position += _size;
+	return _size;
+}
+
+int64_t sacd_media_mmap_t::skip(int64_t bytes) {
+	if (position + bytes < 0) {
+		return -1;
+	}
+	position += bytes;
+	return position;
+}
+
+const uint8_t* sacd_media_mmap_t::get_data(int64_t _position, size_t _size) {
+	if (_position < 0 || _position + (int64_t)_size > size) {
+		return nullptr;
+	}
+	return data + _position;
+}
+
 sacd_media_stream_t::sacd_media_stream_t() {
 	is = nullptr;
 }
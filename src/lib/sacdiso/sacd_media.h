@@ -39,6 +39,13 @@ public:
 	virtual int64_t get_size() = 0;
 	virtual size_t  read(void* data, size_t size) = 0;
 	virtual int64_t skip(int64_t bytes) = 0;
+	// Zero-copy access to size bytes at position, nullptr if the media
+	// cannot provide it (the caller falls back to seek() and read()).
+	virtual const uint8_t* get_data(int64_t position, size_t size) {
+		(void)position;
+		(void)size;
+		return nullptr;
+	}
 };
 
 class sacd_media_file_t : public sacd_media_t {
@@ -55,6 +62,23 @@ public:
 	int64_t skip(int64_t bytes) override;
 };
 
+class sacd_media_mmap_t : public sacd_media_t {
+	uint8_t* data;
+	int64_t  size;
+	int64_t  position;
+public:
+	sacd_media_mmap_t();
+	virtual ~sacd_media_mmap_t() override;
+	bool    open(const char* path) override;
+	bool    close() override;
+	bool    seek(int64_t position) override;
+	int64_t get_position() override;
+	int64_t get_size() override;
+	size_t  read(void* data, size_t size) override;
+	int64_t skip(int64_t bytes) override;
+	const uint8_t* get_data(int64_t position, size_t size) override;
+};
+
 class sacd_media_stream_t : public sacd_media_t {
 	Mutex mutex;
 	InputStreamPtr is;
@@ -116,6 +116,10 @@ sacd_metabase_t::sacd_metabase_t(sacd_disc_t* sacd_disc, const char* tags_path,
 	initialized = init_xmldoc();
 }
 
+std::string sacd_metabase_t::get_store_id(sacd_disc_t* sacd_disc) {
+	return get_md5(sacd_disc);
+}
+
 sacd_metabase_t::~sacd_metabase_t() {
 	if (xmldoc) {
 		ixmlDocument_free(xmldoc);
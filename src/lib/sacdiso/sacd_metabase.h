@@ -55,6 +55,7 @@ class sacd_metabase_t {
 public:
 	sacd_metabase_t(sacd_disc_t* sacd_disc, const char* tags_path = nullptr, const char* tags_file = nullptr);
 	~sacd_metabase_t();
+	static std::string get_store_id(sacd_disc_t* sacd_disc);
 	bool get_track_info(unsigned track_number, TagHandler& handler);
 	bool get_albumart(TagHandler& handler);
 private:
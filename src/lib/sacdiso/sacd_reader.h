@@ -20,6 +20,10 @@
 #ifndef _SACD_READER_H_INCLUDED
 #define _SACD_READER_H_INCLUDED
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include "tag/Handler.hxx"
 #include "sacd_media.h"
 
@@ -28,6 +32,16 @@ enum frame_type_e {FRAME_DSD = 0, FRAME_DST = 1, FRAME_INVALID = -1};
 enum open_mode_e {MODE_MULTI_TRACK = 0, MODE_SINGLE_TRACK = 1, MODE_FULL_PLAYBACK = 2};
 
 class sacd_reader_t {
+protected:
+	// Frames returned by read_frame_span(), the oldest is reused next
+	std::vector<std::vector<uint8_t>> frame_spans;
+	size_t frame_span_next = 0;
+	uint8_t* get_frame_span(size_t* frame_size) {
+		auto& span = frame_spans[frame_span_next];
+		frame_span_next = (frame_span_next + 1) % frame_spans.size();
+		*frame_size = span.size();
+		return span.data();
+	}
 public:
 	sacd_reader_t() {}
 	virtual ~sacd_reader_t() {}
@@ -49,6 +63,21 @@ public:
 	virtual void select_area(area_id_e area_id) = 0;
 	virtual	bool select_track(uint32_t track_index, area_id_e area_id = AREA_BOTH, uint32_t offset = 0) = 0;
 	virtual bool read_frame(uint8_t* frame_data, size_t* frame_size, frame_type_e* frame_type) = 0;
+	// Keep the last count frames returned by read_frame_span() valid, each of
+	// up to frame_size bytes.
+	void set_frame_spans(size_t count, size_t frame_size) {
+		frame_spans.assign(count > 0 ? count : 1, std::vector<uint8_t>(frame_size));
+		frame_span_next = 0;
+	}
+	// Like read_frame(), but the frame is left in memory owned by the reader
+	// (or by the media, if it can be used in place), so that it can be passed
+	// on (e.g. to the DST decoder threads) without another copy. The last
+	// count frames (see set_frame_spans()) stay valid.
+	virtual bool read_frame_span(const uint8_t** frame_data, size_t* frame_size, frame_type_e* frame_type) {
+		uint8_t* data = get_frame_span(frame_size);
+		*frame_data = data;
+		return read_frame(data, frame_size, frame_type);
+	}
 	virtual bool seek(double seconds) = 0;
 };
 
@@ -283,7 +283,7 @@ MultipleOutputs::CheckPipe() noexcept
 			   provides a defined value */
 			elapsed_time = chunk->time;
 
-		const bool is_tail = chunk->next == nullptr;
+		const bool is_tail = chunk->GetNext() == nullptr;
 		if (is_tail)
 			/* this is the tail of the pipe - clear the
 			   chunk reference in all outputs */
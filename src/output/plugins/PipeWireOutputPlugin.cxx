@@ -678,19 +678,6 @@ Interleave(std::byte *data, std::byte *end,
 	}
 }
 
-static void
-BitReverse(uint8_t *data, std::size_t n) noexcept
-{
-	while (n-- > 0)
-		*data = bit_reverse(*data);
-}
-
-static void
-BitReverse(std::byte *data, std::size_t n) noexcept
-{
-	BitReverse((uint8_t *)data, n);
-}
-
 static void
 PostProcessDsd(std::byte *data, struct spa_chunk &chunk, unsigned channels,
 	       bool reverse_bits, unsigned interleave) noexcept
@@ -705,7 +692,7 @@ PostProcessDsd(std::byte *data, struct spa_chunk &chunk, unsigned channels,
 	}
 
 	if (reverse_bits)
-		BitReverse(data, chunk.size);
+		BitReverse((uint8_t *)data, chunk.size);
 }
 
 #endif
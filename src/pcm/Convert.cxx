@@ -19,15 +19,41 @@
 
 #include "Convert.hxx"
 #include "ConfiguredResampler.hxx"
+#include "config/Data.hxx"
+#include "config/Option.hxx"
 #include "util/ConstBuffer.hxx"
 
 #include <cassert>
 #include <stdexcept>
 
+#ifdef ENABLE_DSD
+static bool dsd_decimation = false;
+
+/**
+ * Determine the largest power-of-two factor by which DSD converted
+ * to PCM at @src_rate can be decimated without dropping below
+ * @dest_rate.
+ */
+static unsigned
+GetDsdDecimationFactor(unsigned src_rate, unsigned dest_rate) noexcept
+{
+	unsigned factor = 1;
+	while (factor < PcmDsdDecimator::MAX_FACTOR &&
+	       src_rate % (factor * 2) == 0 &&
+	       src_rate / (factor * 2) >= dest_rate)
+		factor *= 2;
+	return factor;
+}
+#endif
+
 void
 pcm_convert_global_init(const ConfigData &config)
 {
 	pcm_resampler_global_init(config);
+
+#ifdef ENABLE_DSD
+	dsd_decimation = config.GetBool(ConfigOption::DSD_DECIMATION, false);
+#endif
 }
 
 PcmConvert::PcmConvert(const AudioFormat _src_format,
@@ -40,10 +66,24 @@ PcmConvert::PcmConvert(const AudioFormat _src_format,
 	AudioFormat format = _src_format;
 	if (format.format == SampleFormat::DSD) {
 #ifdef ENABLE_DSD
-		dsd2pcm_float = dest_format.format == SampleFormat::FLOAT;
+		const unsigned factor = dsd_decimation
+			? GetDsdDecimationFactor(format.sample_rate,
+						 dest_format.sample_rate)
+			: 1;
+
+		/* the decimator works on floating point samples; the
+		   format converter below takes care of the rest */
+		enable_dsd_decimator = factor > 1;
+		dsd2pcm_float = enable_dsd_decimator ||
+			dest_format.format == SampleFormat::FLOAT;
 		format.format = dsd2pcm_float
 			? SampleFormat::FLOAT
 			: SampleFormat::S24_P32;
+
+		if (enable_dsd_decimator) {
+			dsd_decimator.Open(format.channels, factor);
+			format.sample_rate /= factor;
+		}
 #else
 		throw std::runtime_error("DSD support is disabled");
 #endif
@@ -108,6 +148,8 @@ PcmConvert::Reset() noexcept
 
 #ifdef ENABLE_DSD
 	dsd.Reset();
+	if (enable_dsd_decimator)
+		dsd_decimator.Reset();
 #endif
 }
 
@@ -123,6 +165,9 @@ PcmConvert::Convert(ConstBuffer<void> buffer)
 		if (d.IsNull())
 			throw std::runtime_error("DSD to PCM conversion failed");
 
+		if (enable_dsd_decimator)
+			d = dsd_decimator.Convert(ConstBuffer<float>::FromVoid(d)).ToVoid();
+
 		buffer = d;
 	}
 #endif
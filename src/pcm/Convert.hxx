@@ -28,6 +28,7 @@
 
 #ifdef ENABLE_DSD
 #include "PcmDsd.hxx"
+#include "DsdDecimator.hxx"
 #endif
 
 template<typename T> struct ConstBuffer;
@@ -41,6 +42,7 @@ struct ConfigData;
 class PcmConvert {
 #ifdef ENABLE_DSD
 	PcmDsd dsd;
+	PcmDsdDecimator dsd_decimator;
 #endif
 
 	GluePcmResampler resampler;
@@ -52,7 +54,7 @@ class PcmConvert {
 	bool enable_resampler, enable_format, enable_channels;
 
 #ifdef ENABLE_DSD
-	bool dsd2pcm_float;
+	bool dsd2pcm_float, enable_dsd_decimator = false;
 #endif
 
 public:
@@ -21,6 +21,7 @@
 #define MPD_PCM_DOP_HXX
 
 #include "Buffer.hxx"
+#include "DsdPack.hxx"
 #include "RestBuffer.hxx"
 
 #include <cstdint>
@@ -33,14 +34,18 @@ template<typename T> struct ConstBuffer;
  * http://dsd-guide.com/dop-open-standard
  */
 class DsdToDopConverter {
-	unsigned channels;
-
 	PcmBuffer buffer;
 
+	DsdPack pack;
+
 	PcmRestBuffer<uint8_t, 4> rest_buffer;
 
 public:
-	void Open(unsigned _channels) noexcept;
+	/**
+	 * @param options the layout of the 24 bit samples; by
+	 * default, they are padded to 32 bit (native endian)
+	 */
+	void Open(unsigned channels, DsdPack::Options options={}) noexcept;
 
 	void Reset() noexcept {
 		rest_buffer.Reset();
@@ -57,10 +62,14 @@ public:
 	 * @return the size of one output block in bytes
 	 */
 	size_t GetOutputBlockSize() const noexcept {
-		return 2 * GetInputBlockSize();
+		return pack.GetOutputBlockSize();
 	}
 
-	ConstBuffer<uint32_t> Convert(ConstBuffer<uint8_t> src) noexcept;
+	/**
+	 * @return the DoP samples; with DsdPack::Options::pack24,
+	 * these are 3 bytes each, otherwise 4
+	 */
+	ConstBuffer<void> Convert(ConstBuffer<uint8_t> src) noexcept;
 };
 
 #endif
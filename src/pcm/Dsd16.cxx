@@ -20,42 +20,12 @@
 #include "Dsd16.hxx"
 #include "util/ConstBuffer.hxx"
 
-#include <functional>
-
-/**
- * Construct a 16 bit integer from two bytes.
- */
-static constexpr uint16_t
-Construct16(uint8_t a, uint8_t b) noexcept
-{
-	/* "a" is the oldest byte, which must be in the most
-	   significant byte */
-
-	return uint16_t(b) | (uint16_t(a) << 8);
-}
-
-static constexpr uint16_t
-Dsd8To16Sample(const uint8_t *src, unsigned channels) noexcept
-{
-	return Construct16(src[0], src[channels]);
-}
-
-static void
-Dsd8To16(uint16_t *dest, const uint8_t *src,
-	 size_t out_frames, unsigned channels) noexcept
-{
-	for (size_t i = 0; i < out_frames; ++i) {
-		for (size_t c = 0; c < channels; ++c)
-			*dest++ = Dsd8To16Sample(src++, channels);
-
-		src += channels;
-	}
-}
-
 void
-Dsd16Converter::Open(unsigned _channels) noexcept
+Dsd16Converter::Open(unsigned channels, bool reverse_endian) noexcept
 {
-	channels = _channels;
+	DsdPack::Options options;
+	options.reverse_endian = reverse_endian;
+	pack.Open(DsdPack::Format::U16, channels, options);
 
 	rest_buffer.Open(channels);
 }
@@ -63,6 +33,9 @@ Dsd16Converter::Open(unsigned _channels) noexcept
 ConstBuffer<uint16_t>
 Dsd16Converter::Convert(ConstBuffer<uint8_t> src) noexcept
 {
-	return rest_buffer.Process<uint16_t>(buffer, src, channels,
-					     [=](auto && arg1, auto && arg2, auto && arg3) { return Dsd8To16(arg1, arg2, arg3, channels); });
+	return rest_buffer.Process<uint16_t>(buffer, src,
+					     rest_buffer.GetChannelCount(),
+					     [this](uint16_t *dest, const uint8_t *s, size_t n_blocks) {
+						     pack.Pack((uint8_t *)dest, s, n_blocks);
+					     });
 }
@@ -21,6 +21,7 @@
 #define MPD_PCM_DSD_16_HXX
 
 #include "Buffer.hxx"
+#include "DsdPack.hxx"
 #include "RestBuffer.hxx"
 
 #include <cstdint>
@@ -31,14 +32,18 @@ template<typename T> struct ConstBuffer;
  * Convert DSD_U8 to DSD_U16 (native endian, oldest bits in MSB).
  */
 class Dsd16Converter {
-	unsigned channels;
-
 	PcmBuffer buffer;
 
+	DsdPack pack;
+
 	PcmRestBuffer<uint8_t, 2> rest_buffer;
 
 public:
-	void Open(unsigned _channels) noexcept;
+	/**
+	 * @param reverse_endian store the samples in reverse
+	 * (i.e. big endian on little endian machines) byte order?
+	 */
+	void Open(unsigned channels, bool reverse_endian=false) noexcept;
 
 	void Reset() noexcept {
 		rest_buffer.Reset();
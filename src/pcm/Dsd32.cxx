@@ -20,44 +20,12 @@
 #include "Dsd32.hxx"
 #include "util/ConstBuffer.hxx"
 
-#include <functional>
-
-/**
- * Construct a 32 bit integer from four bytes.
- */
-static constexpr uint32_t
-Construct32(uint8_t a, uint8_t b, uint8_t c, uint8_t d) noexcept
-{
-	/* "a" is the oldest byte, which must be in the most
-	   significant byte */
-
-	return uint32_t(d) | (uint32_t(c) << 8) |
-		(uint32_t(b) << 16) | (uint32_t(a) << 24);
-}
-
-static constexpr uint32_t
-Dsd8To32Sample(const uint8_t *src, unsigned channels) noexcept
-{
-	return Construct32(src[0], src[channels],
-			   src[2 * channels], src[3 * channels]);
-}
-
-static void
-Dsd8To32(uint32_t *dest, const uint8_t *src,
-	 size_t out_frames, unsigned channels) noexcept
-{
-	for (size_t i = 0; i < out_frames; ++i) {
-		for (size_t c = 0; c < channels; ++c)
-			*dest++ = Dsd8To32Sample(src++, channels);
-
-		src += 3 * channels;
-	}
-}
-
 void
-Dsd32Converter::Open(unsigned _channels) noexcept
+Dsd32Converter::Open(unsigned channels, bool reverse_endian) noexcept
 {
-	channels = _channels;
+	DsdPack::Options options;
+	options.reverse_endian = reverse_endian;
+	pack.Open(DsdPack::Format::U32, channels, options);
 
 	rest_buffer.Open(channels);
 }
@@ -65,6 +33,9 @@ Dsd32Converter::Open(unsigned _channels) noexcept
 ConstBuffer<uint32_t>
 Dsd32Converter::Convert(ConstBuffer<uint8_t> src) noexcept
 {
-	return rest_buffer.Process<uint32_t>(buffer, src, channels,
-					     [=](auto && arg1, auto && arg2, auto && arg3) { return Dsd8To32(arg1, arg2, arg3, channels); });
+	return rest_buffer.Process<uint32_t>(buffer, src,
+					     rest_buffer.GetChannelCount(),
+					     [this](uint32_t *dest, const uint8_t *s, size_t n_blocks) {
+						     pack.Pack((uint8_t *)dest, s, n_blocks);
+					     });
 }
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "DsdDecimator.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+/**
+ * Outputs are computed in blocks of this size, which lets the
+ * compiler vectorize the kernel without a scalar tail.
+ */
+static constexpr unsigned BLOCK = 8;
+
+static constexpr double KAISER_BETA = 9.0;
+
+static constexpr double PI = 3.14159265358979323846;
+
+/**
+ * Modified Bessel function of the first kind, order zero.
+ */
+static double
+BesselI0(double x) noexcept
+{
+	double sum = 1, term = 1;
+	for (unsigned k = 1; k < 64 && term > sum * 1e-17; ++k) {
+		const double t = x / (2 * k);
+		term *= t * t;
+		sum += term;
+	}
+
+	return sum;
+}
+
+/**
+ * A Kaiser windowed half-band filter with 4*L-1 taps.  Every second
+ * tap is zero, except for the center tap which is 0.5; only the L
+ * odd-indexed coefficients next to the center are stored.
+ */
+template<unsigned L>
+struct HalfBandFilter {
+	static constexpr unsigned LENGTH = L;
+	static constexpr unsigned TAPS = 4 * L - 1;
+	static constexpr unsigned HISTORY = TAPS - 1;
+
+	std::array<float, L> c;
+
+	HalfBandFilter() noexcept {
+		constexpr double center = 2 * L - 1;
+		const double i0_beta = BesselI0(KAISER_BETA);
+
+		std::array<double, L> raw;
+		double sum = 0;
+		for (unsigned i = 0; i < L; ++i) {
+			const double k = 2 * i + 1;
+			const double r = k / center;
+			const double window =
+				BesselI0(KAISER_BETA * std::sqrt(1 - r * r)) / i0_beta;
+			const double sinc = (i % 2 == 0 ? 1 : -1) / (PI * k);
+			raw[i] = sinc * window;
+			sum += raw[i];
+		}
+
+		/* normalize to unity gain at DC: the center tap is
+		   0.5; the remaining 0.5 is shared by both sides */
+		for (unsigned i = 0; i < L; ++i)
+			c[i] = float(raw[i] * (0.25 / sum));
+	}
+
+	static const HalfBandFilter &Get() noexcept {
+		static const HalfBandFilter filter;
+		return filter;
+	}
+
+	/**
+	 * Compute @n outputs (a multiple of #BLOCK) from the even
+	 * and odd polyphase components of the input.
+	 */
+	void Run(float *__restrict dest, const float *__restrict even,
+		 const float *__restrict odd, size_t n) const noexcept {
+		assert(n % BLOCK == 0);
+
+		for (size_t j = 0; j < n; j += BLOCK) {
+			float acc[BLOCK];
+			for (unsigned k = 0; k < BLOCK; ++k)
+				acc[k] = 0.5f * odd[j + k + L - 1];
+
+			for (unsigned i = 0; i < L; ++i) {
+				const float *a = even + j + L - 1 - i;
+				const float *b = even + j + L + i;
+				for (unsigned k = 0; k < BLOCK; ++k)
+					acc[k] += c[i] * (a[k] + b[k]);
+			}
+
+			std::copy_n(acc, BLOCK, dest + j);
+		}
+	}
+};
+
+/**
+ * The last stage determines the pass band and needs a steep
+ * transition; it passes up to about 0.2 of its input rate.
+ */
+using FinalFilter = HalfBandFilter<16>;
+
+/**
+ * The earlier stages only need to keep aliases out of the final
+ * stage's pass band, which leaves them a wide transition band.
+ */
+using EarlyFilter = HalfBandFilter<6>;
+
+void
+PcmDsdDecimator::Open(unsigned _channels, unsigned factor) noexcept
+{
+	assert(_channels > 0);
+	assert(_channels <= MAX_CHANNELS);
+	assert(factor >= 2);
+	assert(factor <= MAX_FACTOR);
+	assert((factor & (factor - 1)) == 0);
+
+	channels = _channels;
+
+	n_stages = 0;
+	while ((1u << n_stages) < factor)
+		++n_stages;
+
+	Reset();
+}
+
+void
+PcmDsdDecimator::Reset() noexcept
+{
+	for (unsigned s = 0; s < n_stages; ++s) {
+		const size_t history = s + 1 == n_stages
+			? FinalFilter::HISTORY
+			: EarlyFilter::HISTORY;
+		for (unsigned c = 0; c < channels; ++c)
+			pending[s][c].assign(history, 0.0f);
+	}
+
+	for (unsigned c = 0; c < channels; ++c)
+		output[c].clear();
+}
+
+template<typename F>
+void
+PcmDsdDecimator::RunStage(std::vector<float> &src,
+			  std::vector<float> &dest) noexcept
+{
+	constexpr size_t L = F::LENGTH;
+
+	if (src.size() < F::HISTORY + 2)
+		return;
+
+	const size_t n = (src.size() - F::HISTORY) / 2;
+	const size_t n_padded = (n + BLOCK - 1) / BLOCK * BLOCK;
+
+	/* split the input into its polyphase components; the
+	   padding is zero-filled and its results are discarded */
+	const size_t n_even = n + 2 * L - 1, n_odd = n + L - 1;
+	even.resize(n_padded + 2 * L - 1);
+	odd.resize(n_padded + L - 1);
+
+	for (size_t i = 0; i < n_even; ++i)
+		even[i] = src[2 * i];
+	std::fill(even.begin() + n_even, even.end(), 0.0f);
+
+	for (size_t i = 0; i < n_odd; ++i)
+		odd[i] = src[2 * i + 1];
+	std::fill(odd.begin() + n_odd, odd.end(), 0.0f);
+
+	scratch.resize(n_padded);
+	F::Get().Run(scratch.data(), even.data(), odd.data(), n_padded);
+
+	dest.insert(dest.end(), scratch.begin(), scratch.begin() + n);
+	src.erase(src.begin(), src.begin() + 2 * n);
+}
+
+ConstBuffer<float>
+PcmDsdDecimator::Convert(ConstBuffer<float> src) noexcept
+{
+	assert(src.size % channels == 0);
+
+	const size_t n_frames = src.size / channels;
+
+	for (unsigned c = 0; c < channels; ++c) {
+		auto &p = pending.front()[c];
+		const size_t offset = p.size();
+		p.resize(offset + n_frames);
+		for (size_t i = 0; i < n_frames; ++i)
+			p[offset + i] = src.data[i * channels + c];
+	}
+
+	for (unsigned s = 0; s < n_stages; ++s) {
+		const bool last = s + 1 == n_stages;
+		for (unsigned c = 0; c < channels; ++c) {
+			if (last)
+				RunStage<FinalFilter>(pending[s][c], output[c]);
+			else
+				RunStage<EarlyFilter>(pending[s][c],
+						      pending[s + 1][c]);
+		}
+	}
+
+	const size_t n_out = output.front().size();
+	auto *dest = buffer.GetT<float>(n_out * channels);
+
+	for (unsigned c = 0; c < channels; ++c) {
+		assert(output[c].size() == n_out);
+
+		for (size_t i = 0; i < n_out; ++i)
+			dest[i * channels + c] = output[c][i];
+		output[c].clear();
+	}
+
+	return { dest, n_out * channels };
+}
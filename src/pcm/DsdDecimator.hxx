@@ -0,0 +1,106 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PCM_DSD_DECIMATOR_HXX
+#define MPD_PCM_DSD_DECIMATOR_HXX
+
+#include "Buffer.hxx"
+#include "ChannelDefs.hxx"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+template<typename T> struct ConstBuffer;
+
+/**
+ * A cascade of half-band FIR filters, each of which decimates by 2.
+ * It is used after #MultiDsd2Pcm to bring the 8:1 decimated DSD
+ * signal down to the output sample rate by a power of two, which is
+ * a lot cheaper than running a generic resampler at DSD rates.
+ */
+class PcmDsdDecimator {
+public:
+	/**
+	 * The largest supported decimation factor.
+	 */
+	static constexpr unsigned MAX_FACTOR = 64;
+
+private:
+	static constexpr unsigned MAX_STAGES = 6;
+	static_assert(1u << MAX_STAGES == MAX_FACTOR);
+
+	PcmBuffer buffer;
+
+	unsigned channels, n_stages;
+
+	/**
+	 * Planar input samples of each stage and channel which have
+	 * not been consumed yet; this includes the filter history.
+	 */
+	std::array<std::array<std::vector<float>, MAX_CHANNELS>,
+		   MAX_STAGES> pending;
+
+	/**
+	 * Planar output of the last stage.
+	 */
+	std::array<std::vector<float>, MAX_CHANNELS> output;
+
+	/**
+	 * Scratch buffers for the polyphase split of one stage's
+	 * input and its output.
+	 */
+	std::vector<float> even, odd, scratch;
+
+public:
+	/**
+	 * @param factor the decimation factor; must be a power of two
+	 * between 2 and #MAX_FACTOR
+	 */
+	void Open(unsigned _channels, unsigned factor) noexcept;
+
+	/**
+	 * Reset the filter history, e.g. after seeking.
+	 */
+	void Reset() noexcept;
+
+	/**
+	 * @return the number of 2:1 stages
+	 */
+	unsigned GetStages() const noexcept {
+		return n_stages;
+	}
+
+	/**
+	 * Decimate a buffer of interleaved floating point samples.
+	 * The returned buffer is invalidated by the next call.
+	 */
+	ConstBuffer<float> Convert(ConstBuffer<float> src) noexcept;
+
+private:
+	/**
+	 * Run one stage for one channel, appending the output to
+	 * #dest.
+	 */
+	template<typename F>
+	void RunStage(std::vector<float> &src,
+		      std::vector<float> &dest) noexcept;
+};
+
+#endif
@@ -0,0 +1,326 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "DsdPack.hxx"
+#include "util/ByteOrder.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * One byte of an output sample: either a byte from the input block
+ * or a constant.
+ */
+struct SampleByte {
+	uint8_t index = DsdPack::CONSTANT;
+	uint8_t constant = 0;
+
+	static constexpr SampleByte Input(unsigned i) noexcept {
+		return {uint8_t(i), 0};
+	}
+
+	static constexpr SampleByte Constant(uint8_t value) noexcept {
+		return {DsdPack::CONSTANT, value};
+	}
+};
+
+void
+DsdPack::Open(Format format, unsigned channels, Options options) noexcept
+{
+	assert(audio_valid_channel_count(channels));
+	assert(!options.shift8 || !options.pack24);
+	assert(format == Format::DOP || (!options.shift8 && !options.pack24));
+
+	/* the number of input frames per block and the number of
+	   output samples per channel generated from them */
+	const unsigned frames = format == Format::U16 ? 2 : 4;
+	const unsigned words = format == Format::DOP ? 2 : 1;
+
+	const unsigned sample_size = format == Format::U16
+		? 2
+		: (options.pack24 ? 3 : 4);
+
+	input_block_size = frames * channels;
+	output_block_size = words * channels * sample_size;
+
+	/* store the bytes in native byte order, unless reverse
+	   order was requested */
+	const bool big_endian = IsBigEndian() != options.reverse_endian;
+
+	index.fill(CONSTANT);
+	constant.fill(0);
+
+	for (unsigned w = 0; w < words; ++w) {
+		for (unsigned c = 0; c < channels; ++c) {
+			const auto in = [channels, c](unsigned frame){
+				return SampleByte::Input(frame * channels + c);
+			};
+
+			/* the sample value, least significant byte
+			   first; the oldest DSD byte is the most
+			   significant one */
+			SampleByte value[4];
+
+			switch (format) {
+			case Format::U16:
+				value[1] = in(0);
+				value[0] = in(1);
+				break;
+
+			case Format::U32:
+				value[3] = in(0);
+				value[2] = in(1);
+				value[1] = in(2);
+				value[0] = in(3);
+				break;
+
+			case Format::DOP:
+				/* each 24 bit sample has 16 DSD
+				   sample bits plus the marker, which
+				   alternates between 0x05 and 0xfa */
+				value[3] = SampleByte::Constant(0xff);
+				value[2] = SampleByte::Constant(w == 0 ? 0x05 : 0xfa);
+				value[1] = in(2 * w);
+				value[0] = in(2 * w + 1);
+
+				if (options.shift8) {
+					value[3] = value[2];
+					value[2] = value[1];
+					value[1] = value[0];
+					value[0] = SampleByte::Constant(0);
+				}
+
+				break;
+			}
+
+			const size_t position = (w * channels + c) * sample_size;
+			for (unsigned b = 0; b < sample_size; ++b) {
+				const auto &v = value[big_endian
+						      ? sample_size - 1 - b
+						      : b];
+				index[position + b] = v.index;
+				constant[position + b] = v.constant;
+			}
+		}
+	}
+
+	BuildChunks();
+
+	function = RunScalar;
+
+	if (!chunks.empty()) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		if (__builtin_cpu_supports("ssse3"))
+			function = RunSSSE3;
+#elif defined(__ARM_NEON)
+		function = RunNeon;
+#endif
+	}
+}
+
+void
+DsdPack::BuildChunks() noexcept
+{
+	chunks.clear();
+
+	group_blocks = 16 / std::gcd(output_block_size, size_t(16));
+	group_read_size = 0;
+
+	const size_t n_chunks = group_blocks * output_block_size / 16;
+	chunks.resize(n_chunks);
+
+	for (size_t k = 0; k < n_chunks; ++k) {
+		auto &chunk = chunks[k];
+
+		/* the input position of each output byte in this
+		   chunk, relative to the start of the group */
+		unsigned source[16];
+		bool from_input[16];
+
+		for (unsigned b = 0; b < 16; ++b) {
+			const size_t o = 16 * k + b;
+			const size_t block = o / output_block_size;
+			const size_t i = o % output_block_size;
+
+			chunk.constant[b] = constant[i];
+			from_input[b] = index[i] != CONSTANT;
+			source[b] = block * input_block_size + index[i];
+		}
+
+		/* cover the source bytes with as few 16 byte
+		   windows as possible */
+		chunk.n_windows = 0;
+		std::fill_n(&chunk.map[0][0], sizeof(chunk.map), CONSTANT);
+
+		while (true) {
+			unsigned lowest = ~0u;
+			for (unsigned b = 0; b < 16; ++b)
+				if (from_input[b])
+					lowest = std::min(lowest, source[b]);
+
+			if (lowest == ~0u)
+				break;
+
+			if (chunk.n_windows == MAX_WINDOWS) {
+				/* too scattered: don't vectorize */
+				chunks.clear();
+				return;
+			}
+
+			const unsigned w = chunk.n_windows++;
+			chunk.offset[w] = lowest;
+			group_read_size = std::max(group_read_size,
+						   size_t(lowest) + 16);
+
+			for (unsigned b = 0; b < 16; ++b) {
+				if (from_input[b] && source[b] < lowest + 16) {
+					chunk.map[w][b] = source[b] - lowest;
+					from_input[b] = false;
+				}
+			}
+		}
+	}
+}
+
+bool
+DsdPack::IsVectorized() const noexcept
+{
+	return function != RunScalar;
+}
+
+size_t
+DsdPack::GetVectorBlocks(size_t n_blocks) const noexcept
+{
+	/* the vectorized kernels may read up to group_read_size
+	   bytes per group, which can be more than one group of input
+	   (e.g. with mono); leave enough blocks to the scalar
+	   kernel */
+	const size_t input_size = n_blocks * input_block_size;
+	if (input_size < group_read_size)
+		return 0;
+
+	const size_t max_groups = (input_size - group_read_size) /
+		(group_blocks * input_block_size) + 1;
+	const size_t n_groups = std::min(max_groups, n_blocks / group_blocks);
+	return n_groups * group_blocks;
+}
+
+void
+DsdPack::PackScalar(uint8_t *dest, const uint8_t *src,
+		    size_t n_blocks) const noexcept
+{
+	for (size_t n = 0; n < n_blocks; ++n) {
+		for (size_t i = 0; i < output_block_size; ++i)
+			dest[i] = index[i] != CONSTANT
+				? src[index[i]]
+				: constant[i];
+
+		src += input_block_size;
+		dest += output_block_size;
+	}
+}
+
+void
+DsdPack::RunScalar(const DsdPack &pack, uint8_t *dest,
+		   const uint8_t *src, size_t n_blocks) noexcept
+{
+	pack.PackScalar(dest, src, n_blocks);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+__attribute__((target("ssse3")))
+void
+DsdPack::RunSSSE3(const DsdPack &pack, uint8_t *dest,
+		  const uint8_t *src, size_t n_blocks) noexcept
+{
+	const size_t vector_blocks = pack.GetVectorBlocks(n_blocks);
+	const size_t group_input = pack.group_blocks * pack.input_block_size;
+
+	for (size_t n = 0; n < vector_blocks; n += pack.group_blocks) {
+		for (const auto &chunk : pack.chunks) {
+			__m128i r = _mm_loadu_si128((const __m128i *)chunk.constant);
+
+			for (unsigned w = 0; w < chunk.n_windows; ++w) {
+				const __m128i in = _mm_loadu_si128((const __m128i *)(src + chunk.offset[w]));
+				const __m128i map = _mm_loadu_si128((const __m128i *)chunk.map[w]);
+				r = _mm_or_si128(r, _mm_shuffle_epi8(in, map));
+			}
+
+			_mm_storeu_si128((__m128i *)dest, r);
+			dest += 16;
+		}
+
+		src += group_input;
+	}
+
+	pack.PackScalar(dest, src, n_blocks - vector_blocks);
+}
+
+#elif defined(__ARM_NEON)
+
+/**
+ * Look up 16 bytes in a 16 byte table; out of range indices
+ * (#DsdPack::CONSTANT) produce zero bytes.
+ */
+static inline uint8x16_t
+Lookup(uint8x16_t table, uint8x16_t map) noexcept
+{
+#ifdef __aarch64__
+	return vqtbl1q_u8(table, map);
+#else
+	const uint8x8x2_t t{{vget_low_u8(table), vget_high_u8(table)}};
+	return vcombine_u8(vtbl2_u8(t, vget_low_u8(map)),
+			   vtbl2_u8(t, vget_high_u8(map)));
+#endif
+}
+
+void
+DsdPack::RunNeon(const DsdPack &pack, uint8_t *dest,
+		 const uint8_t *src, size_t n_blocks) noexcept
+{
+	const size_t vector_blocks = pack.GetVectorBlocks(n_blocks);
+	const size_t group_input = pack.group_blocks * pack.input_block_size;
+
+	for (size_t n = 0; n < vector_blocks; n += pack.group_blocks) {
+		for (const auto &chunk : pack.chunks) {
+			uint8x16_t r = vld1q_u8(chunk.constant);
+
+			for (unsigned w = 0; w < chunk.n_windows; ++w)
+				r = vorrq_u8(r, Lookup(vld1q_u8(src + chunk.offset[w]),
+						       vld1q_u8(chunk.map[w])));
+
+			vst1q_u8(dest, r);
+			dest += 16;
+		}
+
+		src += group_input;
+	}
+
+	pack.PackScalar(dest, src, n_blocks - vector_blocks);
+}
+
+#endif
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PCM_DSD_PACK_HXX
+#define MPD_PCM_DSD_PACK_HXX
+
+#include "ChannelDefs.hxx"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Packs blocks of interleaved DSD_U8 bytes into the final export
+ * layout: DSD_U16, DSD_U32 or DoP, optionally shifted to 32 bit,
+ * packed to 24 bit and/or in reverse byte order.
+ *
+ * Each of these is a fixed byte shuffle plus some constant bytes
+ * (DoP markers, padding), so Open() precomputes a map and Pack()
+ * does the whole conversion in one pass, using SSSE3 or NEON byte
+ * shuffles if available.
+ */
+class DsdPack {
+public:
+	enum class Format : uint8_t {
+		U16,
+		U32,
+		DOP,
+	};
+
+	struct Options {
+		/**
+		 * Shift DoP samples 8 bits to the left (24 bit
+		 * samples in a 32 bit container)?
+		 */
+		bool shift8 = false;
+
+		/**
+		 * Pack DoP samples to 3 bytes?
+		 */
+		bool pack24 = false;
+
+		/**
+		 * Store the samples in reverse byte order?
+		 */
+		bool reverse_endian = false;
+	};
+
+	/**
+	 * A map entry for output bytes which do not come from the
+	 * input.
+	 */
+	static constexpr uint8_t CONSTANT = 0x80;
+
+private:
+	static constexpr size_t MAX_INPUT_BLOCK = 4 * MAX_CHANNELS;
+	static constexpr size_t MAX_OUTPUT_BLOCK = 8 * MAX_CHANNELS;
+
+	/**
+	 * The maximum number of 16 byte input windows one output
+	 * chunk may be assembled from.
+	 */
+	static constexpr unsigned MAX_WINDOWS = 4;
+
+	/**
+	 * Describes how to assemble 16 output bytes from up to
+	 * #MAX_WINDOWS shuffled input windows.
+	 */
+	struct Chunk {
+		uint8_t map[MAX_WINDOWS][16];
+		uint8_t constant[16];
+		unsigned offset[MAX_WINDOWS];
+		unsigned n_windows;
+	};
+
+	using Function = void (*)(const DsdPack &pack, uint8_t *dest,
+				  const uint8_t *src, size_t n_blocks);
+
+	size_t input_block_size, output_block_size;
+
+	/**
+	 * For each output byte of a block: the input byte index or
+	 * #CONSTANT.
+	 */
+	std::array<uint8_t, MAX_OUTPUT_BLOCK> index;
+
+	/**
+	 * For each output byte of a block: the constant which is
+	 * OR'ed into it (zero for bytes copied from the input).
+	 */
+	std::array<uint8_t, MAX_OUTPUT_BLOCK> constant;
+
+	/**
+	 * The chunks covering one group of #group_blocks blocks,
+	 * which is the smallest multiple of the output block size
+	 * consisting of whole 16 byte chunks.  Empty if the layout
+	 * cannot be vectorized.
+	 */
+	std::vector<Chunk> chunks;
+
+	size_t group_blocks;
+
+	/**
+	 * The number of input bytes the vectorized kernel may read
+	 * when processing one group.
+	 */
+	size_t group_read_size;
+
+	Function function;
+
+public:
+	/**
+	 * @param format the export format; for #Format::DOP, the
+	 * output are 24 bit samples padded to 32 bit unless
+	 * #Options::pack24 is set
+	 */
+	void Open(Format format, unsigned channels,
+		  Options options) noexcept;
+
+	/**
+	 * @return the number of input bytes consumed per block
+	 */
+	size_t GetInputBlockSize() const noexcept {
+		return input_block_size;
+	}
+
+	/**
+	 * @return the number of output bytes generated per block
+	 */
+	size_t GetOutputBlockSize() const noexcept {
+		return output_block_size;
+	}
+
+	/**
+	 * Convert the given number of blocks.
+	 */
+	void Pack(uint8_t *dest, const uint8_t *src,
+		  size_t n_blocks) const noexcept {
+		function(*this, dest, src, n_blocks);
+	}
+
+	/**
+	 * Like Pack(), but always use the portable implementation.
+	 * This is used by the unit tests and benchmarks.
+	 */
+	void PackScalar(uint8_t *dest, const uint8_t *src,
+			size_t n_blocks) const noexcept;
+
+	/**
+	 * Does Pack() use a vectorized implementation?
+	 */
+	bool IsVectorized() const noexcept;
+
+private:
+	void BuildChunks() noexcept;
+
+	/**
+	 * @return the number of blocks the vectorized kernel may
+	 * process without reading beyond the given number of blocks
+	 */
+	size_t GetVectorBlocks(size_t n_blocks) const noexcept;
+
+	static void RunScalar(const DsdPack &pack, uint8_t *dest,
+			      const uint8_t *src, size_t n_blocks) noexcept;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	static void RunSSSE3(const DsdPack &pack, uint8_t *dest,
+			     const uint8_t *src, size_t n_blocks) noexcept;
+#endif
+
+#if defined(__ARM_NEON)
+	static void RunNeon(const DsdPack &pack, uint8_t *dest,
+			    const uint8_t *src, size_t n_blocks) noexcept;
+#endif
+};
+
+#endif
@@ -52,24 +52,18 @@ PcmExport::Open(SampleFormat sample_format, unsigned _channels,
 		break;
 
 	case DsdMode::U16:
-		dsd16_converter.Open(_channels);
-
 		/* after the conversion to DSD_U16, the DSD samples
 		   are stuffed inside fake 16 bit samples */
 		sample_format = SampleFormat::S16;
 		break;
 
 	case DsdMode::U32:
-		dsd32_converter.Open(_channels);
-
 		/* after the conversion to DSD_U32, the DSD samples
 		   are stuffed inside fake 32 bit samples */
 		sample_format = SampleFormat::S32;
 		break;
 
 	case DsdMode::DOP:
-		dop_converter.Open(_channels);
-
 		/* after the conversion to DoP, the DSD
 		   samples are stuffed inside fake 24 bit samples */
 		sample_format = SampleFormat::S24_P32;
@@ -93,6 +87,33 @@ PcmExport::Open(SampleFormat sample_format, unsigned _channels,
 			reverse_endian = sample_size;
 	}
 
+#ifdef ENABLE_DSD
+	/* the DSD converters generate the final layout in one pass,
+	   including shift8, pack24 and reverse_endian */
+	switch (dsd_mode) {
+	case DsdMode::NONE:
+		break;
+
+	case DsdMode::U16:
+		dsd16_converter.Open(_channels, reverse_endian > 0);
+		break;
+
+	case DsdMode::U32:
+		dsd32_converter.Open(_channels, reverse_endian > 0);
+		break;
+
+	case DsdMode::DOP:
+		{
+			DsdPack::Options options;
+			options.shift8 = shift8;
+			options.pack24 = pack24;
+			options.reverse_endian = reverse_endian > 0;
+			dop_converter.Open(_channels, options);
+		}
+		break;
+	}
+#endif
+
 	/* prepare a moment of silence for GetSilence() */
 	char buffer[sizeof(silence_buffer)];
 	const size_t buffer_size = GetInputBlockSize();
@@ -276,19 +297,15 @@ PcmExport::Export(ConstBuffer<void> data) noexcept
 		break;
 
 	case DsdMode::U16:
-		data = dsd16_converter.Convert(ConstBuffer<uint8_t>::FromVoid(data))
+		return dsd16_converter.Convert(ConstBuffer<uint8_t>::FromVoid(data))
 			.ToVoid();
-		break;
 
 	case DsdMode::U32:
-		data = dsd32_converter.Convert(ConstBuffer<uint8_t>::FromVoid(data))
+		return dsd32_converter.Convert(ConstBuffer<uint8_t>::FromVoid(data))
 			.ToVoid();
-		break;
 
 	case DsdMode::DOP:
-		data = dop_converter.Convert(ConstBuffer<uint8_t>::FromVoid(data))
-			.ToVoid();
-		break;
+		return dop_converter.Convert(ConstBuffer<uint8_t>::FromVoid(data));
 	}
 #endif
 
@@ -99,7 +99,7 @@ AnalyzeMixRamp(const MusicPipe &pipe, const AudioFormat &audio_format,
 	MixRampAnalyzer a;
 	do {
 		a.Process(ConstBuffer<ReplayGainAnalyzer::Frame>::FromVoid({chunk->data, chunk->length}));
-	} while ((chunk = chunk->next.get()) != nullptr);
+	} while ((chunk = chunk->GetNext()) != nullptr);
 
 	return ToString(a.GetResult(), a.GetTime(), direction);
 }
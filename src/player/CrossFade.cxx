@@ -111,6 +111,7 @@ unsigned
 CrossFadeSettings::Calculate(float replay_gain_db, float replay_gain_prev_db,
 			     const char *mixramp_start, const char *mixramp_prev_end,
 			     const AudioFormat af,
+			     std::size_t chunk_size,
 			     unsigned max_chunks) const noexcept
 {
 	assert(IsEnabled());
@@ -121,7 +122,7 @@ CrossFadeSettings::Calculate(float replay_gain_db, float replay_gain_prev_db,
 	assert(af.IsValid());
 
 	const auto chunk_duration =
-		af.SizeToTime<FloatDuration>(sizeof(MusicChunk::data));
+		af.SizeToTime<FloatDuration>(GetMusicChunkCapacity(chunk_size));
 
 	if (!IsMixRampEnabled() ||
 	    !mixramp_start || !mixramp_prev_end) {
@@ -22,6 +22,8 @@
 
 #include "Chrono.hxx"
 
+#include <cstddef>
+
 struct AudioFormat;
 class SignedSongTime;
 
@@ -74,6 +76,8 @@ struct CrossFadeSettings {
 	 * @param mixramp_start the next songs mixramp_start tag
 	 * @param mixramp_prev_end the last songs mixramp_end setting
 	 * @param af the audio format of the new song
+	 * @param chunk_size the size of the chunks, see
+	 * MusicBuffer::GetChunkSize()
 	 * @param max_chunks the maximum number of chunks
 	 * @return the number of chunks for crossfading, or 0 if cross fading
 	 * should be disabled for this song change
@@ -83,6 +87,7 @@ struct CrossFadeSettings {
 			   const char *mixramp_start,
 			   const char *mixramp_prev_end,
 			   AudioFormat af,
+			   std::size_t chunk_size,
 			   unsigned max_chunks) const noexcept;
 
 private:
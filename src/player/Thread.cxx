@@ -93,16 +93,6 @@ class Player {
 	 */
 	unsigned buffer_before_play;
 
-	/**
-	 * If the decoder pipe gets consumed below this threshold,
-	 * it's time to wake up the decoder.
-	 *
-	 * It is calculated in a way which should prevent a wakeup
-	 * after each single consumed chunk; it is more efficient to
-	 * make the decoder decode a larger block at a time.
-	 */
-	const unsigned decoder_wakeup_threshold;
-
 	/**
 	 * Are we waiting for #buffer_before_play?
 	 */
@@ -199,12 +189,22 @@ class Player {
 public:
 	Player(PlayerControl &_pc, DecoderControl &_dc,
 	       MusicBuffer &_buffer) noexcept
-		:pc(_pc), dc(_dc), buffer(_buffer),
-		 decoder_wakeup_threshold(buffer.GetSize() * 3 / 4)
+		:pc(_pc), dc(_dc), buffer(_buffer)
 	{
 	}
 
 private:
+	/**
+	 * The size of the chunks allocated by the decoder for its
+	 * current audio format.
+	 *
+	 * Caller must lock the mutex.
+	 */
+	[[gnu::pure]]
+	std::size_t GetDecoderChunkSize() const noexcept {
+		return buffer.GetChunkSize(dc.out_audio_format);
+	}
+
 	/**
 	 * Reset cross-fading to the initial state.  A check to
 	 * re-enable it at an appropriate time will be scheduled.
@@ -525,16 +525,19 @@ Player::MixRampScannerReady() noexcept
 	}
 
 	if (dc.GetMixRampStart() == nullptr) {
+		const std::size_t chunk_size = GetDecoderChunkSize();
+		const std::size_t chunk_capacity =
+			GetMusicChunkCapacity(chunk_size);
 		const std::size_t want_pipe_bytes =
 			dc.out_audio_format.TimeToSize(std::chrono::seconds{20});
 		const std::size_t want_pipe_chunks =
-			std::min((want_pipe_bytes + sizeof(MusicChunk::data) - 1)
-				 / sizeof(MusicChunk::data),
-				 buffer.GetSize() / std::size_t{3});
+			std::min((want_pipe_bytes + chunk_capacity - 1)
+				 / chunk_capacity,
+				 buffer.GetSize(chunk_size) / std::size_t{3});
 
 		if (dc.pipe->GetSize() < want_pipe_chunks) {
 			/* need more data */
-			if (!buffer.IsFull()) {
+			if (!buffer.IsFull(chunk_size)) {
 				decoder_woken = true;
 				dc.Signal();
 			}
@@ -613,11 +616,13 @@ Player::CheckDecoderStartup(std::unique_lock<Mutex> &lock) noexcept
 		play_audio_format = dc.out_audio_format;
 		decoder_starting = false;
 
+		const size_t chunk_capacity =
+			GetMusicChunkCapacity(buffer.GetChunkSize(play_audio_format));
 		const size_t buffer_before_play_size =
 			play_audio_format.TimeToSize(buffer_before_play_duration);
 		buffer_before_play =
-			(buffer_before_play_size + sizeof(MusicChunk::data) - 1)
-			/ sizeof(MusicChunk::data);
+			(buffer_before_play_size + chunk_capacity - 1)
+			/ chunk_capacity;
 
 		idle_add(IDLE_PLAYER);
 
@@ -900,13 +905,15 @@ Player::CheckCrossFade() noexcept
 
 	/* enable cross fading in this song?  if yes, calculate how
 	   many chunks will be required for it */
+	const std::size_t chunk_size = buffer.GetChunkSize(play_audio_format);
 	cross_fade_chunks =
 		pc.cross_fade.Calculate(dc.replay_gain_db,
 					dc.replay_gain_prev_db,
 					dc.GetMixRampStart(),
 					dc.GetMixRampPreviousEnd(),
 					play_audio_format,
-					buffer.GetSize() -
+					chunk_size,
+					buffer.GetSize(chunk_size) -
 					buffer_before_play);
 	if (cross_fade_chunks > 0)
 		xfade_state = CrossFadeState::ENABLED;
@@ -965,7 +972,12 @@ PlayerControl::PlayChunk(DetachedSong &song, MusicChunkPtr chunk,
 inline bool
 Player::PlayNextChunk() noexcept
 {
-	if (!pc.LockWaitOutputConsumed(64))
+	/* allow 64 chunks of the smallest size in the output pipe,
+	   i.e. the same amount of memory for larger chunks */
+	const unsigned max_output_chunks =
+		std::max(64 * CHUNK_SIZE / buffer.GetChunkSize(play_audio_format),
+			 std::size_t{4});
+	if (!pc.LockWaitOutputConsumed(max_output_chunks))
 		/* the output pipe is still large enough, don't send
 		   another chunk */
 		return true;
@@ -1079,7 +1091,8 @@ Player::PlayNextChunk() noexcept
 	/* this formula should prevent that the decoder gets woken up
 	   with each chunk; it is more efficient to make it decode a
 	   larger block at a time */
-	if (!dc.IsIdle() && dc.pipe->GetSize() <= decoder_wakeup_threshold) {
+	if (!dc.IsIdle() &&
+	    dc.pipe->GetSize() <= buffer.GetSize(GetDecoderChunkSize()) * 3 / 4) {
 		if (!decoder_woken) {
 			decoder_woken = true;
 			dc.Signal();
@@ -1150,7 +1163,8 @@ Player::Run() noexcept
 			   prevent stuttering on slow machines */
 
 			if (pipe->GetSize() < buffer_before_play &&
-			    !dc.IsIdle() && !buffer.IsFull()) {
+			    !dc.IsIdle() &&
+			    !buffer.IsFull(buffer.GetChunkSize(play_audio_format))) {
 				/* not enough decoded buffer space yet */
 
 				dc.WaitForDecoder(lock);
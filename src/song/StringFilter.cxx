@@ -19,6 +19,7 @@
 
 #include "StringFilter.hxx"
 #include "util/StringAPI.hxx"
+#include "util/StringCompare.hxx"
 
 #include <cassert>
 
@@ -32,15 +33,24 @@ StringFilter::MatchWithoutNegation(const char *s) const noexcept
 		return regex->Match(s);
 #endif
 
-	if (fold_case) {
-		return substring
+	switch (position) {
+	case Position::FULL:
+		break;
+
+	case Position::ANYWHERE:
+		return fold_case
 			? fold_case.IsIn(s)
-			: fold_case == s;
-	} else {
-		return substring
-			? StringFind(s, value.c_str()) != nullptr
-			: value == s;
+			: StringFind(s, value.c_str()) != nullptr;
+
+	case Position::PREFIX:
+		return fold_case
+			? fold_case.StartsWith(s)
+			: StringStartsWith(s, StringView(value.data(), value.size()));
 	}
+
+	return fold_case
+		? fold_case == s
+		: value == s;
 }
 
 bool
@@ -27,10 +27,24 @@
 #include "lib/pcre/UniqueRegex.hxx"
 #endif
 
+#include <cstdint>
 #include <string>
 #include <memory>
 
 class StringFilter {
+public:
+	enum class Position : uint_least8_t {
+		/** compare the whole string */
+		FULL,
+
+		/** find the value anywhere in the string */
+		ANYWHERE,
+
+		/** compare the beginning of the string */
+		PREFIX,
+	};
+
+private:
 	std::string value;
 
 	/**
@@ -42,21 +56,19 @@ class StringFilter {
 	std::shared_ptr<UniqueRegex> regex;
 #endif
 
-	/**
-	 * Search for substrings instead of matching the whole string?
-	 */
-	bool substring;
+	Position position;
 
 	bool negated;
 
 public:
 	template<typename V>
-	StringFilter(V &&_value, bool _fold_case, bool _substring, bool _negated)
+	StringFilter(V &&_value, bool _fold_case, Position _position,
+		     bool _negated)
 		:value(std::forward<V>(_value)),
 		 fold_case(_fold_case
 			   ? IcuCompare(value)
 			   : IcuCompare()),
-		 substring(_substring), negated(_negated) {}
+		 position(_position), negated(_negated) {}
 
 	bool empty() const noexcept {
 		return value.empty();
@@ -85,6 +97,10 @@ public:
 		return fold_case;
 	}
 
+	Position GetPosition() const noexcept {
+		return position;
+	}
+
 	bool IsNegated() const noexcept {
 		return negated;
 	}
@@ -94,11 +110,21 @@ public:
 	}
 
 	const char *GetOperator() const noexcept {
-		return IsRegex()
-			? (negated ? "!~" : "=~")
-			: (substring
-			   ? (negated ? "!contains" : "contains")
-			   : (negated ? "!=" : "=="));
+		if (IsRegex())
+			return negated ? "!~" : "=~";
+
+		switch (position) {
+		case Position::ANYWHERE:
+			return negated ? "!contains" : "contains";
+
+		case Position::PREFIX:
+			return negated ? "!starts_with" : "starts_with";
+
+		case Position::FULL:
+			break;
+		}
+
+		return negated ? "!=" : "==";
 	}
 
 	[[gnu::pure]]
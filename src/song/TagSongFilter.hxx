@@ -50,6 +50,14 @@ public:
 		return filter.GetFoldCase();
 	}
 
+	bool IsRegex() const noexcept {
+		return filter.IsRegex();
+	}
+
+	StringFilter::Position GetPosition() const noexcept {
+		return filter.GetPosition();
+	}
+
 	bool IsNegated() const noexcept {
 		return filter.IsNegated();
 	}
@@ -37,11 +37,8 @@ TagBuilder::TagBuilder(const Tag &other) noexcept
 	items.reserve(other.num_items);
 
 	const std::size_t n = other.num_items;
-	if (n > 0) {
-		const std::scoped_lock<Mutex> protect(tag_pool_lock);
-		for (std::size_t i = 0; i != n; ++i)
-			items.push_back(tag_pool_dup_item(other.items[i]));
-	}
+	for (std::size_t i = 0; i != n; ++i)
+		items.push_back(tag_pool_dup_item(other.items[i]));
 }
 
 TagBuilder::TagBuilder(Tag &&other) noexcept
@@ -72,7 +69,6 @@ TagBuilder::operator=(const TagBuilder &other) noexcept
 		items = other.items;
 
 		/* increment the tag pool refcounters */
-		const std::scoped_lock<Mutex> protect(tag_pool_lock);
 		for (auto &i : items)
 			i = tag_pool_dup_item(i);
 	}
@@ -187,27 +183,17 @@ TagBuilder::Complement(const Tag &other) noexcept
 	items.reserve(items.size() + other.num_items);
 
 	const std::size_t n = other.num_items;
-	if (n > 0) {
-		const std::scoped_lock<Mutex> protect(tag_pool_lock);
-		for (std::size_t i = 0; i != n; ++i) {
-			TagItem *item = other.items[i];
-			if (!present[item->type])
-				items.push_back(tag_pool_dup_item(item));
-		}
+	for (std::size_t i = 0; i != n; ++i) {
+		TagItem *item = other.items[i];
+		if (!present[item->type])
+			items.push_back(tag_pool_dup_item(item));
 	}
 }
 
 void
 TagBuilder::AddItemUnchecked(TagType type, StringView value) noexcept
 {
-	TagItem *i;
-
-	{
-		const std::scoped_lock<Mutex> protect(tag_pool_lock);
-		i = tag_pool_get_item(type, value);
-	}
-
-	items.push_back(i);
+	items.push_back(tag_pool_get_item(type, value));
 }
 
 inline void
@@ -246,16 +232,8 @@ TagBuilder::AddEmptyItem(TagType type) noexcept
 void
 TagBuilder::RemoveAll() noexcept
 {
-	if (items.empty())
-		/* don't acquire the tag_pool_lock if we're not going
-		   to call tag_pool_put_item() anyway */
-		return;
-
-	{
-		const std::scoped_lock<Mutex> protect(tag_pool_lock);
-		for (auto i : items)
-			tag_pool_put_item(i);
-	}
+	for (auto i : items)
+		tag_pool_put_item(i);
 
 	items.clear();
 }
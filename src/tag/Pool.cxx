@@ -19,10 +19,12 @@
 
 #include "Pool.hxx"
 #include "Item.hxx"
+#include "thread/Mutex.hxx"
 #include "util/Cast.hxx"
 #include "util/VarSize.hxx"
 #include "util/StringView.hxx"
 
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <limits>
@@ -30,16 +32,26 @@
 #include <string.h>
 #include <stdlib.h>
 
-Mutex tag_pool_lock;
-
-static constexpr size_t NUM_SLOTS = 16127;
+/**
+ * The pool is split into shards, each with its own lock, so threads
+ * creating tags at the same time rarely contend for a lock.
+ */
+static constexpr size_t NUM_SHARDS = 64;
+static constexpr size_t NUM_SLOTS = 251;
 
 struct TagPoolSlot {
 	TagPoolSlot *next;
-	uint8_t ref = 1;
+
+	/**
+	 * The reference counter.  Once it has dropped to zero, the
+	 * slot is dead: it will be removed from the shard by
+	 * tag_pool_put_item() and cannot be referenced again.
+	 */
+	std::atomic<uint8_t> ref = 1;
+
 	TagItem item;
 
-	static constexpr unsigned MAX_REF = std::numeric_limits<decltype(ref)>::max();
+	static constexpr unsigned MAX_REF = std::numeric_limits<uint8_t>::max();
 
 	TagPoolSlot(TagPoolSlot *_next, TagType type,
 		    StringView value) noexcept
@@ -51,6 +63,20 @@ struct TagPoolSlot {
 
 	static TagPoolSlot *Create(TagPoolSlot *_next, TagType type,
 				   StringView value) noexcept;
+
+	/**
+	 * Obtain another reference unless this slot is dead or
+	 * "full".
+	 */
+	bool TryRef() noexcept {
+		auto r = ref.load(std::memory_order_relaxed);
+		while (r > 0 && r < MAX_REF)
+			if (ref.compare_exchange_weak(r, r + 1,
+						      std::memory_order_relaxed))
+				return true;
+
+		return false;
+	}
 };
 
 TagPoolSlot *
@@ -64,7 +90,16 @@ TagPoolSlot::Create(TagPoolSlot *_next, TagType type,
 				       value);
 }
 
-static TagPoolSlot *slots[NUM_SLOTS];
+struct alignas(64) TagPoolShard {
+	/**
+	 * Protects the #slots lists, but not the reference counters.
+	 */
+	Mutex mutex;
+
+	TagPoolSlot *slots[NUM_SLOTS];
+};
+
+static TagPoolShard shards[NUM_SHARDS];
 
 static inline unsigned
 calc_hash(TagType type, StringView p) noexcept
@@ -96,30 +131,32 @@ tag_item_to_slot(TagItem *item) noexcept
 	return &ContainerCast(*item, &TagPoolSlot::item);
 }
 
-static inline TagPoolSlot **
-tag_value_slot_p(TagType type, StringView value) noexcept
+static inline TagPoolShard &
+hash_to_shard(unsigned hash) noexcept
 {
-	return &slots[calc_hash(type, value) % NUM_SLOTS];
+	return shards[hash % NUM_SHARDS];
 }
 
 static inline TagPoolSlot **
-tag_value_slot_p(TagType type, const char *value) noexcept
+hash_to_slot_p(TagPoolShard &shard, unsigned hash) noexcept
 {
-	return &slots[calc_hash(type, value) % NUM_SLOTS];
+	return &shard.slots[hash / NUM_SHARDS % NUM_SLOTS];
 }
 
 TagItem *
 tag_pool_get_item(TagType type, StringView value) noexcept
 {
-	auto slot_p = tag_value_slot_p(type, value);
+	const unsigned hash = calc_hash(type, value);
+	auto &shard = hash_to_shard(hash);
+	auto slot_p = hash_to_slot_p(shard, hash);
+
+	const std::scoped_lock<Mutex> protect(shard.mutex);
+
 	for (auto slot = *slot_p; slot != nullptr; slot = slot->next) {
 		if (slot->item.type == type &&
 		    value.Equals(slot->item.value) &&
-		    slot->ref < TagPoolSlot::MAX_REF) {
-			assert(slot->ref > 0);
-			++slot->ref;
+		    slot->TryRef())
 			return &slot->item;
-		}
 	}
 
 	auto slot = TagPoolSlot::Create(*slot_p, type, value);
@@ -134,8 +171,7 @@ tag_pool_dup_item(TagItem *item) noexcept
 
 	assert(slot->ref > 0);
 
-	if (slot->ref < TagPoolSlot::MAX_REF) {
-		++slot->ref;
+	if (slot->TryRef()) {
 		return item;
 	} else {
 		/* the reference counter overflows above MAX_REF;
@@ -152,17 +188,28 @@ tag_pool_put_item(TagItem *item) noexcept
 
 	slot = tag_item_to_slot(item);
 	assert(slot->ref > 0);
-	--slot->ref;
 
-	if (slot->ref > 0)
+	if (slot->ref.fetch_sub(1, std::memory_order_acq_rel) > 1)
 		return;
 
-	for (slot_p = tag_value_slot_p(item->type, item->value);
-	     *slot_p != slot;
-	     slot_p = &(*slot_p)->next) {
-		assert(*slot_p != nullptr);
+	/* this was the last reference; nobody else can obtain a new
+	   one (see TagPoolSlot::TryRef()), so all that's left is
+	   removing the slot from its list */
+
+	const unsigned hash = calc_hash(item->type, item->value);
+	auto &shard = hash_to_shard(hash);
+
+	{
+		const std::scoped_lock<Mutex> protect(shard.mutex);
+
+		for (slot_p = hash_to_slot_p(shard, hash);
+		     *slot_p != slot;
+		     slot_p = &(*slot_p)->next) {
+			assert(*slot_p != nullptr);
+		}
+
+		*slot_p = slot->next;
 	}
 
-	*slot_p = slot->next;
 	DeleteVarSize(slot);
 }
@@ -21,13 +21,15 @@
 #define MPD_TAG_POOL_HXX
 
 #include "Type.h"
-#include "thread/Mutex.hxx"
-
-extern Mutex tag_pool_lock;
 
 struct TagItem;
 struct StringView;
 
+/*
+ * The tag pool shares #TagItem objects between all #Tag instances
+ * with the same items.  All functions are thread-safe.
+ */
+
 [[nodiscard]]
 TagItem *
 tag_pool_get_item(TagType type, StringView value) noexcept;
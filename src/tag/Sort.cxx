@@ -20,38 +20,38 @@
 #include "Sort.hxx"
 #include "Tag.hxx"
 
-#include <algorithm>
-
 #include <string.h>
 #include <stdlib.h>
 
-[[gnu::pure]]
-static bool
-CompareNumeric(const char *a, const char *b) noexcept
+TagSortKey::TagSortKey(TagType type, const Tag &tag) noexcept
+	:value(tag.GetSortValue(type))
 {
-	long a_value = strtol(a, nullptr, 10);
-	long b_value = strtol(b, nullptr, 10);
+	switch (type) {
+	case TAG_DISC:
+	case TAG_TRACK:
+		number = strtol(value, nullptr, 10);
+		numeric = true;
+		break;
 
-	return a_value < b_value;
+	default:
+		break;
+	}
 }
 
 bool
-CompareTags(TagType type, bool descending, const Tag &a, const Tag &b) noexcept
+TagSortKey::operator<(const TagSortKey &other) const noexcept
 {
-	const char *a_value = a.GetSortValue(type);
-	const char *b_value = b.GetSortValue(type);
-
-	if (descending) {
-		using std::swap;
-		swap(a_value, b_value);
-	}
+	return numeric
+		? number < other.number
+		: strcmp(value, other.value) < 0;
+}
 
-	switch (type) {
-	case TAG_DISC:
-	case TAG_TRACK:
-		return CompareNumeric(a_value, b_value);
+bool
+CompareTags(TagType type, bool descending, const Tag &a, const Tag &b) noexcept
+{
+	const TagSortKey a_key(type, a), b_key(type, b);
 
-	default:
-		return strcmp(a_value, b_value) < 0;
-	}
+	return descending
+		? b_key < a_key
+		: a_key < b_key;
 }
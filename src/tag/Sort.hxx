@@ -23,6 +23,33 @@
 
 struct Tag;
 
+/**
+ * The value of a #Tag which CompareTags() compares, looked up (with
+ * all fallbacks) once, so sorting many tags doesn't need to do that
+ * on each comparison.  It points into the #TagItem objects of the
+ * #Tag and is only valid as long as the #Tag is.
+ */
+struct TagSortKey {
+	const char *value = "";
+
+	/**
+	 * The parsed #value if #numeric is set.
+	 */
+	long number = 0;
+
+	/**
+	 * Compare #number instead of #value (for #TAG_DISC and
+	 * #TAG_TRACK).
+	 */
+	bool numeric = false;
+
+	TagSortKey() noexcept = default;
+	TagSortKey(TagType type, const Tag &tag) noexcept;
+
+	[[gnu::pure]]
+	bool operator<(const TagSortKey &other) const noexcept;
+};
+
 [[gnu::pure]]
 bool
 CompareTags(TagType type, bool descending,
@@ -29,3 +29,107 @@ GenerateBitReverseTable() noexcept
 }
 
 const BitReverseTable bit_reverse_table = GenerateBitReverseTable();
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void
+BitReverseScalar(uint8_t *data, std::size_t size) noexcept
+{
+	for (uint8_t *const end = data + size; data != end; ++data)
+		*data = bit_reverse(*data);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+/**
+ * Reverse each nibble with a 16 entry table lookup and swap the
+ * nibbles.
+ */
+__attribute__((target("ssse3")))
+static void
+BitReverseSSSE3(uint8_t *data, std::size_t size) noexcept
+{
+	const __m128i table = _mm_setr_epi8(0x0, 0x8, 0x4, 0xc,
+					    0x2, 0xa, 0x6, 0xe,
+					    0x1, 0x9, 0x5, 0xd,
+					    0x3, 0xb, 0x7, 0xf);
+	const __m128i mask = _mm_set1_epi8(0x0f);
+
+	for (; size >= 16; data += 16, size -= 16) {
+		const __m128i in = _mm_loadu_si128((const __m128i *)data);
+		const __m128i lo = _mm_and_si128(in, mask);
+		const __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), mask);
+		const __m128i out =
+			_mm_or_si128(_mm_slli_epi16(_mm_shuffle_epi8(table, lo), 4),
+				     _mm_shuffle_epi8(table, hi));
+		_mm_storeu_si128((__m128i *)data, out);
+	}
+
+	BitReverseScalar(data, size);
+}
+
+using BitReverseFunction = void (*)(uint8_t *data, std::size_t size) noexcept;
+
+static BitReverseFunction
+SelectBitReverse() noexcept
+{
+	if (__builtin_cpu_supports("ssse3"))
+		return BitReverseSSSE3;
+
+	return BitReverseScalar;
+}
+
+void
+BitReverse(uint8_t *data, std::size_t size) noexcept
+{
+	static const BitReverseFunction function = SelectBitReverse();
+	function(data, size);
+}
+
+#elif defined(__ARM_NEON)
+
+void
+BitReverse(uint8_t *data, std::size_t size) noexcept
+{
+#ifndef __aarch64__
+	/* ARMv7 NEON has no VRBIT: reverse each nibble with a table
+	   lookup and swap the nibbles */
+	static constexpr uint8_t table_data[16] = {
+		0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
+		0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf,
+	};
+	const uint8x8x2_t table{{vld1_u8(table_data), vld1_u8(table_data + 8)}};
+	const uint8x8_t mask = vdup_n_u8(0x0f);
+#endif
+
+	for (; size >= 16; data += 16, size -= 16) {
+		const uint8x16_t in = vld1q_u8(data);
+#ifdef __aarch64__
+		vst1q_u8(data, vrbitq_u8(in));
+#else
+		const auto Reverse8 = [&table, mask](uint8x8_t x){
+			return vorr_u8(vshl_n_u8(vtbl2_u8(table, vand_u8(x, mask)), 4),
+				       vtbl2_u8(table, vshr_n_u8(x, 4)));
+		};
+
+		vst1q_u8(data, vcombine_u8(Reverse8(vget_low_u8(in)),
+					   Reverse8(vget_high_u8(in))));
+#endif
+	}
+
+	BitReverseScalar(data, size);
+}
+
+#else
+
+void
+BitReverse(uint8_t *data, std::size_t size) noexcept
+{
+	BitReverseScalar(data, size);
+}
+
+#endif
@@ -20,6 +20,7 @@
 #ifndef MPD_BIT_REVERSE_HXX
 #define MPD_BIT_REVERSE_HXX
 
+#include <cstddef>
 #include <cstdint>
 
 /**
@@ -48,4 +49,18 @@ bit_reverse(uint8_t x) noexcept
 	return bit_reverse_table.data[x];
 }
 
+/**
+ * Reverse the bit order of each byte in the buffer, e.g. to convert
+ * LSB-first DSD data to MSB-first.  Uses SSSE3 or NEON if available.
+ */
+void
+BitReverse(uint8_t *data, std::size_t size) noexcept;
+
+/**
+ * Like BitReverse(), but always use the portable implementation.
+ * This is used by the unit tests.
+ */
+void
+BitReverseScalar(uint8_t *data, std::size_t size) noexcept;
+
 #endif
@@ -23,14 +23,22 @@
 #include "HugeAllocator.hxx"
 #include "Compiler.h"
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <new>
+#include <thread>
 #include <utility>
 
 /**
  * This class pre-allocates a certain number of objects, and allows
  * callers to allocate and free these objects ("slices").
+ *
+ * The free list is lock-free: Free() may be called from any thread
+ * at any time, concurrently with Allocate().  Allocate() however
+ * must not be called by two threads at the same time; this
+ * restriction keeps the free list safe from the ABA problem without
+ * tagged pointers.
  */
 template<typename T>
 class SliceBuffer {
@@ -40,24 +48,35 @@ class SliceBuffer {
 		T value;
 	};
 
+	/**
+	 * A special value for #n_allocated: the memory is being
+	 * discarded, and Allocate() has to wait.
+	 */
+	static constexpr unsigned DISCARDING = 1U << 31;
+
 	HugeArray<Slice> buffer;
 
 	/**
 	 * The number of slices that are initialized.  This is used to
 	 * avoid page faulting on the new allocation, so the kernel
 	 * does not need to reserve physical memory pages.
+	 *
+	 * This is only accessed by Allocate() and by
+	 * TryDiscardMemory(), which never run at the same time.
 	 */
 	unsigned n_initialized = 0;
 
 	/**
-	 * The number of slices currently allocated.
+	 * The number of slices currently allocated, or #DISCARDING.
+	 * Allocate() increments it before touching #n_initialized,
+	 * which keeps TryDiscardMemory() away.
 	 */
-	unsigned n_allocated = 0;
+	std::atomic_uint n_allocated{0};
 
 	/**
 	 * Pointer to the first free element in the chain.
 	 */
-	Slice *available = nullptr;
+	std::atomic<Slice *> available{nullptr};
 
 public:
 	SliceBuffer(unsigned _count)
@@ -79,50 +98,43 @@ public:
 	}
 
 	bool empty() const noexcept {
-		return n_allocated == 0;
+		return n_allocated.load(std::memory_order_relaxed) == 0;
 	}
 
 	bool IsFull() const noexcept {
-		return n_allocated == buffer.size();
-	}
-
-	void DiscardMemory() noexcept {
-		assert(empty());
-
-		n_initialized = 0;
-		buffer.Discard();
-		available = nullptr;
+		return n_allocated.load(std::memory_order_relaxed) == buffer.size();
 	}
 
 	template<typename... Args>
 	T *Allocate(Args&&... args) {
+		/* announce the allocation, waiting for a
+		   TryDiscardMemory() call in another thread to
+		   finish */
+		while (n_allocated.fetch_add(1, std::memory_order_acq_rel) >= DISCARDING) {
+			n_allocated.fetch_sub(1, std::memory_order_relaxed);
+			while (n_allocated.load(std::memory_order_acquire) >= DISCARDING)
+				std::this_thread::yield();
+		}
+
 		assert(n_initialized <= buffer.size());
-		assert(n_allocated <= n_initialized);
 
-		if (available == nullptr) {
+		Slice *slice = Pop();
+		if (slice == nullptr) {
 			if (n_initialized == buffer.size()) {
 				/* out of (internal) memory, buffer is full */
-				assert(n_allocated == buffer.size());
+				n_allocated.fetch_sub(1, std::memory_order_relaxed);
 				return nullptr;
 			}
 
-			available = &buffer[n_initialized++];
-			available->next = nullptr;
+			slice = &buffer[n_initialized++];
 		}
 
-		/* allocate a slice */
-		T *value = &available->value;
-		available = available->next;
-		++n_allocated;
-
 		/* construct the object */
-		return ::new((void *)value) T(std::forward<Args>(args)...);
+		return ::new((void *)&slice->value) T(std::forward<Args>(args)...);
 	}
 
 	void Free(T *value) noexcept {
-		assert(n_initialized <= buffer.size());
 		assert(n_allocated > 0);
-		assert(n_allocated <= n_initialized);
 
 		Slice *slice = reinterpret_cast<Slice *>(value);
 		assert(slice >= &buffer.front() && slice <= &buffer.back());
@@ -131,15 +143,52 @@ public:
 		value->~T();
 
 		/* insert the slice in the "available" linked list */
-		slice->next = available;
-		available = slice;
-		--n_allocated;
+		Push(slice);
 
 		/* give memory back to the kernel when the last slice
 		   was freed */
-		if (n_allocated == 0) {
-			DiscardMemory();
-		}
+		if (n_allocated.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			TryDiscardMemory();
+	}
+
+private:
+	/**
+	 * Remove the first slice from the free list.  Only called by
+	 * Allocate().
+	 */
+	Slice *Pop() noexcept {
+		Slice *slice = available.load(std::memory_order_acquire);
+		while (slice != nullptr &&
+		       !available.compare_exchange_weak(slice, slice->next,
+							std::memory_order_acquire))
+			;
+		return slice;
+	}
+
+	void Push(Slice *slice) noexcept {
+		Slice *next = available.load(std::memory_order_relaxed);
+		do {
+			slice->next = next;
+		} while (!available.compare_exchange_weak(next, slice,
+							  std::memory_order_release,
+							  std::memory_order_relaxed));
+	}
+
+	/**
+	 * Discard all memory if no slice is allocated (and no
+	 * Allocate() call is in progress).
+	 */
+	void TryDiscardMemory() noexcept {
+		unsigned expected = 0;
+		if (!n_allocated.compare_exchange_strong(expected, DISCARDING,
+							 std::memory_order_acquire))
+			return;
+
+		n_initialized = 0;
+		buffer.Discard();
+		available.store(nullptr, std::memory_order_relaxed);
+
+		n_allocated.store(0, std::memory_order_release);
 	}
 };
 
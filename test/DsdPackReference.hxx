@@ -0,0 +1,135 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The straightforward DSD export implementation: build each sample
+ * byte by byte, then run the shift8/pack24/reverse_endian passes of
+ * PcmExport over the result.  #DsdPack must produce the same output.
+ */
+
+#ifndef MPD_TEST_DSD_PACK_REFERENCE_HXX
+#define MPD_TEST_DSD_PACK_REFERENCE_HXX
+
+#include "pcm/DsdPack.hxx"
+#include "pcm/Pack.hxx"
+#include "util/ByteReverse.hxx"
+
+#include <cstdint>
+
+static inline void
+ReferenceDsd8To16(uint16_t *dest, const uint8_t *src,
+		  size_t n_blocks, unsigned channels) noexcept
+{
+	for (size_t i = 0; i < n_blocks; ++i, src += 2 * channels)
+		for (unsigned c = 0; c < channels; ++c)
+			*dest++ = uint16_t(src[c + channels]) |
+				(uint16_t(src[c]) << 8);
+}
+
+static inline void
+ReferenceDsd8To32(uint32_t *dest, const uint8_t *src,
+		  size_t n_blocks, unsigned channels) noexcept
+{
+	for (size_t i = 0; i < n_blocks; ++i, src += 4 * channels)
+		for (unsigned c = 0; c < channels; ++c)
+			*dest++ = uint32_t(src[c + 3 * channels]) |
+				(uint32_t(src[c + 2 * channels]) << 8) |
+				(uint32_t(src[c + channels]) << 16) |
+				(uint32_t(src[c]) << 24);
+}
+
+static inline void
+ReferenceDsdToDop(uint32_t *dest, const uint8_t *src,
+		  size_t n_blocks, unsigned channels) noexcept
+{
+	for (size_t i = 0; i < n_blocks; ++i, src += 4 * channels) {
+		for (unsigned c = 0; c < channels; ++c)
+			*dest++ = 0xff050000 | (src[c] << 8) |
+				src[c + channels];
+		for (unsigned c = 0; c < channels; ++c)
+			*dest++ = 0xfffa0000 | (src[c + 2 * channels] << 8) |
+				src[c + 3 * channels];
+	}
+}
+
+/**
+ * @param scratch a buffer for intermediate samples; it must hold
+ * 4 * n_blocks * channels elements
+ * @param dest the destination buffer; it must hold
+ * n_blocks * DsdPack::GetOutputBlockSize() bytes
+ */
+static inline void
+ReferenceDsdPack(DsdPack::Format format, unsigned channels,
+		 DsdPack::Options options,
+		 const uint8_t *src, size_t n_blocks,
+		 uint32_t *scratch, uint8_t *dest) noexcept
+{
+	if (n_blocks == 0)
+		return;
+
+	const bool post = options.shift8 || options.pack24 ||
+		options.reverse_endian;
+
+	/* the first pass builds native samples; like PcmExport,
+	   each further pass writes to another buffer */
+	void *words = post ? (void *)scratch : (void *)dest;
+	uint32_t *const buffer2 = scratch + 2 * n_blocks * channels;
+
+	size_t n_samples = n_blocks * channels, sample_size = 4;
+
+	switch (format) {
+	case DsdPack::Format::U16:
+		ReferenceDsd8To16((uint16_t *)words, src, n_blocks, channels);
+		sample_size = 2;
+		break;
+
+	case DsdPack::Format::U32:
+		ReferenceDsd8To32((uint32_t *)words, src, n_blocks, channels);
+		break;
+
+	case DsdPack::Format::DOP:
+		ReferenceDsdToDop((uint32_t *)words, src, n_blocks, channels);
+		n_samples *= 2;
+		break;
+	}
+
+	if (!post)
+		return;
+
+	const auto *p = (const uint8_t *)words;
+
+	if (options.pack24) {
+		auto *out = options.reverse_endian ? (uint8_t *)buffer2 : dest;
+		pcm_pack_24(out, (const int32_t *)words,
+			    (const int32_t *)words + n_samples);
+		p = out;
+		sample_size = 3;
+	} else if (options.shift8) {
+		auto *out = options.reverse_endian ? buffer2 : (uint32_t *)dest;
+		for (size_t i = 0; i < n_samples; ++i)
+			out[i] = ((const uint32_t *)words)[i] << 8;
+		p = (const uint8_t *)out;
+	}
+
+	if (options.reverse_endian)
+		reverse_bytes(dest, p, p + n_samples * sample_size,
+			      sample_size);
+}
+
+#endif
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MakeTag.hxx"
+#include "db/plugins/simple/DatabaseBinary.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "db/PlaylistInfo.hxx"
+#include "io/BufferedOutputStream.hxx"
+#include "io/OutputStream.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+class StringOutputStream final : public OutputStream {
+public:
+	std::string value;
+
+	void Write(const void *data, std::size_t size) override {
+		value.append((const char *)data, size);
+	}
+};
+
+static std::unique_ptr<Directory>
+MakeDatabase()
+{
+	std::unique_ptr<Directory> root(Directory::NewRoot());
+
+	const ScopeDatabaseLock protect;
+
+	Directory *a = root->MakeChild("a");
+	a->mtime = std::chrono::system_clock::from_time_t(1000000);
+
+	auto song = std::make_unique<Song>("x.flac", *a);
+	song->tag = MakeTag(TAG_ARTIST, "Foo", TAG_TITLE, "Bar",
+			    TAG_TRACK, "3");
+	song->mtime = std::chrono::system_clock::from_time_t(1234567);
+	song->audio_format = AudioFormat(44100, SampleFormat::S24_P32, 2);
+	a->AddSong(std::move(song));
+
+	song = std::make_unique<Song>("y.cue/track001", *a);
+	song->target = "y.flac";
+	song->start_time = SongTime::FromMS(1000);
+	song->end_time = SongTime::FromMS(61000);
+	song->tag = MakeTag(TAG_ARTIST, "Foo", TAG_TITLE, "Baz");
+	a->AddSong(std::move(song));
+
+	root->MakeChild("a")->MakeChild("b");
+
+	PlaylistInfo playlist("list.m3u");
+	playlist.mtime = std::chrono::system_clock::from_time_t(2000000);
+	a->playlists.push_back(std::move(playlist));
+
+	return root;
+}
+
+static std::string
+Save(const Directory &root)
+{
+	StringOutputStream sos;
+	BufferedOutputStream bos(sos);
+	db_save_binary(bos, root);
+	bos.Flush();
+	return std::move(sos.value);
+}
+
+static ConstBuffer<void>
+ToBuffer(const std::string &s, std::size_t size) noexcept
+{
+	return {s.data(), size};
+}
+
+static std::unique_ptr<Directory>
+Load(ConstBuffer<void> data)
+{
+	std::unique_ptr<Directory> root(Directory::NewRoot());
+	db_load_binary(data, *root);
+	return root;
+}
+
+TEST(DatabaseBinary, RoundTrip)
+{
+	const auto saved = Save(*MakeDatabase());
+	const auto data = ToBuffer(saved, saved.size());
+	ASSERT_TRUE(db_is_binary(data));
+
+	const auto root = Load(data);
+
+	const ScopeDatabaseLock protect;
+
+	const Directory *a = root->FindChild("a");
+	ASSERT_NE(a, nullptr);
+	EXPECT_EQ(a->mtime, std::chrono::system_clock::from_time_t(1000000));
+	EXPECT_NE(a->FindChild("b"), nullptr);
+
+	const Song *x = a->FindSong("x.flac");
+	ASSERT_NE(x, nullptr);
+	EXPECT_STREQ(x->tag.GetValue(TAG_ARTIST), "Foo");
+	EXPECT_STREQ(x->tag.GetValue(TAG_TITLE), "Bar");
+	EXPECT_STREQ(x->tag.GetValue(TAG_TRACK), "3");
+	EXPECT_EQ(x->mtime, std::chrono::system_clock::from_time_t(1234567));
+	EXPECT_EQ(x->audio_format, AudioFormat(44100, SampleFormat::S24_P32, 2));
+	EXPECT_TRUE(x->target.empty());
+
+	const Song *y = a->FindSong("y.cue/track001");
+	ASSERT_NE(y, nullptr);
+	EXPECT_EQ(y->target, "y.flac");
+	EXPECT_EQ(y->start_time, SongTime::FromMS(1000));
+	EXPECT_EQ(y->end_time, SongTime::FromMS(61000));
+	EXPECT_STREQ(y->tag.GetValue(TAG_TITLE), "Baz");
+	EXPECT_FALSE(y->audio_format.IsDefined());
+
+	ASSERT_FALSE(a->playlists.empty());
+	EXPECT_EQ(a->playlists.begin()->name, "list.m3u");
+	EXPECT_EQ(std::next(a->playlists.begin()), a->playlists.end());
+
+	/* saving the loaded database gives the same file */
+	EXPECT_EQ(Save(*root), saved);
+}
+
+TEST(DatabaseBinary, InvalidSampleFormat)
+{
+	auto root = MakeDatabase();
+
+	{
+		const ScopeDatabaseLock protect;
+		root->FindChild("a")->FindSong("x.flac")->audio_format.format =
+			SampleFormat(0xc0);
+	}
+
+	const auto saved = Save(*root);
+	const auto loaded = Load(ToBuffer(saved, saved.size()));
+
+	const ScopeDatabaseLock protect;
+	const Song *x = loaded->FindChild("a")->FindSong("x.flac");
+	ASSERT_NE(x, nullptr);
+	EXPECT_EQ(x->audio_format.format, SampleFormat::UNDEFINED);
+	EXPECT_EQ(x->audio_format.sample_rate, 44100U);
+}
+
+TEST(DatabaseBinary, Truncated)
+{
+	const auto saved = Save(*MakeDatabase());
+
+	for (std::size_t size = 0; size < saved.size(); ++size) {
+		const auto data = ToBuffer(saved, size);
+		if (db_is_binary(data)) {
+			EXPECT_THROW(Load(data), std::runtime_error)
+				<< "size=" << size;
+		}
+	}
+}
+
+TEST(DatabaseBinary, CorruptedHeader)
+{
+	const auto saved = Save(*MakeDatabase());
+
+	/* every header field is an offset, a count or a version;
+	   overwriting any of its bytes must not crash, and must be
+	   detected if it breaks a reference */
+	for (std::size_t i = 0; i < 136 && i < saved.size(); ++i) {
+		for (const char value : {'\0', '\x7f', '\xff'}) {
+			std::string corrupted = saved;
+			corrupted[i] = value;
+
+			try {
+				Load(ToBuffer(corrupted, corrupted.size()));
+			} catch (const std::runtime_error &) {
+			}
+		}
+	}
+}
+
+TEST(DatabaseBinary, CorruptedBody)
+{
+	const auto saved = Save(*MakeDatabase());
+
+	/* corrupt each byte of the sections; references between the
+	   records must be checked, so this must never crash */
+	for (std::size_t i = 136; i < saved.size(); ++i) {
+		std::string corrupted = saved;
+		corrupted[i] = '\xff';
+
+		try {
+			Load(ToBuffer(corrupted, corrupted.size()));
+		} catch (const std::runtime_error &) {
+		}
+	}
+}
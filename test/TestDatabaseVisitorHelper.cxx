@@ -0,0 +1,188 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MakeTag.hxx"
+#include "db/VHelper.hxx"
+#include "song/LightSong.hxx"
+#include "song/Filter.hxx"
+#include "tag/Sort.hxx"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestSong {
+	std::string uri;
+	Tag tag;
+	std::chrono::system_clock::time_point mtime;
+};
+
+/**
+ * Pass all songs through a #DatabaseVisitorHelper and return the
+ * URIs it reports.
+ */
+std::vector<std::string>
+Visit(const std::vector<TestSong> &songs, const DatabaseSelection &selection)
+{
+	std::vector<std::string> result;
+	VisitSong visit_song = [&result](const LightSong &song){
+		result.emplace_back(song.uri);
+	};
+
+	DatabaseVisitorHelper helper(selection, visit_song);
+	for (const auto &i : songs) {
+		LightSong song(i.uri.c_str(), i.tag);
+		song.mtime = i.mtime;
+		visit_song(song);
+	}
+	helper.Commit();
+
+	return result;
+}
+
+/**
+ * The reference implementation: a stable sort of all songs, then cut
+ * out the window.
+ */
+std::vector<std::string>
+SortAll(const std::vector<TestSong> &songs, const DatabaseSelection &selection)
+{
+	std::vector<const TestSong *> sorted;
+	for (const auto &i : songs)
+		sorted.push_back(&i);
+
+	std::stable_sort(sorted.begin(), sorted.end(),
+			 [&selection](const TestSong *a, const TestSong *b){
+				 if (selection.sort == TagType(SORT_TAG_LAST_MODIFIED))
+					 return selection.descending
+						 ? a->mtime > b->mtime
+						 : a->mtime < b->mtime;
+
+				 return CompareTags(selection.sort,
+						    selection.descending,
+						    a->tag, b->tag);
+			 });
+
+	std::vector<std::string> result;
+	for (unsigned i = selection.window.start;
+	     i < selection.window.end && i < sorted.size(); ++i)
+		result.emplace_back(sorted[i]->uri);
+	return result;
+}
+
+DatabaseSelection
+MakeSelection(TagType sort, bool descending, RangeArg window) noexcept
+{
+	DatabaseSelection selection("", true);
+	selection.sort = sort;
+	selection.descending = descending;
+	selection.window = window;
+	return selection;
+}
+
+} // namespace
+
+TEST(DatabaseVisitorHelper, Window)
+{
+	std::vector<TestSong> songs;
+	for (unsigned i = 0; i < 10; ++i)
+		songs.push_back({"s" + std::to_string(i),
+				 MakeTag(TAG_TRACK,
+					 std::to_string(10 - i).c_str()),
+				 {}});
+
+	/* window smaller than the number of songs */
+	EXPECT_EQ(Visit(songs, MakeSelection(TAG_TRACK, false, {2, 5})),
+		  (std::vector<std::string>{"s7", "s6", "s5"}));
+	EXPECT_EQ(Visit(songs, MakeSelection(TAG_TRACK, true, {0, 3})),
+		  (std::vector<std::string>{"s0", "s1", "s2"}));
+
+	/* window beyond the end */
+	EXPECT_EQ(Visit(songs, MakeSelection(TAG_TRACK, false, {8, 20})),
+		  (std::vector<std::string>{"s1", "s0"}));
+	EXPECT_TRUE(Visit(songs, MakeSelection(TAG_TRACK, false, {20, 30})).empty());
+
+	/* no window */
+	EXPECT_EQ(Visit(songs, MakeSelection(TAG_TRACK, false, RangeArg::All())),
+		  SortAll(songs, MakeSelection(TAG_TRACK, false, RangeArg::All())));
+}
+
+TEST(DatabaseVisitorHelper, Stable)
+{
+	/* songs with equal keys keep their order, even if the window
+	   cuts through them */
+	std::vector<TestSong> songs;
+	for (unsigned i = 0; i < 10; ++i)
+		songs.push_back({"s" + std::to_string(i),
+				 MakeTag(TAG_ARTIST, i % 2 ? "b" : "a"),
+				 {}});
+
+	EXPECT_EQ(Visit(songs, MakeSelection(TAG_ARTIST, false, {3, 7})),
+		  (std::vector<std::string>{"s6", "s8", "s1", "s3"}));
+	EXPECT_EQ(Visit(songs, MakeSelection(TAG_ARTIST, true, {3, 7})),
+		  (std::vector<std::string>{"s7", "s9", "s0", "s2"}));
+}
+
+/**
+ * Compare the windowed (top-k) sort with a full sort on random input.
+ */
+TEST(DatabaseVisitorHelper, MatchesFullSort)
+{
+	std::mt19937 rng(42);
+
+	for (unsigned round = 0; round < 50; ++round) {
+		std::vector<TestSong> songs;
+		const unsigned n = rng() % 200;
+		for (unsigned i = 0; i < n; ++i) {
+			TagBuilder tag;
+			if (rng() % 4)
+				tag.AddItem(TAG_ARTIST,
+					    ("a" + std::to_string(rng() % 20)).c_str());
+			if (rng() % 4)
+				tag.AddItem(TAG_TRACK,
+					    std::to_string(rng() % 15).c_str());
+			if (rng() % 3 == 0)
+				tag.AddItem(TAG_ALBUM_ARTIST,
+					    ("b" + std::to_string(rng() % 5)).c_str());
+
+			songs.push_back({"s" + std::to_string(i), tag.Commit(),
+					 std::chrono::system_clock::time_point(std::chrono::seconds(rng() % 30))});
+		}
+
+		for (const TagType sort : {TAG_ARTIST, TAG_TRACK, TAG_ALBUM_ARTIST,
+					   TagType(SORT_TAG_LAST_MODIFIED)}) {
+			for (const bool descending : {false, true}) {
+				const unsigned start = rng() % 4 == 0 ? 0 : rng() % (n + 5);
+				const unsigned end = rng() % 3 == 0
+					? RangeArg::All().end
+					: start + rng() % 60;
+
+				const auto selection =
+					MakeSelection(sort, descending, {start, end});
+				EXPECT_EQ(Visit(songs, selection),
+					  SortAll(songs, selection));
+			}
+		}
+	}
+}
@@ -0,0 +1,286 @@
+/*
+ * Stress tests for the lock-free MusicBuffer and MusicPipe.
+ */
+
+#include "MusicBuffer.hxx"
+#include "MusicChunk.hxx"
+#include "MusicPipe.hxx"
+#include "pcm/AudioFormat.hxx"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <string.h>
+
+static constexpr AudioFormat audio_format{44100, SampleFormat::S16, 2};
+
+static constexpr size_t chunk_sizes[] = {
+	CHUNK_SIZE, 4 * CHUNK_SIZE, MAX_CHUNK_SIZE,
+};
+
+/**
+ * Allocate a chunk (waiting for the consumers to return one if the
+ * buffer is full), fill it with a pattern derived from the sequence
+ * number and push it.
+ */
+static void
+PushChunk(MusicBuffer &buffer, MusicPipe &pipe,
+	  size_t chunk_size, uint32_t seq)
+{
+	MusicChunkPtr chunk;
+	while ((chunk = buffer.Allocate(chunk_size)) == nullptr)
+		std::this_thread::yield();
+
+	auto w = chunk->Write(audio_format, SongTime::zero(), 0);
+	ASSERT_GE(w.size, sizeof(seq));
+
+	auto *p = (uint8_t *)w.data;
+	memset(p, uint8_t(seq), w.size);
+	memcpy(p, &seq, sizeof(seq));
+	chunk->Expand(audio_format, w.size);
+
+	pipe.Push(std::move(chunk));
+}
+
+/**
+ * Check the sequence number and the pattern written by PushChunk().
+ */
+static bool
+CheckChunk(const MusicChunk &chunk, uint32_t seq) noexcept
+{
+	if (chunk.length < sizeof(seq))
+		return false;
+
+	uint32_t value;
+	memcpy(&value, chunk.data, sizeof(value));
+	if (value != seq)
+		return false;
+
+	for (size_t i = sizeof(seq); i < chunk.length; ++i)
+		if (chunk.data[i] != uint8_t(seq))
+			return false;
+
+	return true;
+}
+
+static uint32_t
+GetSequence(const MusicChunk &chunk) noexcept
+{
+	uint32_t value;
+	memcpy(&value, chunk.data, sizeof(value));
+	return value;
+}
+
+/**
+ * One producer (the "decoder"), many readers walking the pipe (the
+ * "outputs") and one consumer which shifts chunks once all readers
+ * have moved past them (the "player"), like #MultipleOutputs does.
+ */
+TEST(MusicPipe, ManyOutputs)
+{
+	constexpr uint32_t N_CHUNKS = 20000;
+	constexpr unsigned N_OUTPUTS = 8;
+
+	MusicBuffer buffer(512);
+	MusicPipe pipe;
+
+	/* for each output: the sequence number of the chunk it is
+	   currently reading; chunks before that one are not
+	   referenced anymore */
+	std::atomic<uint32_t> positions[N_OUTPUTS];
+	for (auto &i : positions)
+		i.store(0);
+
+	std::atomic_bool failed{false};
+
+	std::thread producer([&]{
+		std::minstd_rand rng(42);
+		for (uint32_t seq = 0; seq < N_CHUNKS; ++seq)
+			PushChunk(buffer, pipe,
+				  chunk_sizes[rng() % std::size(chunk_sizes)],
+				  seq);
+	});
+
+	std::vector<std::thread> outputs;
+	for (unsigned o = 0; o < N_OUTPUTS; ++o) {
+		outputs.emplace_back([&, o]{
+			const MusicChunk *chunk = nullptr;
+			uint32_t seq = 0;
+			while (seq < N_CHUNKS) {
+				const MusicChunk *next = chunk == nullptr
+					? pipe.Peek()
+					: chunk->GetNext();
+				if (next == nullptr) {
+					std::this_thread::yield();
+					continue;
+				}
+
+				chunk = next;
+				if (!CheckChunk(*chunk, seq))
+					failed = true;
+
+				positions[o].store(seq, std::memory_order_release);
+				++seq;
+			}
+
+			/* done with all chunks */
+			positions[o].store(N_CHUNKS, std::memory_order_release);
+		});
+	}
+
+	uint32_t shifted = 0;
+	while (shifted < N_CHUNKS) {
+		const MusicChunk *chunk = pipe.Peek();
+		if (chunk == nullptr) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		EXPECT_GT(pipe.GetSize(), 0U);
+
+		const uint32_t seq = GetSequence(*chunk);
+		ASSERT_EQ(seq, shifted);
+
+		bool consumed = true;
+		for (const auto &i : positions)
+			if (i.load(std::memory_order_acquire) <= seq)
+				consumed = false;
+
+		if (!consumed) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		auto shifted_chunk = pipe.Shift();
+		ASSERT_EQ(shifted_chunk.get(), chunk);
+		++shifted;
+	}
+
+	producer.join();
+	for (auto &i : outputs)
+		i.join();
+
+	EXPECT_FALSE(failed);
+	EXPECT_TRUE(pipe.IsEmpty());
+	EXPECT_EQ(pipe.Peek(), nullptr);
+	EXPECT_TRUE(buffer.IsEmptyUnsafe());
+}
+
+/**
+ * One producer feeding many pipes, each drained by its own thread,
+ * so chunks get returned to the #MusicBuffer from many threads while
+ * the producer allocates, and Shift() often races with Push() at the
+ * tail.
+ */
+TEST(MusicPipe, ManyConsumers)
+{
+	constexpr uint32_t N_CHUNKS = 20000;
+	constexpr unsigned N_PIPES = 6;
+
+	MusicBuffer buffer(256);
+	std::unique_ptr<MusicPipe> pipes[N_PIPES];
+	for (auto &i : pipes)
+		i = std::make_unique<MusicPipe>();
+
+	std::atomic_bool failed{false};
+
+	std::vector<std::thread> consumers;
+	for (unsigned c = 0; c < N_PIPES; ++c) {
+		consumers.emplace_back([&, c]{
+			auto &pipe = *pipes[c];
+			for (uint32_t seq = c; seq < N_CHUNKS; seq += N_PIPES) {
+				MusicChunkPtr chunk;
+				while ((chunk = pipe.Shift()) == nullptr)
+					std::this_thread::yield();
+
+				if (!CheckChunk(*chunk, seq))
+					failed = true;
+			}
+		});
+	}
+
+	std::minstd_rand rng(7);
+	for (uint32_t seq = 0; seq < N_CHUNKS; ++seq)
+		PushChunk(buffer, *pipes[seq % N_PIPES],
+			  chunk_sizes[rng() % std::size(chunk_sizes)], seq);
+
+	for (auto &i : consumers)
+		i.join();
+
+	EXPECT_FALSE(failed);
+
+	for (const auto &i : pipes)
+		EXPECT_TRUE(i->IsEmpty());
+
+	EXPECT_TRUE(buffer.IsEmptyUnsafe());
+}
+
+/**
+ * One producer and one consumer which polls IsEmpty() before
+ * shifting, like the player thread does: a non-empty pipe must
+ * always yield a chunk, even while a Push() is still linking it.
+ */
+TEST(MusicPipe, ShiftWhenNotEmpty)
+{
+	constexpr uint32_t N_CHUNKS = 100000;
+
+	MusicBuffer buffer(8);
+	MusicPipe pipe;
+
+	std::thread producer([&]{
+		for (uint32_t seq = 0; seq < N_CHUNKS; ++seq)
+			PushChunk(buffer, pipe, CHUNK_SIZE, seq);
+	});
+
+	unsigned null_chunks = 0, bad_chunks = 0;
+	for (uint32_t seq = 0; seq < N_CHUNKS;) {
+		if (pipe.IsEmpty()) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		auto chunk = pipe.Shift();
+		if (chunk == nullptr) {
+			++null_chunks;
+			std::this_thread::yield();
+			continue;
+		}
+
+		if (!CheckChunk(*chunk, seq))
+			++bad_chunks;
+		++seq;
+	}
+
+	producer.join();
+
+	EXPECT_EQ(null_chunks, 0U);
+	EXPECT_EQ(bad_chunks, 0U);
+	EXPECT_TRUE(pipe.IsEmpty());
+	EXPECT_EQ(pipe.Peek(), nullptr);
+	EXPECT_TRUE(buffer.IsEmptyUnsafe());
+}
+
+TEST(MusicBuffer, Budget)
+{
+	MusicBuffer buffer(64);
+
+	std::vector<MusicChunkPtr> chunks;
+	chunks.emplace_back(buffer.Allocate(MAX_CHUNK_SIZE));
+	ASSERT_NE(chunks.back(), nullptr);
+
+	/* the large chunk takes 16 small ones */
+	while (auto chunk = buffer.Allocate(CHUNK_SIZE))
+		chunks.emplace_back(std::move(chunk));
+
+	EXPECT_EQ(chunks.size(), 1U + 64 - MAX_CHUNK_SIZE / CHUNK_SIZE);
+	EXPECT_TRUE(buffer.IsFull());
+
+	chunks.clear();
+	EXPECT_TRUE(buffer.IsEmptyUnsafe());
+	EXPECT_FALSE(buffer.IsFull(MAX_CHUNK_SIZE));
+}
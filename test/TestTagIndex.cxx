@@ -0,0 +1,224 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MakeTag.hxx"
+#include "db/plugins/simple/TagIndex.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "song/Filter.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class TagIndexTest : public ::testing::Test {
+protected:
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+	TagIndex index;
+
+	const ScopeDatabaseLock protect;
+
+	~TagIndexTest() noexcept override {
+		root->tag_index = nullptr;
+		index.Clear();
+	}
+
+	Song &AddSong(Directory &directory, const char *name, Tag &&tag,
+		      const char *target=nullptr) {
+		auto song = std::make_unique<Song>(name, directory);
+		song->tag = std::move(tag);
+		if (target != nullptr)
+			song->target = target;
+
+		auto &result = *song;
+		directory.AddSong(std::move(song));
+		return result;
+	}
+
+	std::vector<std::string> Lookup(const char *expression,
+					bool fold_case=false) {
+		SongFilter filter;
+		const char *args[] = {expression};
+		filter.Parse(ConstBuffer<const char *>(args, 1), fold_case);
+		filter.Optimize();
+
+		const auto songs = index.Lookup(filter);
+		EXPECT_TRUE(songs);
+		if (!songs)
+			return {};
+
+		std::vector<std::string> names;
+		for (const Song *song : *songs)
+			names.emplace_back(song->filename);
+		return names;
+	}
+
+	bool IsIndexable(const char *expression) {
+		SongFilter filter;
+		const char *args[] = {expression};
+		filter.Parse(ConstBuffer<const char *>(args, 1));
+		filter.Optimize();
+		return index.Lookup(filter).has_value();
+	}
+};
+
+using Names = std::vector<std::string>;
+
+TEST_F(TagIndexTest, Build)
+{
+	AddSong(*root, "a", MakeTag(TAG_ARTIST, "Foo", TAG_TITLE, "One"));
+	Directory &sub = *root->MakeChild("sub");
+	AddSong(sub, "b", MakeTag(TAG_ARTIST, "Bar", TAG_TITLE, "Two"));
+	AddSong(sub, "c", MakeTag(TAG_ARTIST, "Bar", TAG_ARTIST, "Foo"));
+
+	index.Build(*root);
+	EXPECT_EQ(index.GetSongCount(), 3U);
+
+	EXPECT_EQ(Lookup("(artist == 'Foo')"), (Names{"a", "c"}));
+	EXPECT_EQ(Lookup("(artist == 'Bar')"), (Names{"b", "c"}));
+	/* the index folds case, so these are candidates even for a
+	   case-sensitive filter; the caller applies the filter */
+	EXPECT_EQ(Lookup("(artist == 'foo')"), (Names{"a", "c"}));
+	EXPECT_EQ(Lookup("(artist == 'foo')", true), (Names{"a", "c"}));
+	EXPECT_EQ(Lookup("(artist == 'Fo')"), Names{});
+	EXPECT_EQ(Lookup("(title == 'Two')"), Names{"b"});
+	EXPECT_EQ(Lookup("(any == 'One')"), Names{"a"});
+	EXPECT_EQ(Lookup("((artist == 'Bar') AND (title == 'Two'))"),
+		  Names{"b"});
+}
+
+TEST_F(TagIndexTest, NotIndexable)
+{
+	index.Build(*root);
+
+	EXPECT_FALSE(IsIndexable("(artist != 'Foo')"));
+	EXPECT_FALSE(IsIndexable("(!(artist == 'Foo'))"));
+	EXPECT_FALSE(IsIndexable("(artist contains 'Foo')"));
+	EXPECT_FALSE(IsIndexable("(artist == '')"));
+	EXPECT_TRUE(IsIndexable("(artist starts_with 'Foo')"));
+}
+
+TEST_F(TagIndexTest, AddRemove)
+{
+	index.Build(*root);
+
+	/* Directory::AddSong() and Directory::RemoveSong() update
+	   the attached index */
+	AddSong(*root, "a", MakeTag(TAG_ARTIST, "Foo"));
+	Song &b = AddSong(*root, "b", MakeTag(TAG_ARTIST, "Foo"));
+	AddSong(*root, "c", MakeTag(TAG_ARTIST, "Foo"));
+	EXPECT_EQ(index.GetSongCount(), 3U);
+	EXPECT_EQ(Lookup("(artist == 'Foo')"), (Names{"a", "b", "c"}));
+
+	/* the removed song leaves a tombstone, which is skipped */
+	root->RemoveSong(&b);
+	EXPECT_EQ(index.GetSongCount(), 2U);
+	EXPECT_EQ(Lookup("(artist == 'Foo')"), (Names{"a", "c"}));
+
+	AddSong(*root, "d", MakeTag(TAG_ARTIST, "Foo"));
+	EXPECT_EQ(Lookup("(artist == 'Foo')"), (Names{"a", "c", "d"}));
+
+	/* a modified song gets a new id */
+	Song &a = *root->FindSong("a");
+	a.tag = MakeTag(TAG_ARTIST, "Bar");
+	root->ReindexSong(a);
+	EXPECT_EQ(index.GetSongCount(), 3U);
+	EXPECT_EQ(Lookup("(artist == 'Foo')"), (Names{"c", "d"}));
+	EXPECT_EQ(Lookup("(artist == 'Bar')"), Names{"a"});
+}
+
+TEST_F(TagIndexTest, Compact)
+{
+	index.Build(*root);
+
+	constexpr unsigned n = 3000;
+	for (unsigned i = 0; i < n; ++i)
+		AddSong(*root, std::to_string(i).c_str(),
+			MakeTag(TAG_ARTIST, i % 2 ? "Odd" : "Even",
+				TAG_TITLE, std::to_string(i).c_str()));
+
+	/* removing more than half of the songs purges the
+	   tombstones */
+	root->ForEachSongSafe([this](Song &song){
+		if (std::stoul(song.filename) % 3 != 0)
+			root->RemoveSong(&song);
+	});
+
+	EXPECT_EQ(index.GetSongCount(), n / 3);
+
+	/* the songs were renumbered when half of them had been
+	   removed */
+	for (const auto &song : root->songs)
+		EXPECT_LT(song.index_id, n / 2);
+
+	const auto odd = Lookup("(artist == 'Odd')");
+	EXPECT_EQ(odd.size(), n / 6);
+	for (const auto &name : odd)
+		EXPECT_EQ(std::stoul(name) % 6, 3U);
+
+	EXPECT_EQ(Lookup("(title == '1')"), Names{});
+	EXPECT_EQ(Lookup("(title == '3')"), Names{"3"});
+
+	AddSong(*root, "new", MakeTag(TAG_ARTIST, "Odd"));
+	EXPECT_EQ(Lookup("(artist == 'Odd')").back(), "new");
+}
+
+TEST_F(TagIndexTest, Prefix)
+{
+	AddSong(*root, "a", MakeTag(TAG_ARTIST, "Foo"));
+	AddSong(*root, "b", MakeTag(TAG_ARTIST, "Food"));
+	AddSong(*root, "c", MakeTag(TAG_ARTIST, "Bar"));
+	AddSong(*root, "d", MakeTag(TAG_ARTIST, "FOOBAR"));
+	index.Build(*root);
+
+	EXPECT_EQ(Lookup("(artist starts_with 'Foo')"),
+		  (Names{"a", "b", "d"}));
+	EXPECT_EQ(Lookup("(artist starts_with 'Food')"), Names{"b"});
+	EXPECT_EQ(Lookup("(artist starts_with 'foob')", true), Names{"d"});
+	EXPECT_EQ(Lookup("(artist starts_with 'Fox')"), Names{});
+	EXPECT_EQ(Lookup("(artist starts_with 'B')"), Names{"c"});
+}
+
+TEST_F(TagIndexTest, Target)
+{
+	index.Build(*root);
+
+	/* the CUE track is added before its target */
+	Directory &cue = *root->MakeChild("x.cue");
+	AddSong(cue, "track001", MakeTag(TAG_TITLE, "One"), "../x.flac");
+	EXPECT_EQ(Lookup("(artist == 'Foo')"), Names{});
+
+	Song &x = AddSong(*root, "x.flac", MakeTag(TAG_ARTIST, "Foo"));
+	EXPECT_EQ(Lookup("(artist == 'Foo')"), (Names{"track001", "x.flac"}));
+
+	/* the target is modified */
+	x.tag = MakeTag(TAG_ARTIST, "Bar");
+	root->ReindexSong(x);
+	EXPECT_EQ(Lookup("(artist == 'Foo')"), Names{});
+	EXPECT_EQ(Lookup("(artist == 'Bar')"), (Names{"track001", "x.flac"}));
+
+	/* the target is removed */
+	root->RemoveSong(&x);
+	EXPECT_EQ(Lookup("(artist == 'Bar')"), Names{});
+	EXPECT_EQ(Lookup("(title == 'One')"), Names{"track001"});
+}
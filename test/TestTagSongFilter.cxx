@@ -33,7 +33,9 @@ InvokeFilter(const TagSongFilter &f, const Tag &tag) noexcept
 TEST(TagSongFilter, Basic)
 {
 	const TagSongFilter f(TAG_TITLE,
-			      StringFilter("needle", false, false, false));
+			      StringFilter("needle", false,
+					   StringFilter::Position::FULL,
+					   false));
 
 	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_TITLE, "needle")));
 	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_TITLE, "foo", TAG_TITLE, "needle")));
@@ -54,7 +56,9 @@ TEST(TagSongFilter, Basic)
 TEST(TagSongFilter, Empty)
 {
 	const TagSongFilter f(TAG_TITLE,
-			      StringFilter("", false, false, false));
+			      StringFilter("", false,
+					   StringFilter::Position::FULL,
+					   false));
 
 	EXPECT_TRUE(InvokeFilter(f, MakeTag()));
 
@@ -65,7 +69,9 @@ TEST(TagSongFilter, Empty)
 TEST(TagSongFilter, Substring)
 {
 	const TagSongFilter f(TAG_TITLE,
-			      StringFilter("needle", false, true, false));
+			      StringFilter("needle", false,
+					   StringFilter::Position::ANYWHERE,
+					   false));
 
 	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_TITLE, "needle")));
 	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_TITLE, "needleBAR")));
@@ -76,10 +82,29 @@ TEST(TagSongFilter, Substring)
 	EXPECT_FALSE(InvokeFilter(f, MakeTag(TAG_TITLE, "eedle")));
 }
 
+TEST(TagSongFilter, Prefix)
+{
+	const TagSongFilter f(TAG_TITLE,
+			      StringFilter("needle", false,
+					   StringFilter::Position::PREFIX,
+					   false));
+
+	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_TITLE, "needle")));
+	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_TITLE, "needleBAR")));
+	EXPECT_FALSE(InvokeFilter(f, MakeTag(TAG_TITLE, "FOOneedle")));
+	EXPECT_FALSE(InvokeFilter(f, MakeTag(TAG_TITLE, "NEEDLE")));
+
+	EXPECT_FALSE(InvokeFilter(f, MakeTag()));
+	EXPECT_FALSE(InvokeFilter(f, MakeTag(TAG_TITLE, "nee")));
+	EXPECT_FALSE(InvokeFilter(f, MakeTag(TAG_ARTIST, "needle")));
+}
+
 TEST(TagSongFilter, Negated)
 {
 	const TagSongFilter f(TAG_TITLE,
-			      StringFilter("needle", false, false, true));
+			      StringFilter("needle", false,
+					   StringFilter::Position::FULL,
+					   true));
 
 	EXPECT_TRUE(InvokeFilter(f, MakeTag()));
 	EXPECT_FALSE(InvokeFilter(f, MakeTag(TAG_TITLE, "needle")));
@@ -92,7 +117,9 @@ TEST(TagSongFilter, Negated)
 TEST(TagSongFilter, EmptyNegated)
 {
 	const TagSongFilter f(TAG_TITLE,
-			      StringFilter("", false, false, true));
+			      StringFilter("", false,
+					   StringFilter::Position::FULL,
+					   true));
 
 	EXPECT_FALSE(InvokeFilter(f, MakeTag()));
 	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_TITLE, "foo")));
@@ -104,7 +131,9 @@ TEST(TagSongFilter, EmptyNegated)
 TEST(TagSongFilter, MultiNegated)
 {
 	const TagSongFilter f(TAG_TITLE,
-			      StringFilter("needle", false, false, true));
+			      StringFilter("needle", false,
+					   StringFilter::Position::FULL,
+					   true));
 
 	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_TITLE, "foo", TAG_TITLE, "bar")));
 	EXPECT_FALSE(InvokeFilter(f, MakeTag(TAG_TITLE, "needle", TAG_TITLE, "bar")));
@@ -118,7 +147,9 @@ TEST(TagSongFilter, MultiNegated)
 TEST(TagSongFilter, Fallback)
 {
 	const TagSongFilter f(TAG_ALBUM_ARTIST,
-			      StringFilter("needle", false, false, false));
+			      StringFilter("needle", false,
+					   StringFilter::Position::FULL,
+					   false));
 
 	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_ALBUM_ARTIST, "needle")));
 	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_ARTIST, "needle")));
@@ -138,7 +169,9 @@ TEST(TagSongFilter, Fallback)
 TEST(TagSongFilter, EmptyFallback)
 {
 	const TagSongFilter f(TAG_ALBUM_ARTIST,
-			      StringFilter("", false, false, false));
+			      StringFilter("", false,
+					   StringFilter::Position::FULL,
+					   false));
 
 	EXPECT_TRUE(InvokeFilter(f, MakeTag()));
 
@@ -152,7 +185,9 @@ TEST(TagSongFilter, EmptyFallback)
 TEST(TagSongFilter, NegatedFallback)
 {
 	const TagSongFilter f(TAG_ALBUM_ARTIST,
-			      StringFilter("needle", false, false, true));
+			      StringFilter("needle", false,
+					   StringFilter::Position::FULL,
+					   true));
 
 	EXPECT_TRUE(InvokeFilter(f, MakeTag()));
 	EXPECT_TRUE(InvokeFilter(f, MakeTag(TAG_ALBUM_ARTIST, "foo")));
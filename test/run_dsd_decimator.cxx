@@ -0,0 +1,202 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the CPU time needed to convert DSD to PCM,
+ * comparing the plain DSD to PCM conversion followed by the
+ * configured resampler with the half-band decimator.
+ *
+ */
+
+#include "ConfigGlue.hxx"
+#include "config/Data.hxx"
+#include "config/Option.hxx"
+#include "config/Param.hxx"
+#include "pcm/AudioFormat.hxx"
+#include "pcm/Convert.hxx"
+#include "fs/NarrowPath.hxx"
+#include "util/ConstBuffer.hxx"
+#include "util/OptionDef.hxx"
+#include "util/OptionParser.hxx"
+#include "util/PrintException.hxx"
+
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <stdexcept>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr unsigned CHANNELS = 2;
+
+/* the number of DSD bytes per channel fed to each Convert() call */
+static constexpr size_t CHUNK_SIZE = 4096;
+
+struct CommandLine {
+	FromNarrowPath config_path;
+
+	double seconds = 2;
+};
+
+enum Option {
+	OPTION_CONFIG,
+};
+
+static constexpr OptionDef option_defs[] = {
+	{"config", 0, true, "Load a MPD configuration file"},
+};
+
+static CommandLine
+ParseCommandLine(int argc, char **argv)
+{
+	CommandLine c;
+
+	OptionParser option_parser(option_defs, argc, argv);
+	while (auto o = option_parser.Next()) {
+		switch (Option(o.index)) {
+		case OPTION_CONFIG:
+			c.config_path = o.value;
+			break;
+		}
+	}
+
+	auto args = option_parser.GetRemaining();
+	if (args.size > 1)
+		throw std::runtime_error("Usage: run_dsd_decimator [--config FILE] [SECONDS]");
+
+	if (args.size == 1) {
+		c.seconds = strtod(args[0], nullptr);
+		if (c.seconds <= 0)
+			throw std::runtime_error("Invalid duration");
+	}
+
+	return c;
+}
+
+/**
+ * Generate interleaved DSD (MSB first) with a first-order
+ * sigma-delta modulator playing a 1 kHz sine wave.
+ */
+static std::vector<uint8_t>
+GenerateDsd(unsigned byte_rate, size_t n_frames)
+{
+	std::vector<uint8_t> dsd(n_frames * CHANNELS);
+
+	const double bit_rate = byte_rate * 8.0;
+	const double omega = 2 * M_PI * 1000 / bit_rate;
+
+	double integrator[CHANNELS]{};
+	uint64_t bit = 0;
+
+	for (size_t i = 0; i < n_frames; ++i) {
+		for (unsigned c = 0; c < CHANNELS; ++c) {
+			uint8_t byte = 0;
+			for (unsigned b = 0; b < 8; ++b) {
+				const double x =
+					0.5 * std::sin(omega * double(bit + b));
+				const bool one = integrator[c] >= 0;
+				integrator[c] += x - (one ? 1.0 : -1.0);
+				byte = (byte << 1) | one;
+			}
+
+			dsd[i * CHANNELS + c] = byte;
+		}
+
+		bit += 8;
+	}
+
+	return dsd;
+}
+
+static double
+Measure(const std::vector<uint8_t> &dsd, unsigned byte_rate,
+	unsigned dest_rate)
+{
+	const AudioFormat src_format(byte_rate, SampleFormat::DSD, CHANNELS);
+	const AudioFormat dest_format(dest_rate, SampleFormat::S24_P32,
+				      CHANNELS);
+
+	PcmConvert convert(src_format, dest_format);
+
+	const size_t chunk_bytes = CHUNK_SIZE * CHANNELS;
+
+	const std::clock_t start = std::clock();
+
+	for (size_t offset = 0; offset < dsd.size(); offset += chunk_bytes) {
+		const size_t size = std::min(chunk_bytes, dsd.size() - offset);
+		convert.Convert({dsd.data() + offset, size});
+	}
+
+	while (!convert.Flush().IsNull()) {}
+
+	return double(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void
+SetDecimation(ConfigData &config, bool value)
+{
+	auto &list = config.GetParamList(ConfigOption::DSD_DECIMATION);
+	list.clear();
+	config.AddParam(ConfigOption::DSD_DECIMATION,
+			ConfigParam(value ? "yes" : "no"));
+	pcm_convert_global_init(config);
+}
+
+int
+main(int argc, char **argv)
+try {
+	const auto c = ParseCommandLine(argc, argv);
+
+	auto config = AutoLoadConfigFile(c.config_path);
+
+	static constexpr unsigned dsd_multipliers[] = { 64, 128, 256, 512 };
+	static constexpr unsigned dest_rates[] = { 88200, 176400, 352800 };
+
+	printf("%-8s %8s %12s %12s %8s\n",
+	       "source", "target", "resampler", "decimator", "speedup");
+
+	for (const unsigned multiplier : dsd_multipliers) {
+		const unsigned byte_rate = 44100 * multiplier / 8;
+		const auto dsd = GenerateDsd(byte_rate,
+					     size_t(byte_rate * c.seconds));
+
+		for (const unsigned dest_rate : dest_rates) {
+			SetDecimation(config, false);
+			const double old_time =
+				Measure(dsd, byte_rate, dest_rate) / c.seconds;
+
+			SetDecimation(config, true);
+			const double new_time =
+				Measure(dsd, byte_rate, dest_rate) / c.seconds;
+
+			printf("DSD%-5u %8u %12.4f %12.4f %7.1fx\n",
+			       multiplier, dest_rate, old_time, new_time,
+			       new_time > 0 ? old_time / new_time : 0.);
+		}
+	}
+
+	printf("(CPU seconds per second of audio)\n");
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
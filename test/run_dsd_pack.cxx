@@ -0,0 +1,126 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the throughput of the DSD export layouts
+ * (DSD_U16, DSD_U32, DoP), comparing the byte-by-byte conversion plus
+ * separate shift8/pack24/reverse_endian passes with #DsdPack.
+ *
+ */
+
+#include "DsdPackReference.hxx"
+#include "pcm/DsdPack.hxx"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* the DSD512 byte rate of one channel */
+static constexpr double DSD512_RATE = 44100 * 512 / 8;
+
+/* the number of input bytes per call */
+static constexpr size_t CHUNK_SIZE = 65536;
+
+struct Layout {
+	const char *name;
+	DsdPack::Format format;
+	unsigned channels;
+	bool shift8, pack24, reverse_endian;
+};
+
+static constexpr Layout layouts[] = {
+	{ "DSD_U16_LE", DsdPack::Format::U16, 2, false, false, false },
+	{ "DSD_U32_BE", DsdPack::Format::U32, 2, false, false, true },
+	{ "DSD_U32_BE", DsdPack::Format::U32, 6, false, false, true },
+	{ "DoP S24_P32", DsdPack::Format::DOP, 2, false, false, false },
+	{ "DoP S32_LE", DsdPack::Format::DOP, 6, true, false, false },
+	{ "DoP S24_3BE", DsdPack::Format::DOP, 6, false, true, true },
+};
+
+template<typename F>
+static double
+Measure(size_t total, F &&f)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	for (size_t done = 0; done < total; done += CHUNK_SIZE)
+		f();
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int
+main(int argc, char **argv)
+{
+	/* the amount of DSD data per layout in MiB */
+	const size_t mib = argc > 1 ? strtoul(argv[1], nullptr, 10) : 256;
+	const size_t total = mib << 20;
+
+	printf("%-12s %3s %10s %10s %10s %12s\n",
+	       "layout", "ch", "reference", "scalar", "Pack()", "x DSD512");
+
+	for (const auto &l : layouts) {
+		DsdPack::Options options;
+		options.shift8 = l.shift8;
+		options.pack24 = l.pack24;
+		options.reverse_endian = l.reverse_endian;
+
+		DsdPack pack;
+		pack.Open(l.format, l.channels, options);
+
+		const size_t n_blocks = CHUNK_SIZE / pack.GetInputBlockSize();
+
+		std::vector<uint8_t> src(n_blocks * pack.GetInputBlockSize());
+		for (auto &i : src)
+			i = uint8_t(random());
+
+		std::vector<uint32_t> scratch(4 * n_blocks * l.channels);
+		std::vector<uint8_t> dest(n_blocks * pack.GetOutputBlockSize());
+
+		const double reference = Measure(total, [&]{
+			ReferenceDsdPack(l.format, l.channels, options,
+					 src.data(), n_blocks,
+					 scratch.data(), dest.data());
+		});
+
+		const double scalar = Measure(total, [&]{
+			pack.PackScalar(dest.data(), src.data(), n_blocks);
+		});
+
+		const double vector = Measure(total, [&]{
+			pack.Pack(dest.data(), src.data(), n_blocks);
+		});
+
+		/* throughput in MiB of DSD input per second, and how
+		   many times the real-time DSD512 rate that is */
+		const double mib_d = double(mib);
+		printf("%-12s %3u %10.0f %10.0f %10.0f %12.0f%s\n",
+		       l.name, l.channels,
+		       mib_d / reference, mib_d / scalar, mib_d / vector,
+		       double(total) / vector / (DSD512_RATE * l.channels),
+		       pack.IsVectorized() ? "" : " (not vectorized)");
+	}
+
+	printf("(MiB/s of DSD input)\n");
+
+	return EXIT_SUCCESS;
+}
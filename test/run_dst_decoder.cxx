@@ -0,0 +1,243 @@
+/*
+ * Copyright 2003-2022 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Benchmark for the DST decoder of the SACD plugins.  Without
+ * arguments, it times the FIR prediction kernels on random filter
+ * tables.  Given a DST compressed DSDIFF file, it decodes all of its
+ * frames with each kernel and reports frames per second.
+ */
+
+#include "decoder.h"
+#include "fir.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <random>
+#include <vector>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void
+log_printf(const char *fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+}
+
+struct Kernel {
+	const char *name;
+	dst::run_filters_t run_filters;
+};
+
+static std::vector<Kernel>
+GetKernels()
+{
+	std::vector<Kernel> kernels{{"scalar", dst::run_filters_scalar}};
+	if (dst::get_run_filters() != dst::run_filters_scalar)
+		kernels.push_back({"simd", dst::get_run_filters()});
+	return kernels;
+}
+
+static double
+Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int
+BenchKernels()
+{
+	constexpr unsigned channels = 6;
+	constexpr unsigned bits = 1 << 20;
+
+	std::mt19937 rng(42);
+	std::vector<dst::fir_table_t> tables(2 * channels + 1);
+	for (auto &table : tables)
+		for (auto &row : table)
+			for (auto &value : row)
+				value = (int16_t)(rng() & 0x7ff) - 0x400;
+
+	std::vector<const dst::fir_table_t *> filters(channels);
+	for (unsigned i = 0; i < channels; i++)
+		filters[i] = &tables[rng() % (2 * channels)];
+
+	bool first = true;
+	uint32_t reference = 0;
+	for (const auto &kernel : GetKernels()) {
+		std::vector<dst::fir_status_t> status(channels);
+		for (auto &s : status)
+			s.fill(0xaa);
+
+		int16_t predict[channels];
+		uint32_t checksum = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (unsigned bit = 0; bit < bits; bit++) {
+			kernel.run_filters(filters.data(), status.data(),
+					   channels, predict);
+			for (unsigned i = 0; i < channels; i++) {
+				checksum = checksum * 31 + (uint16_t)predict[i];
+
+				/* feed the sign back like the decoder does */
+				auto *st = reinterpret_cast<uint64_t *>(status[i].data());
+				st[1] = (st[1] << 1) | (st[0] >> 63);
+				st[0] = (st[0] << 1) | (((uint16_t)predict[i] >> 15) ^ (bit & 1));
+			}
+		}
+		const double s = Seconds(start);
+
+		if (first)
+			reference = checksum;
+		first = false;
+
+		printf("%-8s %8.1f M predictions/s%s\n", kernel.name,
+		       bits * channels / s / 1e6,
+		       checksum == reference ? "" : "  MISMATCH");
+		if (checksum != reference)
+			return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static uint64_t
+ReadBE(const uint8_t *p, unsigned n)
+{
+	uint64_t value = 0;
+	for (unsigned i = 0; i < n; i++)
+		value = (value << 8) | p[i];
+	return value;
+}
+
+struct DstFile {
+	unsigned channels = 0;
+	unsigned samplerate = 0;
+	unsigned framerate = 75;
+	std::vector<std::pair<const uint8_t *, size_t>> frames;
+};
+
+/**
+ * Collect the DST frames of a DSDIFF file (FRM8/DSD, PROP/SND with FS
+ * and CHNL, DST with DSTF chunks).
+ */
+static void
+ParseChunks(const uint8_t *p, const uint8_t *end, DstFile &file)
+{
+	while (end - p >= 12) {
+		const uint8_t *id = p;
+		const uint64_t size = ReadBE(p + 4, 8);
+		const uint8_t *data = p + 12;
+		if (size > uint64_t(end - data))
+			break;
+
+		if (memcmp(id, "FRM8", 4) == 0 || memcmp(id, "PROP", 4) == 0)
+			ParseChunks(data + 4, data + size, file);
+		else if (memcmp(id, "DST ", 4) == 0)
+			ParseChunks(data, data + size, file);
+		else if (memcmp(id, "FS  ", 4) == 0 && size >= 4)
+			file.samplerate = ReadBE(data, 4);
+		else if (memcmp(id, "CHNL", 4) == 0 && size >= 2)
+			file.channels = ReadBE(data, 2);
+		else if (memcmp(id, "FRTE", 4) == 0 && size >= 6)
+			file.framerate = ReadBE(data + 4, 2);
+		else if (memcmp(id, "DSTF", 4) == 0)
+			file.frames.emplace_back(data, size);
+
+		p = data + size + (size & 1);
+	}
+}
+
+static int
+BenchFile(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	if (f == nullptr) {
+		perror(path);
+		return EXIT_FAILURE;
+	}
+
+	std::vector<uint8_t> buffer;
+	uint8_t block[65536];
+	size_t nbytes;
+	while ((nbytes = fread(block, 1, sizeof(block), f)) > 0)
+		buffer.insert(buffer.end(), block, block + nbytes);
+	fclose(f);
+
+	DstFile file;
+	ParseChunks(buffer.data(), buffer.data() + buffer.size(), file);
+	if (file.channels == 0 || file.samplerate == 0 ||
+	    file.framerate == 0 || file.frames.empty()) {
+		fprintf(stderr, "%s: no DST frames found\n", path);
+		return EXIT_FAILURE;
+	}
+
+	const unsigned channel_frame_size = file.samplerate / 8 / file.framerate;
+	printf("%zu frames, %u channels, %u Hz\n",
+	       file.frames.size(), file.channels, file.samplerate);
+
+	std::vector<uint8_t> reference;
+	for (const auto &kernel : GetKernels()) {
+		dst::decoder_t decoder;
+		decoder.init(file.channels, channel_frame_size);
+		decoder.RunFilters = kernel.run_filters;
+
+		std::vector<uint8_t> output(file.frames.size() * file.channels * channel_frame_size);
+		unsigned errors = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < file.frames.size(); i++) {
+			const auto &frame = file.frames[i];
+			if (decoder.decode(frame.first, frame.second * 8,
+					   output.data() + i * file.channels * channel_frame_size) != 0)
+				++errors;
+		}
+		const double s = Seconds(start);
+
+		if (reference.empty())
+			reference = output;
+
+		printf("%-8s %8.1f frames/s (%.1fx realtime), %u errors%s\n",
+		       kernel.name, file.frames.size() / s,
+		       file.frames.size() / s / file.framerate, errors,
+		       output == reference ? "" : "  MISMATCH");
+		if (output != reference)
+			return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 2) {
+		fprintf(stderr, "Usage: run_dst_decoder [FILE.dff]\n");
+		return EXIT_FAILURE;
+	}
+
+	if (argc == 2)
+		return BenchFile(argv[1]);
+
+	return BenchKernels();
+}
@@ -0,0 +1,299 @@
+/*
+ * Copyright 2003-2022 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Benchmark for the MLP decoder of the DVD-Audio plugin.  Without
+ * arguments, it times the channel filter and rematrix kernels on
+ * random substreams.  Given a captured MLP stream (either raw or
+ * still multiplexed in AOB blocks), it decodes all of its access
+ * units with each kernel set and reports access units per second.
+ */
+
+#include "audio_stream.h"
+#include "dvda_block.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Kernel {
+	const char *name;
+	int cpu_flags;
+};
+
+static std::vector<Kernel>
+GetKernels()
+{
+	std::vector<Kernel> kernels{{"scalar", 0}};
+	av_force_cpu_flags(-1);
+	const int cpu_flags = av_get_cpu_flags();
+	if (cpu_flags != 0)
+		kernels.push_back({"simd", cpu_flags});
+	return kernels;
+}
+
+static double
+Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Filter the channels of a block like the decoder does when there is
+ * no multichannel kernel.
+ */
+static void
+FilterChannels(const DSPContext &dsp, ChannelParams *params,
+	       const int32_t *mask, unsigned channels,
+	       int32_t (*sample_buffer)[MAX_CHANNELS_ALL])
+{
+	if (dsp.mlp_filter_channels != nullptr) {
+		dsp.mlp_filter_channels(params, mask, channels, MAX_BLOCKSIZE,
+					sample_buffer[0]);
+		return;
+	}
+
+	for (unsigned ch = 0; ch < channels; ch++) {
+		FilterParams *fir = &params[ch].filter_params[FIR];
+		FilterParams *iir = &params[ch].filter_params[IIR];
+		int32_t state_buffer[NUM_FILTERS][MAX_BLOCKSIZE + MAX_FIR_ORDER];
+		int32_t *firbuf = state_buffer[FIR] + MAX_BLOCKSIZE;
+		int32_t *iirbuf = state_buffer[IIR] + MAX_BLOCKSIZE;
+
+		memcpy(firbuf, fir->state, MAX_FIR_ORDER * sizeof(int32_t));
+		memcpy(iirbuf, iir->state, MAX_IIR_ORDER * sizeof(int32_t));
+
+		dsp.mlp_filter_channel(firbuf, params[ch].coeff[FIR],
+				       fir->order, iir->order, fir->shift,
+				       mask[ch], MAX_BLOCKSIZE,
+				       &sample_buffer[0][ch]);
+
+		memcpy(fir->state, firbuf - MAX_BLOCKSIZE, MAX_FIR_ORDER * sizeof(int32_t));
+		memcpy(iir->state, iirbuf - MAX_BLOCKSIZE, MAX_IIR_ORDER * sizeof(int32_t));
+	}
+}
+
+static int
+BenchKernels()
+{
+	constexpr unsigned channels = 6;
+	constexpr unsigned blocks = 20000;
+	constexpr unsigned residual_blocks = 16;
+
+	std::mt19937 rng(42);
+
+	ChannelParams initial_params[channels];
+	int32_t mask[channels];
+	memset(initial_params, 0, sizeof(initial_params));
+	for (unsigned ch = 0; ch < channels; ch++) {
+		auto &p = initial_params[ch];
+		p.filter_params[FIR].order = rng() % (MAX_FIR_ORDER + 1);
+		p.filter_params[IIR].order = rng() % (MAX_IIR_ORDER + 1);
+		p.filter_params[FIR].shift = rng() % 16;
+		for (auto &filter : p.coeff)
+			for (auto &value : filter)
+				value = (int32_t)(rng() & 0xffff) - 0x8000;
+		mask[ch] = (int32_t)(~0u << (rng() % 8));
+	}
+
+	std::vector<int32_t> residuals(residual_blocks * MAX_BLOCKSIZE * MAX_CHANNELS_ALL);
+	for (auto &value : residuals)
+		value = (int32_t)(rng() & 0xffffff) - 0x800000;
+
+	int32_t matrix_coeffs[MAX_MATRICES][MAX_CHANNELS_ALL];
+	for (auto &row : matrix_coeffs)
+		for (auto &value : row)
+			value = (int32_t)(rng() & 0x3ffff) - 0x20000;
+
+	int8_t bypassed_lsbs[MAX_BLOCKSIZE][MAX_CHANNELS_ALL];
+	for (auto &row : bypassed_lsbs)
+		for (auto &value : row)
+			value = rng() & 1;
+
+	int8_t noise_buffer[MAX_BLOCKSIZE_POW2];
+	for (auto &value : noise_buffer)
+		value = (int8_t)rng();
+
+	bool first = true;
+	uint32_t reference = 0;
+	for (const auto &kernel : GetKernels()) {
+		av_force_cpu_flags(kernel.cpu_flags);
+		DSPContext dsp;
+		dsputil_init(&dsp, nullptr);
+
+		ChannelParams params[channels];
+		memcpy(params, initial_params, sizeof(params));
+
+		int32_t sample_buffer[MAX_BLOCKSIZE][MAX_CHANNELS_ALL];
+		uint32_t checksum = 0;
+		double filter_seconds = 0, rematrix_seconds = 0;
+		for (unsigned block = 0; block < blocks; block++) {
+			memcpy(sample_buffer,
+			       &residuals[(block % residual_blocks) * MAX_BLOCKSIZE * MAX_CHANNELS_ALL],
+			       sizeof(sample_buffer));
+
+			auto start = std::chrono::steady_clock::now();
+			FilterChannels(dsp, params, mask, channels, sample_buffer);
+			filter_seconds += Seconds(start);
+
+			start = std::chrono::steady_clock::now();
+			for (unsigned mat = 0; mat < channels; mat++)
+				dsp.mlp_rematrix_channel(sample_buffer[0], matrix_coeffs[mat],
+							 &bypassed_lsbs[0][mat], noise_buffer,
+							 channels - mat, mat, MAX_BLOCKSIZE,
+							 channels - 1, mat & 1 ? 0 : mat + 1,
+							 MAX_BLOCKSIZE_POW2, mask[mat]);
+			rematrix_seconds += Seconds(start);
+
+			for (const auto &row : sample_buffer)
+				for (unsigned ch = 0; ch < channels; ch++)
+					checksum = checksum * 31 + (uint32_t)row[ch];
+		}
+
+		if (first)
+			reference = checksum;
+		first = false;
+
+		const double samples = double(blocks) * MAX_BLOCKSIZE * channels;
+		printf("%-8s filter %8.1f M samples/s, rematrix %8.1f M samples/s%s\n",
+		       kernel.name, samples / filter_seconds / 1e6,
+		       samples / rematrix_seconds / 1e6,
+		       checksum == reference ? "" : "  MISMATCH");
+		if (checksum != reference)
+			return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Load a file, extracting the audio substream if it is a capture of
+ * AOB blocks (starting with an MPEG pack header).
+ */
+static bool
+LoadStream(const char *path, std::vector<uint8_t> &stream)
+{
+	FILE *f = fopen(path, "rb");
+	if (f == nullptr) {
+		perror(path);
+		return false;
+	}
+
+	uint8_t block[65536];
+	size_t nbytes;
+	while ((nbytes = fread(block, 1, sizeof(block), f)) > 0)
+		stream.insert(stream.end(), block, block + nbytes);
+	fclose(f);
+
+	static constexpr uint8_t pack_start[] = {0x00, 0x00, 0x01, 0xba};
+	if (stream.size() >= DVD_BLOCK_SIZE &&
+	    memcmp(stream.data(), pack_start, sizeof(pack_start)) == 0) {
+		int ps1_size = 0;
+		sub_header_t ps1_info;
+		dvda_block_t::get_ps1(stream.data(), stream.size() / DVD_BLOCK_SIZE,
+				      stream.data(), &ps1_size, &ps1_info);
+		stream.resize(ps1_size);
+	}
+
+	return true;
+}
+
+static int
+BenchFile(const char *path)
+{
+	std::vector<uint8_t> stream;
+	if (!LoadStream(path, stream))
+		return EXIT_FAILURE;
+
+	std::vector<uint8_t> output(1 << 16);
+	bool first = true;
+	uint32_t reference = 0;
+	for (const auto &kernel : GetKernels()) {
+		av_force_cpu_flags(kernel.cpu_flags);
+
+		mlp_audio_stream_t decoder;
+		int position = decoder.resync(stream.data(), stream.size());
+		if (position < 0 ||
+		    decoder.init(stream.data() + position, stream.size() - position, false) < 0) {
+			fprintf(stderr, "%s: no MLP stream found\n", path);
+			return EXIT_FAILURE;
+		}
+
+		unsigned access_units = 0, errors = 0;
+		uint32_t checksum = 0;
+		const auto start = std::chrono::steady_clock::now();
+		while ((size_t)position < stream.size()) {
+			int data_size = output.size();
+			const int bytes_decoded = decoder.decode(output.data(), &data_size,
+								 stream.data() + position,
+								 stream.size() - position);
+			if (bytes_decoded <= 0) {
+				/* skip to the next major sync */
+				++errors;
+				const int major_sync = decoder.resync(stream.data() + position + 1,
+								      stream.size() - position - 1);
+				if (major_sync < 0)
+					break;
+				position += 1 + major_sync;
+				continue;
+			}
+
+			position += bytes_decoded;
+			++access_units;
+			for (int i = 0; i < data_size; i++)
+				checksum = checksum * 31 + output[i];
+		}
+		const double s = Seconds(start);
+
+		if (first) {
+			reference = checksum;
+			printf("%zu bytes, %d+%d channels, %d Hz\n", stream.size(),
+			       decoder.group1_channels, decoder.group2_channels,
+			       decoder.group1_samplerate);
+		}
+		first = false;
+
+		printf("%-8s %10.1f access units/s, %u access units, %u errors%s\n",
+		       kernel.name, access_units / s, access_units, errors,
+		       checksum == reference ? "" : "  MISMATCH");
+		if (checksum != reference)
+			return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 2) {
+		fprintf(stderr, "Usage: run_mlp_decoder [FILE.mlp|FILE.aob]\n");
+		return EXIT_FAILURE;
+	}
+
+	if (argc == 2)
+		return BenchFile(argv[1]);
+
+	return BenchKernels();
+}
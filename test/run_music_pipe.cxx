@@ -0,0 +1,135 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures how many chunks per second can pass through
+ * #MusicBuffer and #MusicPipe with one producer (decoder), one
+ * consumer (player) and a varying number of threads walking the pipe
+ * (outputs), all of them busy-polling to maximize contention.
+ *
+ */
+
+#include "MusicBuffer.hxx"
+#include "MusicChunk.hxx"
+#include "MusicPipe.hxx"
+#include "pcm/AudioFormat.hxx"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr AudioFormat audio_format{44100, SampleFormat::S16, 2};
+
+static double
+Run(unsigned n_outputs, unsigned n_chunks)
+{
+	MusicBuffer buffer(1024);
+	MusicPipe pipe;
+
+	/* for each output: the number of chunks it has moved past */
+	std::vector<std::atomic_uint> positions(n_outputs);
+	for (auto &i : positions)
+		i.store(0);
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::thread producer([&]{
+		for (unsigned seq = 0; seq < n_chunks; ++seq) {
+			MusicChunkPtr chunk;
+			while ((chunk = buffer.Allocate()) == nullptr)
+				std::this_thread::yield();
+
+			auto w = chunk->Write(audio_format, SongTime::zero(), 0);
+			*(unsigned *)w.data = seq;
+			chunk->Expand(audio_format, w.size);
+			pipe.Push(std::move(chunk));
+		}
+	});
+
+	std::vector<std::thread> outputs;
+	for (auto &position : positions) {
+		outputs.emplace_back([&]{
+			const MusicChunk *chunk = nullptr;
+			for (unsigned seq = 0; seq < n_chunks;) {
+				const MusicChunk *next = chunk == nullptr
+					? pipe.Peek()
+					: chunk->GetNext();
+				if (next == nullptr) {
+					std::this_thread::yield();
+					continue;
+				}
+
+				chunk = next;
+				position.store(seq++, std::memory_order_release);
+			}
+
+			position.store(n_chunks, std::memory_order_release);
+		});
+	}
+
+	for (unsigned shifted = 0; shifted < n_chunks;) {
+		const MusicChunk *chunk = pipe.Peek();
+		if (chunk == nullptr) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		const unsigned seq = *(const unsigned *)chunk->data;
+
+		bool consumed = true;
+		for (const auto &i : positions)
+			if (i.load(std::memory_order_acquire) <= seq)
+				consumed = false;
+
+		if (!consumed) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		pipe.Shift();
+		++shifted;
+	}
+
+	producer.join();
+	for (auto &i : outputs)
+		i.join();
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int
+main(int argc, char **argv)
+{
+	const unsigned n_chunks = argc > 1
+		? strtoul(argv[1], nullptr, 10)
+		: 200000;
+
+	printf("%8s %14s\n", "outputs", "chunks/s");
+
+	for (unsigned n_outputs : {1, 2, 4, 8, 16}) {
+		const double duration = Run(n_outputs, n_chunks);
+		printf("%8u %14.0f\n", n_outputs, n_chunks / duration);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the throughput of the tag pool with a
+ * varying number of threads, each of them interning, duplicating and
+ * releasing tag values like the database loader and the update
+ * threads do.  For comparison, it repeats each run with all pool
+ * calls serialized by one global mutex, which is how the pool was
+ * locked before it was sharded.
+ */
+
+#include "tag/Pool.hxx"
+#include "tag/Item.hxx"
+#include "thread/Mutex.hxx"
+#include "util/StringView.hxx"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr TagType tag_types[] = {
+	TAG_ARTIST, TAG_ALBUM, TAG_TITLE, TAG_GENRE,
+};
+
+struct NoLock {
+	void lock() noexcept {}
+	void unlock() noexcept {}
+};
+
+template<typename L>
+static void
+RunThread(const std::vector<std::string> &values, unsigned seed,
+	  unsigned n_ops, L &lock) noexcept
+{
+	/* a small linear congruential generator, so each thread walks
+	   the values in a different order */
+	unsigned x = seed;
+
+	for (unsigned i = 0; i < n_ops; ++i) {
+		x = x * 1103515245 + 12345;
+		const auto &value = values[(x >> 8) % values.size()];
+		const TagType type = tag_types[x >> 30];
+
+		TagItem *item, *copy;
+
+		{
+			const std::scoped_lock<L> protect(lock);
+			item = tag_pool_get_item(type, StringView(value.data(),
+								  value.size()));
+		}
+
+		{
+			const std::scoped_lock<L> protect(lock);
+			copy = tag_pool_dup_item(item);
+		}
+
+		{
+			const std::scoped_lock<L> protect(lock);
+			tag_pool_put_item(copy);
+			tag_pool_put_item(item);
+		}
+	}
+}
+
+template<typename L>
+static double
+Run(const std::vector<std::string> &values, unsigned n_threads,
+    unsigned n_ops, L &lock)
+{
+	/* a long-lived reference to every other value, like the songs in
+	   the database, so most operations only touch reference
+	   counters */
+	std::vector<TagItem *> keep;
+	for (unsigned i = 0; i < values.size(); i += 2)
+		for (const auto type : tag_types)
+			keep.push_back(tag_pool_get_item(type,
+							 StringView(values[i].data(),
+								    values[i].size())));
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (unsigned i = 0; i < n_threads; ++i)
+		threads.emplace_back([&, i]{
+			RunThread(values, i * 7919 + 1, n_ops / n_threads, lock);
+		});
+
+	for (auto &i : threads)
+		i.join();
+
+	const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (auto *i : keep)
+		tag_pool_put_item(i);
+
+	return duration;
+}
+
+int
+main(int argc, char **argv)
+{
+	const unsigned n_ops = argc > 1
+		? strtoul(argv[1], nullptr, 10)
+		: 4000000;
+
+	std::vector<std::string> values;
+	for (unsigned i = 0; i < 20000; ++i)
+		values.emplace_back("Value " + std::to_string(i));
+
+	printf("%8s %14s %14s\n", "threads", "global ops/s", "sharded ops/s");
+
+	for (unsigned n_threads : {1, 4, 16}) {
+		Mutex global;
+		const double global_duration =
+			Run(values, n_threads, n_ops, global);
+
+		NoLock no_lock;
+		const double sharded_duration =
+			Run(values, n_threads, n_ops, no_lock);
+
+		printf("%8u %14.0f %14.0f\n", n_threads,
+		       n_ops / global_duration, n_ops / sharded_duration);
+	}
+
+	return EXIT_SUCCESS;
+}
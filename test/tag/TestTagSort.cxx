@@ -0,0 +1,100 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "../MakeTag.hxx"
+#include "tag/Sort.hxx"
+
+#include <gtest/gtest.h>
+
+TEST(TagSort, String)
+{
+	const auto a = MakeTag(TAG_ARTIST, "Abba");
+	const auto b = MakeTag(TAG_ARTIST, "Beatles");
+
+	EXPECT_LT(TagSortKey(TAG_ARTIST, a), TagSortKey(TAG_ARTIST, b));
+	EXPECT_FALSE(TagSortKey(TAG_ARTIST, b) < TagSortKey(TAG_ARTIST, a));
+	EXPECT_FALSE(TagSortKey(TAG_ARTIST, a) < TagSortKey(TAG_ARTIST, a));
+
+	EXPECT_TRUE(CompareTags(TAG_ARTIST, false, a, b));
+	EXPECT_FALSE(CompareTags(TAG_ARTIST, false, b, a));
+	EXPECT_TRUE(CompareTags(TAG_ARTIST, true, b, a));
+	EXPECT_FALSE(CompareTags(TAG_ARTIST, true, a, b));
+}
+
+TEST(TagSort, Numeric)
+{
+	const auto two = MakeTag(TAG_TRACK, "2");
+	const auto ten = MakeTag(TAG_TRACK, "10");
+	const auto ten_of = MakeTag(TAG_TRACK, "10/12");
+
+	/* "10" < "2" as strings, but not as numbers */
+	EXPECT_LT(TagSortKey(TAG_TRACK, two), TagSortKey(TAG_TRACK, ten));
+	EXPECT_FALSE(TagSortKey(TAG_TRACK, ten) < TagSortKey(TAG_TRACK, two));
+
+	/* only the leading number counts */
+	EXPECT_EQ(TagSortKey(TAG_TRACK, ten_of).number, 10);
+	EXPECT_FALSE(TagSortKey(TAG_TRACK, ten) < TagSortKey(TAG_TRACK, ten_of));
+	EXPECT_FALSE(TagSortKey(TAG_TRACK, ten_of) < TagSortKey(TAG_TRACK, ten));
+
+	const auto disc1 = MakeTag(TAG_DISC, "9");
+	const auto disc2 = MakeTag(TAG_DISC, "11");
+	EXPECT_LT(TagSortKey(TAG_DISC, disc1), TagSortKey(TAG_DISC, disc2));
+
+	/* other tags are compared as strings */
+	const auto date1 = MakeTag(TAG_DATE, "10");
+	const auto date2 = MakeTag(TAG_DATE, "9");
+	EXPECT_LT(TagSortKey(TAG_DATE, date1), TagSortKey(TAG_DATE, date2));
+}
+
+TEST(TagSort, Fallback)
+{
+	const auto artist = MakeTag(TAG_ARTIST, "Beatles");
+	const auto album_artist = MakeTag(TAG_ARTIST, "Zappa",
+					  TAG_ALBUM_ARTIST, "Abba");
+
+	EXPECT_STREQ(TagSortKey(TAG_ALBUM_ARTIST, artist).value, "Beatles");
+	EXPECT_STREQ(TagSortKey(TAG_ALBUM_ARTIST, album_artist).value, "Abba");
+	EXPECT_LT(TagSortKey(TAG_ALBUM_ARTIST, album_artist),
+		  TagSortKey(TAG_ALBUM_ARTIST, artist));
+
+	const auto artist_sort = MakeTag(TAG_ARTIST, "The Beatles",
+					 TAG_ARTIST_SORT, "Beatles, The");
+	EXPECT_STREQ(TagSortKey(TAG_ARTIST_SORT, artist_sort).value,
+		     "Beatles, The");
+	EXPECT_STREQ(TagSortKey(TAG_ARTIST_SORT, artist).value, "Beatles");
+}
+
+TEST(TagSort, Missing)
+{
+	const auto empty = MakeTag();
+	const auto artist = MakeTag(TAG_ARTIST, "Abba");
+	const auto track = MakeTag(TAG_TRACK, "1");
+
+	/* a missing tag sorts like an empty one, i.e. first */
+	EXPECT_STREQ(TagSortKey(TAG_ARTIST, empty).value, "");
+	EXPECT_LT(TagSortKey(TAG_ARTIST, empty), TagSortKey(TAG_ARTIST, artist));
+	EXPECT_FALSE(TagSortKey(TAG_ARTIST, empty) < TagSortKey(TAG_ARTIST, empty));
+
+	EXPECT_EQ(TagSortKey(TAG_TRACK, empty).number, 0);
+	EXPECT_LT(TagSortKey(TAG_TRACK, empty), TagSortKey(TAG_TRACK, track));
+
+	/* the default key equals the key of a missing tag */
+	EXPECT_FALSE(TagSortKey() < TagSortKey(TAG_ARTIST, empty));
+	EXPECT_FALSE(TagSortKey(TAG_ARTIST, empty) < TagSortKey());
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "test_pcm_util.hxx"
+#include "DsdPackReference.hxx"
+#include "pcm/DsdPack.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+static void
+TestDsdPack(DsdPack::Format format, DsdPack::Options options)
+{
+	constexpr size_t MAX_BLOCKS = 67;
+	const auto src = TestDataBuffer<uint8_t, MAX_BLOCKS * 4 * MAX_CHANNELS>();
+
+	for (unsigned channels = 1; channels <= MAX_CHANNELS; ++channels) {
+		DsdPack pack;
+		pack.Open(format, channels, options);
+
+		/* odd block counts exercise the scalar tail of the
+		   vectorized kernels */
+		for (size_t n_blocks = 0; n_blocks <= MAX_BLOCKS; ++n_blocks) {
+			std::vector<uint32_t> scratch(4 * n_blocks * channels);
+			std::vector<uint8_t> expected(n_blocks * pack.GetOutputBlockSize());
+			ReferenceDsdPack(format, channels, options,
+					 src.begin(), n_blocks,
+					 scratch.data(), expected.data());
+
+			std::vector<uint8_t> dest(expected.size() + 1, 0xaa);
+
+			pack.PackScalar(dest.data(), src.begin(), n_blocks);
+			EXPECT_EQ(memcmp(dest.data(), expected.data(),
+					 expected.size()), 0)
+				<< "scalar channels=" << channels
+				<< " blocks=" << n_blocks;
+
+			std::fill(dest.begin(), dest.end(), 0xaa);
+			pack.Pack(dest.data(), src.begin(), n_blocks);
+			EXPECT_EQ(memcmp(dest.data(), expected.data(),
+					 expected.size()), 0)
+				<< "channels=" << channels
+				<< " blocks=" << n_blocks;
+
+			/* must not write beyond the end */
+			EXPECT_EQ(dest.back(), 0xaa);
+		}
+	}
+}
+
+TEST(PcmTest, DsdPackU16)
+{
+	DsdPack::Options options;
+	TestDsdPack(DsdPack::Format::U16, options);
+
+	options.reverse_endian = true;
+	TestDsdPack(DsdPack::Format::U16, options);
+}
+
+TEST(PcmTest, DsdPackU32)
+{
+	DsdPack::Options options;
+	TestDsdPack(DsdPack::Format::U32, options);
+
+	options.reverse_endian = true;
+	TestDsdPack(DsdPack::Format::U32, options);
+}
+
+TEST(PcmTest, DsdPackDop)
+{
+	for (unsigned i = 0; i < 6; ++i) {
+		DsdPack::Options options;
+		options.shift8 = i % 3 == 1;
+		options.pack24 = i % 3 == 2;
+		options.reverse_endian = i >= 3;
+		TestDsdPack(DsdPack::Format::DOP, options);
+	}
+}
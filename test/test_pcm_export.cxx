@@ -357,6 +357,50 @@ TEST(PcmTest, ExportDop)
 			 sizeof(expected_silence)), 0);
 }
 
+TEST(PcmTest, ExportDopPack24ReverseEndian)
+{
+	static constexpr uint8_t src[] = {
+		0x01, 0x23, 0x45, 0x67,
+		0x89, 0xab, 0xcd, 0xef,
+	};
+
+	/* packed big endian 24 bit samples, i.e. S24_3BE */
+	static constexpr uint8_t expected[] = {
+		0x05, 0x01, 0x45,
+		0x05, 0x23, 0x67,
+		0xfa, 0x89, 0xcd,
+		0xfa, 0xab, 0xef,
+	};
+
+	PcmExport::Params params;
+	params.dsd_mode = PcmExport::DsdMode::DOP;
+	params.pack24 = true;
+	params.reverse_endian = true;
+
+	PcmExport e;
+	e.Open(SampleFormat::DSD, 2, params);
+
+	EXPECT_EQ(e.GetInputFrameSize(), 2u);
+	EXPECT_EQ(e.GetOutputFrameSize(), 6u);
+	EXPECT_EQ(e.GetInputBlockSize(), 8u);
+	EXPECT_EQ(e.GetOutputBlockSize(), 12u);
+
+	auto dest = e.Export({src, sizeof(src)});
+	EXPECT_EQ(sizeof(expected), dest.size);
+	EXPECT_TRUE(memcmp(dest.data, expected, dest.size) == 0);
+
+	EXPECT_EQ(e.CalcInputSize(dest.size), sizeof(src));
+
+	const auto silence = e.GetSilence();
+	constexpr uint8_t expected_silence[]{
+		0x05, 0x69, 0x69, 0x05, 0x69, 0x69,
+		0xfa, 0x69, 0x69, 0xfa, 0x69, 0x69,
+	};
+	EXPECT_EQ(silence.size, sizeof(expected_silence));
+	EXPECT_EQ(memcmp(silence.data, expected_silence,
+			 sizeof(expected_silence)), 0);
+}
+
 #endif
 
 template<SampleFormat F, class Traits=SampleTraits<F>>
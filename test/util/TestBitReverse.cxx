@@ -0,0 +1,45 @@
+/*
+ * Unit tests for src/util/
+ */
+
+#include "util/BitReverse.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+TEST(BitReverse, Table)
+{
+	EXPECT_EQ(bit_reverse(0x00), 0x00);
+	EXPECT_EQ(bit_reverse(0x01), 0x80);
+	EXPECT_EQ(bit_reverse(0x0f), 0xf0);
+	EXPECT_EQ(bit_reverse(0x12), 0x48);
+	EXPECT_EQ(bit_reverse(0xff), 0xff);
+}
+
+TEST(BitReverse, Buffer)
+{
+	uint8_t src[256 + 64];
+	for (unsigned i = 0; i < sizeof(src); ++i)
+		src[i] = uint8_t(i * 37 + 11);
+
+	/* all offsets and sizes around the vector width */
+	for (unsigned offset = 0; offset < 16; ++offset) {
+		for (unsigned size = 0; size <= 256 + 33; ++size) {
+			uint8_t a[sizeof(src) + 16], b[sizeof(src) + 16];
+			memcpy(a, src, sizeof(src));
+			memcpy(b, src, sizeof(src));
+
+			BitReverse(a + offset, size);
+			BitReverseScalar(b + offset, size);
+
+			for (unsigned i = 0; i < sizeof(src); ++i)
+				ASSERT_EQ(b[i], i >= offset && i < offset + size
+					  ? bit_reverse(src[i])
+					  : src[i]);
+
+			ASSERT_EQ(memcmp(a, b, sizeof(src)), 0)
+				<< "offset=" << offset << " size=" << size;
+		}
+	}
+}